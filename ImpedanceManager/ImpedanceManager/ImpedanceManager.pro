@@ -9,6 +9,8 @@ QT       += concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets printsupport
 CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
+# per byte/frame/sample debug output (qCDebugHot), qmake "CONFIG+=hotlog"
+hotlog:DEFINES += IM_HOT_LOG
 
 RC_FILE = app.rc
 TARGET = ImpedanceManager
@@ -29,7 +31,39 @@ SOURCES += main.cpp\
     caboutdialog.cpp \
     ccaproject.cpp \
     cdpvproject.cpp \
-    cprojectmanager.cpp
+    cprojectmanager.cpp \
+    cframedecoder.cpp \
+    csamplequeue.cpp \
+    ccrc16.cpp \
+    ccircuitmodel.cpp \
+    ccircuitfitter.cpp \
+    clivecircuitfit.cpp \
+    clinalg.cpp \
+    ckramerskronig.cpp \
+    cdrt.cpp \
+    cdrtdialog.cpp \
+    ccvsegmenter.cpp \
+    csignalfilter.cpp \
+    cdpvanalysis.cpp \
+    ccaanalysis.cpp \
+    clodpyramid.cpp \
+    cswvproject.cpp \
+    cheadlessrunner.cpp \
+    csequencer.cpp \
+    csequencedialog.cpp \
+    cserialcapture.cpp \
+    cserialreplay.cpp \
+    chdrhistogram.cpp \
+    ctelemetry.cpp \
+    cdiagnosticsdialog.cpp \
+    clogging.cpp \
+    ccsvreader.cpp \
+    ccomparison.cpp \
+    ccomparedialog.cpp \
+    cbatchanalyzer.cpp \
+    cbatchdialog.cpp \
+    ceissweepplanner.cpp \
+    cmeasurelimits.cpp
 
 HEADERS  += mainwindow.h \
     qcustomplot.h \
@@ -46,7 +80,44 @@ HEADERS  += mainwindow.h \
     caboutdialog.h \
     ccaproject.h \
     cdpvproject.h \
-    cprojectmanager.h
+    cprojectmanager.h \
+    cframedecoder.h \
+    csamplequeue.h \
+    ccrc16.h \
+    ccircuitmodel.h \
+    ccircuitfitter.h \
+    clivecircuitfit.h \
+    clinalg.h \
+    ckramerskronig.h \
+    cdrt.h \
+    cdrtdialog.h \
+    ccvsegmenter.h \
+    csignalfilter.h \
+    cdpvanalysis.h \
+    ccaanalysis.h \
+    clodpyramid.h \
+    cswvproject.h \
+    cheadlessrunner.h \
+    csequencer.h \
+    csequencedialog.h \
+    cserialcapture.h \
+    cserialreplay.h \
+    chdrhistogram.h \
+    ctelemetry.h \
+    cdiagnosticsdialog.h \
+    clogging.h \
+    ccsvreader.h \
+    ccomparison.h \
+    ccomparedialog.h \
+    cbatchanalyzer.h \
+    cbatchdialog.h \
+    ceissweepplanner.h \
+    cmeasurelimits.h
+
+linux {
+    SOURCES += cposixserialreader.cpp
+    HEADERS += cposixserialreader.h
+}
 
 FORMS    += mainwindow.ui \
     csettingsdialog.ui \
@@ -21,6 +21,14 @@ namespace MeasureUtility
         float idFl;
         quint8 id8[sizeof(quint32)];
     } union32_t;
+
+    // one decoded measure chunk, values in the order of the frame fields
+    typedef struct
+    {
+        quint32 m_index;
+        float m_data[4];
+        qint64 m_received_ns;   // CTelemetry clock of its frame
+    } MeasSample_t;
 }
 
 #endif // MEASUREUTILITY_H
@@ -0,0 +1,268 @@
+#include "cbatchanalyzer.h"
+#include "ccircuitfitter.h"
+#include "ccvsegmenter.h"
+#include "cdpvanalysis.h"
+#include "ccaanalysis.h"
+
+#include <QtConcurrent>
+#include <QDirIterator>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include <cmath>
+
+const char* CBatchAnalyzer::m_defaultCircuit = "R0-p(R1,Q1)";
+
+QStringList CBatchAnalyzer::findFiles(const QString& directory, const bool recursive)
+{
+    QStringList files;
+    QDirIterator it(QDir(directory).absolutePath(), QStringList() << "*.csv", QDir::Files,
+                    recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+
+    while (it.hasNext())
+        files.append(it.next());
+
+    files.sort();
+    return files;
+}
+
+QString CBatchAnalyzer::measureName(const EMeasures_t& measure)
+{
+    switch (measure)
+    {
+        case EMeasures_t::eEIS: return "EIS";
+        case EMeasures_t::eCV:  return "CV";
+        case EMeasures_t::eCA:  return "CA";
+        case EMeasures_t::eDPV: return "DPV";
+        case EMeasures_t::eSWV: return "SWV";
+        default:                return "";
+    }
+}
+
+CBatchAnalyzer::Result_t CBatchAnalyzer::CAnalyze::operator()(const QString& fileName) const
+{
+    Result_t result;
+    CCsvReader::Table_t table;
+
+    result.m_fileName = fileName;
+    result.m_measure = EMeasures_t::eDummy;
+    result.m_points = 0;
+
+    if (CCsvReader::read(fileName, table))
+    {
+        result.m_status = "cannot read";
+        return result;
+    }
+
+    result.m_measure = CCsvReader::measureOf(table.m_header);
+    result.m_points = table.m_columns.isEmpty() ? 0 : table.m_columns.first().size();
+
+    switch (result.m_measure)
+    {
+        case EMeasures_t::eEIS:
+            analyzeEis(table, m_circuit, result);
+            break;
+
+        case EMeasures_t::eCV:
+            analyzeCv(table, result);
+            break;
+
+        case EMeasures_t::eDPV:
+            analyzePeaks(table.m_columns[0], table.m_columns[1], result);
+            break;
+
+        case EMeasures_t::eSWV:
+            analyzePeaks(table.m_columns[0], table.m_columns[3], result);
+            break;
+
+        case EMeasures_t::eCA:
+            analyzeCa(table, result);
+            break;
+
+        default:
+            result.m_status = "unknown header";
+            break;
+    }
+
+    return result;
+}
+
+void CBatchAnalyzer::analyzeEis(const CCsvReader::Table_t& table, const QString& circuit,
+                                Result_t& result)
+{
+    CCircuitModel model;
+    if (model.compile(circuit))
+    {
+        result.m_status = model.lastError();
+        return;
+    }
+
+    // the CSV holds -Im, as plotted
+    CCircuitFitter::EisData_t data;
+    for (int i = 0; i < result.m_points; i++)
+    {
+        data.m_omega.append(2 * M_PI * table.m_columns[2][i]);
+        data.m_re.append(table.m_columns[0][i]);
+        data.m_im.append(-table.m_columns[1][i]);
+    }
+
+    if (2 * result.m_points < model.parameterCount())
+    {
+        result.m_status = "too few points";
+        return;
+    }
+
+    // already a pool task, a nested map would block this thread and
+    // oversubscribe the pool; the files are the parallel part of a batch
+    CCircuitFitter::FitResult_t fit = CCircuitFitter::multiStartFit(model, data,
+                                                                    CCircuitFitter::m_defaultStarts,
+                                                                    false);
+    if (!fit.m_converged)
+        result.m_status = "fit not converged";
+
+    for (int p = 0; p < model.parameterCount(); p++)
+        result.m_metrics.append(qMakePair(model.parameterNames()[p], fit.m_params[p]));
+    result.m_metrics.append(qMakePair(QString("chi2"), fit.m_chiSquare));
+}
+
+void CBatchAnalyzer::analyzeCv(const CCsvReader::Table_t& table, Result_t& result)
+{
+    CCvSegmenter segmenter;
+    for (int i = 0; i < result.m_points; i++)
+        segmenter.addSample(table.m_columns[0][i], table.m_columns[1][i]);
+
+    result.m_metrics.append(qMakePair(QString("cycles"), (double)segmenter.cycleCount()));
+
+    // the last cycle with both peaks, the first ones are often not settled
+    for (int c = segmenter.cycleCount() - 1; c >= 0; c--)
+    {
+        const CCvSegmenter::Cycle_t& cycle = segmenter.cycles()[c];
+        if (!cycle.m_anodic.m_valid || !cycle.m_cathodic.m_valid)
+            continue;
+
+        result.m_metrics.append(qMakePair(QString("Epa[V]"), cycle.m_anodic.m_potential));
+        result.m_metrics.append(qMakePair(QString("ipa[A]"), cycle.m_anodic.m_current));
+        result.m_metrics.append(qMakePair(QString("Epc[V]"), cycle.m_cathodic.m_potential));
+        result.m_metrics.append(qMakePair(QString("ipc[A]"), cycle.m_cathodic.m_current));
+        result.m_metrics.append(qMakePair(QString("dEp[V]"), CCvSegmenter::peakSeparation(cycle)));
+        result.m_metrics.append(qMakePair(QString("ipa/ipc"), CCvSegmenter::peakRatio(cycle)));
+        return;
+    }
+
+    result.m_status = "no complete cycle";
+}
+
+void CBatchAnalyzer::analyzePeaks(const QVector<double>& x, const QVector<double>& y,
+                                  Result_t& result)
+{
+    CDpvAnalysis analysis;
+    CDpvAnalysis::Result_t peaks = analysis.analyze(x, y);
+
+    if (!peaks.m_valid)
+    {
+        result.m_status = "too few points";
+        return;
+    }
+
+    result.m_metrics.append(qMakePair(QString("peaks"), (double)peaks.m_peaks.size()));
+    result.m_metrics.append(qMakePair(QString("noise"), peaks.m_noise));
+
+    int largest = -1;
+    for (int i = 0; i < peaks.m_peaks.size(); i++)
+    {
+        if ((largest < 0) ||
+            (std::fabs(peaks.m_peaks[i].m_height) > std::fabs(peaks.m_peaks[largest].m_height)))
+            largest = i;
+    }
+
+    if (largest < 0)
+        return;
+
+    const CDpvAnalysis::Peak_t& peak = peaks.m_peaks[largest];
+    result.m_metrics.append(qMakePair(QString("Ep[mV]"), peak.m_potential));
+    result.m_metrics.append(qMakePair(QString("ip[uA]"), peak.m_height));
+    result.m_metrics.append(qMakePair(QString("fwhm[mV]"), peak.m_fwhm));
+    result.m_metrics.append(qMakePair(QString("area"), peak.m_area));
+}
+
+void CBatchAnalyzer::analyzeCa(const CCsvReader::Table_t& table, Result_t& result)
+{
+    CCaAnalysis analysis;
+    for (int i = 0; i < result.m_points; i++)
+        analysis.addSample(table.m_columns[0][i], table.m_columns[1][i]);
+
+    CCaAnalysis::Cottrell_t fit = analysis.cottrell();
+
+    result.m_metrics.append(qMakePair(QString("Q[uC]"), analysis.charge()));
+    if (!fit.m_valid)
+        return;
+
+    result.m_metrics.append(qMakePair(QString("cottrell_b"), fit.m_slope));
+    result.m_metrics.append(qMakePair(QString("cottrell_a"), fit.m_intercept));
+    result.m_metrics.append(qMakePair(QString("cottrell_r2"), fit.m_rSquared));
+}
+
+QFuture<CBatchAnalyzer::Result_t> CBatchAnalyzer::startAnalyze(const QStringList& files,
+                                                               const QString& circuit)
+{
+    // mapped hands the files out to the pool threads as they get free, a
+    // slow fit does not hold up the rest
+    return QtConcurrent::mapped(files, CAnalyze(circuit));
+}
+
+QVector<CBatchAnalyzer::Result_t> CBatchAnalyzer::analyze(const QStringList& files,
+                                                          const QString& circuit)
+{
+    return QtConcurrent::blockingMapped<QVector<Result_t> >(files, CAnalyze(circuit));
+}
+
+int CBatchAnalyzer::writeTable(const QString& fileName, const QVector<Result_t>& results)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        qWarning() << "Cannot write" << fileName << file.errorString();
+        return -1;
+    }
+
+    // union of the metrics, in the order they first appear
+    QStringList columns;
+    for (const Result_t& result : results)
+    {
+        for (const QPair<QString, double>& metric : result.m_metrics)
+        {
+            if (!columns.contains(metric.first))
+                columns.append(metric.first);
+        }
+    }
+
+    QTextStream out(&file);
+    out << "File,Technique,Points,Status";
+    for (const QString& column : columns)
+        out << "," << column;
+    out << "\n";
+
+    for (const Result_t& result : results)
+    {
+        // names and messages may hold commas
+        out << "\"" << result.m_fileName << "\"," << measureName(result.m_measure) << ","
+            << result.m_points << ",\"" << result.m_status << "\"";
+
+        for (const QString& column : columns)
+        {
+            out << ",";
+            for (const QPair<QString, double>& metric : result.m_metrics)
+            {
+                if (metric.first == column)
+                {
+                    out << QString::number(metric.second, 'g', 8);
+                    break;
+                }
+            }
+        }
+
+        out << "\n";
+    }
+
+    return 0;
+}
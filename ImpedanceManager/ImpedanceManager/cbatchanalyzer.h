@@ -0,0 +1,72 @@
+#ifndef CBATCHANALYZER_H
+#define CBATCHANALYZER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPair>
+#include <QFuture>
+
+#include "MeasureUtility.h"
+#include "ccsvreader.h"
+
+using namespace MeasureUtility;
+
+// Analysis of a directory of exported measurements (CSV) in one go. The
+// technique is told by the header the project wrote, every file gets the
+// analysis of its technique:
+//
+//  EIS  equivalent circuit fit (multi start)
+//  CV   cycles and the peaks of the last complete one
+//  DPV  baseline, peaks, the largest one reported (SWV: on the difference)
+//  CA   charge and Cottrell fit
+//
+// Files are analyzed on the global thread pool, the results are written as
+// one table, a row per file and a column per metric.
+class CBatchAnalyzer
+{
+public:
+    typedef struct
+    {
+        QString m_fileName;
+        EMeasures_t m_measure;
+        int m_points;
+        QString m_status;                           // empty when analyzed
+        QVector<QPair<QString, double> > m_metrics;
+    } Result_t;
+
+    // the per file analysis as a functor for QtConcurrent::mapped
+    class CAnalyze
+    {
+    public:
+        typedef Result_t result_type;
+
+        explicit CAnalyze(const QString& circuit) : m_circuit(circuit) {}
+        Result_t operator()(const QString& fileName) const;
+
+    private:
+        QString m_circuit;
+    };
+
+    static QStringList findFiles(const QString& directory, const bool recursive);
+
+    // the files spread over the pool threads, progress through a watcher
+    static QFuture<Result_t> startAnalyze(const QStringList& files, const QString& circuit);
+    static QVector<Result_t> analyze(const QStringList& files, const QString& circuit);
+
+    static int writeTable(const QString& fileName, const QVector<Result_t>& results);
+
+    static QString measureName(const EMeasures_t& measure);
+
+    static const char* m_defaultCircuit;
+
+private:
+    static void analyzeEis(const CCsvReader::Table_t& table, const QString& circuit,
+                           Result_t& result);
+    static void analyzeCv(const CCsvReader::Table_t& table, Result_t& result);
+    static void analyzePeaks(const QVector<double>& x, const QVector<double>& y,
+                             Result_t& result);
+    static void analyzeCa(const CCsvReader::Table_t& table, Result_t& result);
+};
+
+#endif // CBATCHANALYZER_H
@@ -0,0 +1,156 @@
+#include "cbatchdialog.h"
+
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
+#include <QMessageBox>
+
+CBatchDialog::CBatchDialog(QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle("Batch analysis");
+    resize(900, 560);
+
+    m_labelDirectory.setText("Directory");
+    m_pbDirectory.setText("...");
+    m_cbRecursive.setText("Subdirectories");
+    m_labelCircuit.setText("EIS circuit");
+    m_leCircuit.setText(CBatchAnalyzer::m_defaultCircuit);
+    m_leCircuit.setToolTip("R, C, L, Q (CPE), W (Warburg), '-' series, p(a,b) parallel");
+    m_labelOutput.setText("Results table");
+    m_pbOutput.setText("...");
+    m_pbStart.setText("Start");
+
+    m_formLayout.addWidget(&m_labelDirectory, 0, 0);
+    m_formLayout.addWidget(&m_leDirectory, 0, 1);
+    m_formLayout.addWidget(&m_pbDirectory, 0, 2);
+    m_formLayout.addWidget(&m_cbRecursive, 1, 1);
+    m_formLayout.addWidget(&m_labelCircuit, 2, 0);
+    m_formLayout.addWidget(&m_leCircuit, 2, 1);
+    m_formLayout.addWidget(&m_labelOutput, 3, 0);
+    m_formLayout.addWidget(&m_leOutput, 3, 1);
+    m_formLayout.addWidget(&m_pbOutput, 3, 2);
+
+    m_buttonLayout.addWidget(&m_progress);
+    m_buttonLayout.addWidget(&m_pbStart);
+
+    m_table.setColumnCount(4);
+    m_table.setHorizontalHeaderLabels(QStringList() << "File" << "Technique" << "Points"
+                                                    << "Status");
+    m_table.setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    m_layout.addLayout(&m_formLayout);
+    m_layout.addLayout(&m_buttonLayout);
+    m_layout.addWidget(&m_table);
+    m_layout.addWidget(&m_labelStatus);
+    setLayout(&m_layout);
+
+    connect(&m_pbDirectory, SIGNAL(clicked()), this, SLOT(on_pbDirectory_clicked()));
+    connect(&m_pbOutput, SIGNAL(clicked()), this, SLOT(on_pbOutput_clicked()));
+    connect(&m_pbStart, SIGNAL(clicked()), this, SLOT(on_pbStart_clicked()));
+    connect(&m_watcher, SIGNAL(resultReadyAt(int)), this, SLOT(on_resultReadyAt(int)));
+    connect(&m_watcher, SIGNAL(progressRangeChanged(int,int)),
+            &m_progress, SLOT(setRange(int,int)));
+    connect(&m_watcher, SIGNAL(progressValueChanged(int)), &m_progress, SLOT(setValue(int)));
+    connect(&m_watcher, SIGNAL(finished()), this, SLOT(on_finished()));
+}
+
+CBatchDialog::~CBatchDialog()
+{
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+void CBatchDialog::on_pbDirectory_clicked()
+{
+    QString directory = QFileDialog::getExistingDirectory(this, "Measurements directory",
+                                                          QDir::currentPath());
+    if (directory.isEmpty())
+        return;
+
+    m_leDirectory.setText(directory);
+    if (m_leOutput.text().isEmpty())
+        m_leOutput.setText(QDir(directory).filePath("batch_results.csv"));
+}
+
+void CBatchDialog::on_pbOutput_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Results table", m_leOutput.text(),
+                                                    tr("CSV Files (*.csv)"));
+    if (!fileName.isEmpty())
+        m_leOutput.setText(fileName);
+}
+
+void CBatchDialog::on_pbStart_clicked()
+{
+    if (m_watcher.isRunning())
+    {
+        m_watcher.cancel();
+        return;
+    }
+
+    QString directory = m_leDirectory.text();
+    if (directory.isEmpty() || !QDir(directory).exists() || m_leOutput.text().isEmpty())
+    {
+        QMessageBox msgBox;
+        msgBox.setText("Batch analysis error!");
+        msgBox.setInformativeText("Choose an existing directory and a results table.");
+        msgBox.exec();
+        return;
+    }
+
+    QStringList files = CBatchAnalyzer::findFiles(directory, m_cbRecursive.isChecked());
+    files.removeAll(QFileInfo(m_leOutput.text()).absoluteFilePath());
+
+    m_table.setRowCount(0);
+    m_labelStatus.setText(QString("%1 files").arg(files.size()));
+    m_pbStart.setText("Cancel");
+
+    m_timer.start();
+    m_watcher.setFuture(CBatchAnalyzer::startAnalyze(files, m_leCircuit.text()));
+}
+
+void CBatchDialog::addRow(const CBatchAnalyzer::Result_t& result)
+{
+    int row = m_table.rowCount();
+    m_table.insertRow(row);
+    m_table.setItem(row, 0, new QTableWidgetItem(QFileInfo(result.m_fileName).fileName()));
+    m_table.setItem(row, 1, new QTableWidgetItem(CBatchAnalyzer::measureName(result.m_measure)));
+    m_table.setItem(row, 2, new QTableWidgetItem(QString::number(result.m_points)));
+    m_table.setItem(row, 3, new QTableWidgetItem(result.m_status));
+    m_table.item(row, 0)->setToolTip(result.m_fileName);
+}
+
+void CBatchDialog::on_resultReadyAt(int index)
+{
+    addRow(m_watcher.resultAt(index));
+}
+
+void CBatchDialog::on_finished()
+{
+    m_pbStart.setText("Start");
+
+    if (m_watcher.isCanceled())
+    {
+        m_labelStatus.setText("Canceled, no results table written");
+        return;
+    }
+
+    QVector<CBatchAnalyzer::Result_t> results = m_watcher.future().results().toVector();
+    double elapsed_s = m_timer.elapsed() / 1000.0;
+
+    if (CBatchAnalyzer::writeTable(m_leOutput.text(), results))
+    {
+        QMessageBox msgBox;
+        msgBox.setText("File save error!");
+        msgBox.setInformativeText("Cannot write " + m_leOutput.text());
+        msgBox.exec();
+        return;
+    }
+
+    m_labelStatus.setText(QString("%1 files in %2 s (%3 files/s), written to %4")
+                          .arg(results.size())
+                          .arg(elapsed_s, 0, 'f', 1)
+                          .arg(elapsed_s > 0 ? results.size() / elapsed_s : 0, 0, 'f', 1)
+                          .arg(m_leOutput.text()));
+}
@@ -0,0 +1,61 @@
+#ifndef CBATCHDIALOG_H
+#define CBATCHDIALOG_H
+
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QCheckBox>
+#include <QLabel>
+#include <QProgressBar>
+#include <QTableWidget>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+
+#include "cbatchanalyzer.h"
+
+// Batch analysis of a directory of exported measurements, the GUI side of
+// ImpedanceManager --batch. Results are shown as they come in and written
+// to the results table when all files are done.
+class CBatchDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CBatchDialog(QWidget *parent = 0);
+    ~CBatchDialog();
+
+private slots:
+    void on_pbDirectory_clicked();
+    void on_pbOutput_clicked();
+    void on_pbStart_clicked();
+    void on_resultReadyAt(int index);
+    void on_finished();
+
+private:
+    void addRow(const CBatchAnalyzer::Result_t& result);
+
+    QVBoxLayout m_layout;
+    QGridLayout m_formLayout;
+    QHBoxLayout m_buttonLayout;
+    QLabel m_labelDirectory;
+    QLineEdit m_leDirectory;
+    QPushButton m_pbDirectory;
+    QCheckBox m_cbRecursive;
+    QLabel m_labelCircuit;
+    QLineEdit m_leCircuit;
+    QLabel m_labelOutput;
+    QLineEdit m_leOutput;
+    QPushButton m_pbOutput;
+    QPushButton m_pbStart;
+    QProgressBar m_progress;
+    QLabel m_labelStatus;
+    QTableWidget m_table;
+
+    QFutureWatcher<CBatchAnalyzer::Result_t> m_watcher;
+    QElapsedTimer m_timer;
+};
+
+#endif // CBATCHDIALOG_H
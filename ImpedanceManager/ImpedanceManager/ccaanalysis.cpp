@@ -0,0 +1,89 @@
+#include "ccaanalysis.h"
+
+#include <cmath>
+
+CCaAnalysis::CCaAnalysis(const double& fitStartTime)
+{
+    m_fitStartTime = fitStartTime;
+    reset();
+}
+
+void CCaAnalysis::reset()
+{
+    m_started = false;
+    m_lastTime = 0;
+    m_lastCurrent = 0;
+    m_charge = 0;
+    m_chargeMin = 0;
+    m_chargeMax = 0;
+
+    m_n = 0;
+    m_sx = 0;
+    m_sy = 0;
+    m_sxx = 0;
+    m_sxy = 0;
+    m_syy = 0;
+}
+
+double CCaAnalysis::addSample(const double& time, const double& current)
+{
+    if (m_started)
+    {
+        m_charge += 0.5 * (current + m_lastCurrent) * (time - m_lastTime);
+        m_chargeMin = qMin(m_chargeMin, m_charge);
+        m_chargeMax = qMax(m_chargeMax, m_charge);
+    }
+
+    m_started = true;
+    m_lastTime = time;
+    m_lastCurrent = current;
+
+    if ((time > 0) && (time >= m_fitStartTime))
+    {
+        double x = 1 / std::sqrt(time);
+
+        m_n++;
+        m_sx += x;
+        m_sy += current;
+        m_sxx += x * x;
+        m_sxy += x * current;
+        m_syy += current * current;
+    }
+
+    return m_charge;
+}
+
+CCaAnalysis::Cottrell_t CCaAnalysis::cottrell() const
+{
+    Cottrell_t fit;
+    fit.m_slope = 0;
+    fit.m_intercept = 0;
+    fit.m_rSquared = 0;
+    fit.m_points = m_n;
+    fit.m_valid = false;
+
+    if (m_n < 3)
+        return fit;
+
+    double varX = m_sxx - m_sx * m_sx / m_n;
+    double varY = m_syy - m_sy * m_sy / m_n;
+    double covXY = m_sxy - m_sx * m_sy / m_n;
+
+    if (varX <= 0)
+        return fit;
+
+    fit.m_slope = covXY / varX;
+    fit.m_intercept = (m_sy - fit.m_slope * m_sx) / m_n;
+    fit.m_rSquared = (varY > 0) ? (covXY * covXY) / (varX * varY) : 1;
+    fit.m_valid = true;
+
+    return fit;
+}
+
+double CCaAnalysis::cottrellCurrent(const Cottrell_t& fit, const double& time)
+{
+    if (!fit.m_valid || (time <= 0))
+        return NAN;
+
+    return fit.m_intercept + fit.m_slope / std::sqrt(time);
+}
@@ -0,0 +1,57 @@
+#ifndef CCAANALYSIS_H
+#define CCAANALYSIS_H
+
+#include <QtGlobal>
+
+// Running chronoamperometry analysis, O(1) per sample:
+// - charge, trapezoidal integral of the current
+// - Cottrell fit I = a + b / sqrt(t), linear least squares in x = t^-1/2
+//   kept as running sums; samples before the start time (double layer
+//   charging) are left out of the fit.
+class CCaAnalysis
+{
+public:
+    typedef struct
+    {
+        double m_slope;         // b, [I unit * s^1/2]
+        double m_intercept;     // a, background current
+        double m_rSquared;
+        int m_points;
+        bool m_valid;
+    } Cottrell_t;
+
+    explicit CCaAnalysis(const double& fitStartTime = 0);
+
+    void reset();
+    void setFitStartTime(const double& time) { m_fitStartTime = time; }
+
+    // returns the charge after this sample, [I unit * s]
+    double addSample(const double& time, const double& current);
+
+    double charge() const { return m_charge; }
+    double chargeMin() const { return m_chargeMin; }
+    double chargeMax() const { return m_chargeMax; }
+    Cottrell_t cottrell() const;
+
+    static double cottrellCurrent(const Cottrell_t& fit, const double& time);
+
+private:
+    double m_fitStartTime;
+
+    bool m_started;
+    double m_lastTime;
+    double m_lastCurrent;
+    double m_charge;
+    double m_chargeMin;
+    double m_chargeMax;
+
+    // running sums of the Cottrell regression
+    int m_n;
+    double m_sx;
+    double m_sy;
+    double m_sxx;
+    double m_sxy;
+    double m_syy;
+};
+
+#endif // CCAANALYSIS_H
@@ -1,4 +1,9 @@
 #include "ccaproject.h"
+#include "cmeasurelimits.h"
+
+#include <cmath>
+
+const int CCaProject::m_minTraceBuckets;
 
 CCaProject::CCaProject(CSerialThread* serialThread, QWidget* parent) :
     CGenericProject(serialThread, parent)
@@ -7,6 +12,7 @@ CCaProject::CCaProject(CSerialThread* serialThread, QWidget* parent) :
 
     initPlot();
     initFields();
+    initFilter();
 
     mp_serialThread = serialThread;
     updateTree();
@@ -44,6 +50,33 @@ void CCaProject::initPlot()
     customPlot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
     customPlot->graph(0)->setName("CA measure");
 
+    customPlot->yAxis2->setVisible(true);
+    customPlot->yAxis2->setLabel("Q [uC]");
+    customPlot->yAxis2->setTickLabelColor(Qt::darkGreen);
+    customPlot->yAxis2->setLabelColor(Qt::darkGreen);
+
+    mp_chargeGraph = customPlot->addGraph(customPlot->xAxis, customPlot->yAxis2);
+    mp_chargeGraph->setName("Charge");
+    mp_chargeGraph->setPen(QPen(Qt::darkGreen));
+
+    connect(customPlot->xAxis, SIGNAL(rangeChanged(const QCPRange&)),
+            this, SLOT(on_xRange_changed(const QCPRange&)));
+
+    mp_cottrellGraph = customPlot->addGraph();
+    mp_cottrellGraph->setName("Cottrell fit");
+    mp_cottrellGraph->setPen(QPen(Qt::red, 1, Qt::DashLine));
+
+    mp_analysisLabel = new QCPItemText(customPlot);
+    customPlot->addItem(mp_analysisLabel);
+    mp_analysisLabel->setPositionAlignment(Qt::AlignTop|Qt::AlignRight);
+    mp_analysisLabel->position->setType(QCPItemPosition::ptAxisRectRatio);
+    mp_analysisLabel->position->setCoords(0.98, 0.02);
+    mp_analysisLabel->setFont(QFont("Courier", 10));
+    mp_analysisLabel->setTextAlignment(Qt::AlignLeft);
+    mp_analysisLabel->setPen(QPen(Qt::black));
+    mp_analysisLabel->setBrush(QBrush(Qt::white));
+    mp_analysisLabel->setVisible(false);
+
     m_upperXRange = 3600; // time, 1h max
     m_lowerXRange = 0;
     m_upperYRange = 1000; // current
@@ -87,6 +120,15 @@ void CCaProject::initFields()
     m_lePotential.setValidator(mv16Validator);
     m_leMeasTime.setValidator(time16ValidatorPositive);
     m_le_dt.setValidator(time64dValidatorPositive);
+
+    // Cottrell fit starts after the double layer charging
+    m_labelCottrellStart.setText("Cottrell[s]");
+    ui->glControls->addWidget(&m_labelCottrellStart, 0, 1);
+    m_leCottrellStart.setMaximumWidth(m_maxItemWidth);
+    m_leCottrellStart.setText("0.1");
+    m_leCottrellStart.setToolTip("Samples before this time are left out of the Cottrell fit");
+    m_leCottrellStart.setValidator(new DoubleValidator(0, 3600, this));
+    ui->glControls->addWidget(&m_leCottrellStart, 1, 1);
 }
 
 void CCaProject::on_received_takeMeasCa(const bool& ack)
@@ -140,21 +182,67 @@ void CCaProject::changeConnections(const bool con)
 
 void CCaProject::on_received_giveMeasChunkCa(const union32_t& current, const union32_t& time)
 {
-    float lcur = current.idFl / 10;
+    MeasSample_t sample;
+    sample.m_index = 0;
+    sample.m_data[0] = current.idFl;
+    sample.m_data[1] = time.idFl;
+
+    ingestSample(sample);
+    updatePlot();
+}
+
+void CCaProject::ingestSample(const MeasSample_t& sample)
+{
+    float lcur = sample.m_data[0] / 10;
+    float time = sample.m_data[1];
 
-    m_x.append(time.idFl);
+    m_x.append(time);
     m_y.append(lcur);
 
-    addCaPoint(lcur, time.idFl);
-    customPlot->graph(0)->addData(time.idFl, lcur);
-    autoScalePlot();
+    // a long run lists only its first points, the plot is served by the
+    // pyramids at any length
+    if (m_x.size() <= m_maxListedPoints)
+        addCaPoint(lcur, time);
 
-    qDebug("CA point received. Time: %f Cur %f", time.idFl, lcur);
+    m_lod.append(time, lcur);
+    m_chargeLod.append(time, m_analysis.addSample(time, lcur));
+    filterSample(time, lcur);
+}
+
+int CCaProject::importSamples(const CCsvReader::Table_t& table)
+{
+    // Time[s],Current[uA], the current already scaled
+    if (table.m_columns.size() < 2)
+        return -1;
+
+    m_x = table.m_columns[0];
+    m_y = table.m_columns[1];
+    m_analysis.setFitStartTime(m_leCottrellStart.text().toDouble());
+
+    // every sample goes through the pyramids and the integral
+    for (int i = 0; i < m_x.size(); i++)
+    {
+        m_lod.append(m_x[i], m_y[i]);
+        m_chargeLod.append(m_x[i], m_analysis.addSample(m_x[i], m_y[i]));
+    }
+
+    QList<QTreeWidgetItem*> items;
+    for (int i = 0; i < qMin(m_x.size(), m_maxListedPoints); i++)
+        items.append(caItem(m_y[i], m_x[i]));
+    ui->twPoints->addTopLevelItems(items);
+
+    return 0;
 }
 
 void CCaProject::on_received_endMeasCa()
 {
-    insertLabels();
+    drainSamples();
+    applyFilter();
+
+    // a label item per point, far too many for a long run
+    if (m_x.size() <= m_maxListedPoints)
+        insertLabels();
+
     emit measureFinished();
 }
 
@@ -169,23 +257,17 @@ void CCaProject::updateTree()
     ui->twPoints->header()->resizeSection(1, 100);
 }
 
-void CCaProject::takeMeasure()
+int CCaProject::takeMeasure()
 {
     bool ok;
-    QString badParameters;
 
     qint16 potential = (qint16)m_lePotential.text().toInt(&ok, 10);
-    //if (!potential)
-        //badParameters += m_lePotential.text() + "\n";
-
     quint16 measTime = (quint16)m_leMeasTime.text().toInt(&ok, 10);
-    if (!measTime)
-        badParameters += m_leMeasTime.text() + "\n";
 
     union32_t dt;
     dt.idFl = (float)m_le_dt.text().toDouble(&ok);
-    if (!dt.id32)
-        badParameters += m_le_dt.text() + "\n";
+
+    QString badParameters = CMeasureLimits::checkCa(measTime, dt);
 
     if(badParameters.length())
     {
@@ -194,12 +276,120 @@ void CCaProject::takeMeasure()
         msgBox.setText("Empty fields detected!");
         msgBox.setInformativeText(badParameters);
         msgBox.exec();
-        return;
+        return -1;
     }
 
     clearData();
+    clearAnalysis();
+    m_analysis.setFitStartTime(m_leCottrellStart.text().toDouble());
     qDebug() << "Sending CA measure request";
     emit send_takeMeasCa(potential, measTime, dt);
+    return 0;
+}
+
+void CCaProject::autoScalePlot()
+{
+    // the fit itself is kept up to date per sample, only its curve and the
+    // charge axis are refreshed here, once per replot
+    updateCottrellCurve();
+
+    // new samples in an unchanged range do not emit rangeChanged
+    refreshTrace();
+
+    double low = m_analysis.chargeMin();
+    double high = m_analysis.chargeMax();
+    double margin = qMax(0.05 * (high - low), 1e-9);
+    customPlot->yAxis2->setRange(low - margin, high + margin);
+
+    CGenericProject::autoScalePlot();
+}
+
+void CCaProject::on_xRange_changed(const QCPRange& range)
+{
+    Q_UNUSED(range);
+    refreshTrace();
+}
+
+void CCaProject::refreshTrace()
+{
+    const QCPRange range = customPlot->xAxis->range();
+    const int buckets = qMax(m_minTraceBuckets, customPlot->axisRect()->width());
+
+    QVector<double> keys, values;
+    m_lod.envelope(range.lower, range.upper, buckets, keys, values);
+
+    // markers only while single samples are shown
+    customPlot->graph(0)->setScatterStyle(m_lod.size() <= buckets ?
+                                              QCPScatterStyle(QCPScatterStyle::ssCircle) :
+                                              QCPScatterStyle(QCPScatterStyle::ssNone));
+    customPlot->graph(0)->setData(keys, values);
+
+    // the integral is smooth, the bucket means draw it
+    m_chargeLod.mean(range.lower, range.upper, buckets, keys, values);
+    mp_chargeGraph->setData(keys, values);
+}
+
+double CCaProject::getYMax()
+{
+    return m_lod.size() ? qMax(0.0, m_lod.valueMax()) : 0;
+}
+
+double CCaProject::getYMin()
+{
+    return m_lod.size() ? m_lod.valueMin() : 9999999999; // as the base, unreachable when empty
+}
+
+double CCaProject::getXMax()
+{
+    return m_lod.size() ? qMax(0.0, m_lod.keyMax()) : 0;
+}
+
+double CCaProject::getXMin()
+{
+    return m_lod.size() ? m_lod.keyMin() : 9999999999;
+}
+
+void CCaProject::updateCottrellCurve()
+{
+    CCaAnalysis::Cottrell_t fit = m_analysis.cottrell();
+    QString text = QString("Q=%1 uC").arg(m_analysis.charge(), 0, 'g', 4);
+
+    mp_cottrellGraph->clearData();
+    if (fit.m_valid && !m_x.isEmpty())
+    {
+        // log spaced, the curve is steep at short times
+        double first = qMax(m_x.first(), m_leCottrellStart.text().toDouble());
+        double last = m_x.last();
+        if (first <= 0)
+            first = (m_x.size() > 1) ? m_x[1] : last;
+
+        if ((first > 0) && (last > first))
+        {
+            double ratio = std::pow(last / first, 1.0 / (m_cottrellCurvePoints - 1));
+            double time = first;
+
+            for (int i = 0; i < m_cottrellCurvePoints; i++, time *= ratio)
+                mp_cottrellGraph->addData(time, CCaAnalysis::cottrellCurrent(fit, time));
+        }
+
+        text += QString("\nCottrell: I=%1+%2/sqrt(t)\nR^2=%3")
+                .arg(fit.m_intercept, 0, 'g', 4)
+                .arg(fit.m_slope, 0, 'g', 4)
+                .arg(fit.m_rSquared, 0, 'f', 4);
+    }
+
+    mp_analysisLabel->setText(text);
+    mp_analysisLabel->setVisible(true);
+}
+
+void CCaProject::clearAnalysis()
+{
+    m_analysis.reset();
+    m_lod.clear();
+    m_chargeLod.clear();
+    mp_chargeGraph->clearData();
+    mp_cottrellGraph->clearData();
+    mp_analysisLabel->setVisible(false);
 }
 
 int CCaProject::saveToCsv(QIODevice* device)
@@ -224,6 +414,59 @@ int CCaProject::saveToCsv(QIODevice* device)
     return 0;
 }
 
+int CCaProject::saveProjectAs(QFile& file)
+{
+    qDebug() << "Saving CA project.";
+
+    QList<SettingParam_t> paramList;
+    SettingParam_t param;
+
+    param.m_name = "measType";
+    param.m_value = QString("%1").arg((int)measureType());
+    paramList.append(param);
+
+    param.m_name = "potential";
+    param.m_value = m_lePotential.text();
+    paramList.append(param);
+
+    param.m_name = "measTime";
+    param.m_value = m_leMeasTime.text();
+    paramList.append(param);
+
+    param.m_name = "dt";
+    param.m_value = m_le_dt.text();
+    paramList.append(param);
+
+    param.m_name = "cottrellStart";
+    param.m_value = m_leCottrellStart.text();
+    paramList.append(param);
+
+    CProjectManager projMan(file, paramList, true);
+    return 0;
+}
+
+int CCaProject::openProject(QFile& file)
+{
+    qDebug() << "Reading CA project.";
+
+    QList<SettingParam_t> paramList;
+    CProjectManager projMan(file, paramList, false);
+
+    if (paramList.size() < 4)
+    {
+        qCritical() << "CA project" << file.fileName() << "is missing fields";
+        return -1;
+    }
+
+    // update fields
+    m_lePotential.setText(paramList.takeFirst().m_value);
+    m_leMeasTime.setText(paramList.takeFirst().m_value);
+    m_le_dt.setText(paramList.takeFirst().m_value);
+    m_leCottrellStart.setText(paramList.takeFirst().m_value);
+
+    return 0;
+}
+
 int CCaProject::insertLabels()
 {
     if (m_x.size() != m_y.size())
@@ -260,12 +503,18 @@ int CCaProject::insertLabels()
 
 void CCaProject::addCaPoint(const float& current, const float& time)
 {
-    QTreeWidgetItem* item = new QTreeWidgetItem(ui->twPoints);
+    ui->twPoints->addTopLevelItem(caItem(current, time));
+    ui->twPoints->scrollToBottom();
+}
+
+QTreeWidgetItem* CCaProject::caItem(const float& current, const float& time)
+{
+    QTreeWidgetItem* item = new QTreeWidgetItem();
 
     item->setText(0, QString::number(time, 'e', 2));
     item->setText(1, QString::number(current, 'e', 2));
 
-    ui->twPoints->scrollToBottom();
+    return item;
 }
 
 
@@ -2,6 +2,8 @@
 #define CCAPROJECT_H
 
 #include "cgenericproject.h"
+#include "ccaanalysis.h"
+#include "clodpyramid.h"
 
 class CCaProject : public CGenericProject
 {
@@ -12,9 +14,11 @@ public:
     ~CCaProject();
 
     virtual EMeasures_t measureType(){ return EMeasures_t::eCA; }
-    virtual void takeMeasure();
+    virtual int takeMeasure();
     virtual void changeConnections(const bool);
     virtual int saveToCsv(QIODevice* device);
+    virtual int saveProjectAs(QFile& file);
+    virtual int openProject(QFile& file);
 
 signals:
     void send_takeMeasCa(const qint16&, const quint16&, const union32_t&);
@@ -23,6 +27,18 @@ private slots:
     void on_received_takeMeasCa(const bool&);
     void on_received_giveMeasChunkCa(const union32_t&, const union32_t&);
     void on_received_endMeasCa();
+    void on_xRange_changed(const QCPRange& range);
+
+protected:
+    virtual void ingestSample(const MeasSample_t& sample);
+    virtual int importSamples(const CCsvReader::Table_t& table);
+    virtual void autoScalePlot();
+
+    // extents from the pyramid totals, the trace is not walked
+    virtual double getYMax();
+    virtual double getYMin();
+    virtual double getXMax();
+    virtual double getXMin();
 
 private:
     virtual void initPlot();
@@ -32,6 +48,10 @@ private:
     virtual int insertLabels();
 
     void addCaPoint(const float& current, const float& time);
+    static QTreeWidgetItem* caItem(const float& current, const float& time);
+    void updateCottrellCurve();
+    void refreshTrace();
+    void clearAnalysis();
 
     QLabel m_labelPotential;
     QLineEdit m_lePotential;
@@ -42,6 +62,22 @@ private:
     QLabel m_label_dt;
     QLineEdit m_le_dt;
 
+    // charge and Cottrell overlays, updated per sample
+    QLabel m_labelCottrellStart;
+    QLineEdit m_leCottrellStart;
+    CCaAnalysis m_analysis;
+    QCPGraph* mp_chargeGraph;       // on yAxis2
+    QCPGraph* mp_cottrellGraph;
+    QCPItemText* mp_analysisLabel;
+
+    static const int m_cottrellCurvePoints = 100;
+
+    // the measured and the charge graph only hold the pyramid level
+    // matching the view
+    CLodPyramid m_lod;
+    CLodPyramid m_chargeLod;
+    static const int m_minTraceBuckets = 200;
+
 public slots:
 
 };
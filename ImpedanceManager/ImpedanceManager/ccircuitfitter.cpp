@@ -0,0 +1,229 @@
+#include "ccircuitfitter.h"
+#include "clinalg.h"
+
+#include <QtConcurrent>
+#include <QVarLengthArray>
+#include <QDebug>
+#include <random>
+#include <cmath>
+
+void CCircuitFitter::clearNormals(Normals_t& normals, const int& paramCount)
+{
+    normals.m_jtj.fill(0, paramCount * paramCount);
+    normals.m_jtr.fill(0, paramCount);
+    normals.m_chiSquare = 0;
+}
+
+void CCircuitFitter::addPoint(const CCircuitModel& model, const double* params,
+                              const double& omega, const double& re, const double& im,
+                              Normals_t& normals)
+{
+    const int n = model.parameterCount();
+    QVarLengthArray<complex_t, 16> grad(n);
+    QVarLengthArray<double, 16> jRe(n), jIm(n);
+
+    for (int k = 0; k < n; k++)
+        grad[k] = 0;
+
+    complex_t z = model.impedance(omega, params, grad.data());
+
+    double weight = CLinAlg::modulusWeight(re, im);
+    double rRe = (z.real() - re) * weight;
+    double rIm = (z.imag() - im) * weight;
+
+    // d/d(ln p) = p * d/dp
+    for (int k = 0; k < n; k++)
+    {
+        jRe[k] = grad[k].real() * params[k] * weight;
+        jIm[k] = grad[k].imag() * params[k] * weight;
+    }
+
+    // rank 2 update, lower triangle is mirrored in solveStep
+    for (int r = 0; r < n; r++)
+    {
+        for (int c = 0; c <= r; c++)
+            normals.m_jtj[r * n + c] += jRe[r] * jRe[c] + jIm[r] * jIm[c];
+
+        normals.m_jtr[r] += jRe[r] * rRe + jIm[r] * rIm;
+    }
+
+    normals.m_chiSquare += rRe * rRe + rIm * rIm;
+}
+
+double CCircuitFitter::chiSquare(const CCircuitModel& model, const EisData_t& data,
+                                 const double* params)
+{
+    double chi = 0;
+
+    for (int i = 0; i < data.m_omega.size(); i++)
+    {
+        complex_t z = model.impedance(data.m_omega[i], params);
+        double weight = CLinAlg::modulusWeight(data.m_re[i], data.m_im[i]);
+        double rRe = (z.real() - data.m_re[i]) * weight;
+        double rIm = (z.imag() - data.m_im[i]) * weight;
+
+        chi += rRe * rRe + rIm * rIm;
+    }
+
+    return chi;
+}
+
+bool CCircuitFitter::solveStep(const Normals_t& normals, const double& lambda,
+                               QVector<double>& step)
+{
+    // (A + lambda diag(A)) step = -g, Cholesky, A is symmetric positive semidefinite
+    const int n = normals.m_jtr.size();
+    QVarLengthArray<double, 256> l(n * n);
+
+    for (int r = 0; r < n; r++)
+    {
+        for (int c = 0; c <= r; c++)
+            l[r * n + c] = normals.m_jtj[r * n + c];
+
+        l[r * n + r] += lambda * qMax(normals.m_jtj[r * n + r], 1e-12);
+    }
+
+    if (!CLinAlg::cholesky(l.data(), n))
+        return false;
+
+    step.resize(n);
+    for (int r = 0; r < n; r++)
+        step[r] = -normals.m_jtr[r];
+
+    CLinAlg::choleskySolve(l.data(), n, step.data());
+    return true;
+}
+
+CCircuitFitter::FitResult_t CCircuitFitter::fit(const CCircuitModel& model,
+                                                const EisData_t& data,
+                                                const QVector<double>& initial,
+                                                const int maxIterations)
+{
+    const int n = model.parameterCount();
+
+    FitResult_t result;
+    result.m_params = initial;
+    result.m_chiSquare = INFINITY;
+    result.m_iterations = 0;
+    result.m_converged = false;
+
+    if (!model.isValid() || (initial.size() != n) || (data.m_omega.size() * 2 < n))
+        return result;
+
+    QVector<double> params(initial), trial(n), step;
+    for (int k = 0; k < n; k++)
+        params[k] = qBound(1e-15, params[k], model.upperBound(k));
+
+    Normals_t normals;
+    double lambda = 1e-3;
+
+    for (result.m_iterations = 0; result.m_iterations < maxIterations; result.m_iterations++)
+    {
+        clearNormals(normals, n);
+        for (int i = 0; i < data.m_omega.size(); i++)
+            addPoint(model, params.constData(), data.m_omega[i],
+                     data.m_re[i], data.m_im[i], normals);
+
+        double chi = normals.m_chiSquare;
+        bool accepted = false;
+
+        while (lambda < 1e12)
+        {
+            if (solveStep(normals, lambda, step))
+            {
+                for (int k = 0; k < n; k++)
+                    trial[k] = qMin(params[k] * std::exp(step[k]), model.upperBound(k));
+
+                double trialChi = chiSquare(model, data, trial.constData());
+
+                if (trialChi < chi)
+                {
+                    params = trial;
+                    lambda = qMax(lambda / 10, 1e-12);
+                    accepted = true;
+
+                    if ((chi - trialChi) < (1e-10 * chi))
+                        result.m_converged = true;
+
+                    break;
+                }
+            }
+
+            lambda *= 10;
+        }
+
+        // no step makes it any better, this is the minimum
+        if (!accepted)
+            result.m_converged = true;
+
+        if (result.m_converged)
+            break;
+    }
+
+    result.m_params = params;
+    result.m_chiSquare = chiSquare(model, data, params.constData());
+    return result;
+}
+
+void CCircuitFitter::runJob(FitJob_t& job)
+{
+    job.m_result = fit(*job.mp_model, *job.mp_data, job.m_initial);
+}
+
+CCircuitFitter::FitResult_t CCircuitFitter::multiStartFit(const CCircuitModel& model,
+                                                          const EisData_t& data,
+                                                          const int starts,
+                                                          const bool parallel)
+{
+    QVector<double> guess = model.initialGuess(data.m_omega, data.m_re, data.m_im);
+    QVector<FitJob_t> jobs(qMax(starts, 1));
+
+    // first start is the guess itself, the rest is scattered a decade around it
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        std::mt19937 generator(i);
+        std::uniform_real_distribution<double> decades(-1.0, 1.0);
+        std::uniform_real_distribution<double> exponent(0.5, 1.0);
+
+        jobs[i].mp_model = &model;
+        jobs[i].mp_data = &data;
+        jobs[i].m_initial = guess;
+
+        for (int k = 0; i && (k < guess.size()); k++)
+        {
+            if (model.upperBound(k) <= 1.0)
+                jobs[i].m_initial[k] = exponent(generator);
+            else
+                jobs[i].m_initial[k] = guess[k] * std::pow(10.0, decades(generator));
+        }
+    }
+
+    if (parallel)
+        QtConcurrent::blockingMap(jobs, runJob);
+    else
+    {
+        for (int i = 0; i < jobs.size(); i++)
+            runJob(jobs[i]);
+    }
+
+    int best = 0;
+    for (int i = 1; i < jobs.size(); i++)
+    {
+        if (jobs[i].m_result.m_chiSquare < jobs[best].m_result.m_chiSquare)
+            best = i;
+    }
+
+    qDebug() << "Circuit" << model.description() << "best of" << jobs.size()
+             << "starts: start" << best << "chi2" << jobs[best].m_result.m_chiSquare
+             << "iterations" << jobs[best].m_result.m_iterations;
+
+    return jobs[best].m_result;
+}
+
+QFuture<CCircuitFitter::FitResult_t> CCircuitFitter::startMultiStartFit(const CCircuitModel& model,
+                                                                        const EisData_t& data,
+                                                                        const int starts)
+{
+    // model and data are copied into the task, the caller may go on freely
+    return QtConcurrent::run(multiStartFit, model, data, starts, true);
+}
@@ -0,0 +1,77 @@
+#ifndef CCIRCUITFITTER_H
+#define CCIRCUITFITTER_H
+
+#include <QVector>
+#include <QFuture>
+
+#include "ccircuitmodel.h"
+
+// Levenberg-Marquardt fit of a CCircuitModel to measured impedance.
+// Parameters are fitted as logarithms, so they stay positive, residuals are
+// weighted with 1/|Z| of the measured point (modulus weighting).
+class CCircuitFitter
+{
+public:
+    typedef struct
+    {
+        QVector<double> m_omega;    // [rad/s]
+        QVector<double> m_re;       // [Ohm]
+        QVector<double> m_im;       // [Ohm], negative for capacitive behaviour
+    } EisData_t;
+
+    typedef struct
+    {
+        QVector<double> m_params;
+        double m_chiSquare;
+        int m_iterations;
+        bool m_converged;
+    } FitResult_t;
+
+    // J^T J and J^T r in the log parameters, summed over points
+    typedef struct
+    {
+        QVector<double> m_jtj;      // n x n, row major
+        QVector<double> m_jtr;
+        double m_chiSquare;
+    } Normals_t;
+
+    static FitResult_t fit(const CCircuitModel& model, const EisData_t& data,
+                           const QVector<double>& initial,
+                           const int maxIterations = m_maxIterations);
+
+    // the starts run in parallel on the global thread pool; callers that are
+    // pool tasks themselves run them one after another instead
+    static FitResult_t multiStartFit(const CCircuitModel& model, const EisData_t& data,
+                                     const int starts = m_defaultStarts,
+                                     const bool parallel = true);
+
+    // multiStartFit on the global thread pool, the starts run in parallel
+    static QFuture<FitResult_t> startMultiStartFit(const CCircuitModel& model,
+                                                   const EisData_t& data,
+                                                   const int starts = m_defaultStarts);
+
+    static void clearNormals(Normals_t& normals, const int& paramCount);
+    static void addPoint(const CCircuitModel& model, const double* params,
+                         const double& omega, const double& re, const double& im,
+                         Normals_t& normals);
+    static double chiSquare(const CCircuitModel& model, const EisData_t& data,
+                            const double* params);
+    static bool solveStep(const Normals_t& normals, const double& lambda,
+                          QVector<double>& step);
+
+    static const int m_maxIterations = 200;
+    static const int m_defaultStarts = 20;
+
+private:
+    typedef struct
+    {
+        const CCircuitModel* mp_model;
+        const EisData_t* mp_data;
+        QVector<double> m_initial;
+        FitResult_t m_result;
+    } FitJob_t;
+
+    static void runJob(FitJob_t& job);
+};
+
+#endif // CCIRCUITFITTER_H
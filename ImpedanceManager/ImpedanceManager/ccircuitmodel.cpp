@@ -0,0 +1,323 @@
+#include "ccircuitmodel.h"
+
+#include <QVarLengthArray>
+#include <QRegExp>
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+CCircuitModel::CCircuitModel()
+{
+    m_root = -1;
+}
+
+int CCircuitModel::compile(const QString& description)
+{
+    m_description = description;
+    m_description.remove(QRegExp("\\s"));
+
+    m_lastError.clear();
+    m_nodes.clear();
+    m_parameterNames.clear();
+    m_upperBounds.clear();
+    m_root = -1;
+
+    if (m_description.isEmpty())
+    {
+        m_lastError = "Empty circuit";
+        return -1;
+    }
+
+    int pos = 0;
+    int root = parseSeries(pos);
+
+    if ((root >= 0) && (pos != m_description.length()))
+    {
+        m_lastError = QString("Unexpected '%1' at %2").arg(m_description[pos]).arg(pos + 1);
+        root = -5;
+    }
+
+    if (root < 0)
+    {
+        qWarning() << "Cannot compile circuit" << description << ":" << m_lastError;
+        m_nodes.clear();
+        m_parameterNames.clear();
+        m_upperBounds.clear();
+        return root;
+    }
+
+    m_root = root;
+    return 0;
+}
+
+int CCircuitModel::addNode(const ENode_t& type)
+{
+    Node_t node;
+    node.m_type = type;
+    node.m_firstParam = m_parameterNames.size();
+    node.m_paramCount = 0;
+
+    m_nodes.append(node);
+    return m_nodes.size() - 1;
+}
+
+int CCircuitModel::parseSeries(int& pos)
+{
+    int node = addNode(ENode_t::eSeries);
+
+    forever
+    {
+        int child = parseTerm(pos);
+        if (child < 0)
+            return child;
+
+        m_nodes[node].m_children.append(child);
+
+        if ((pos < m_description.length()) && (m_description[pos] == '-'))
+            pos++;
+        else
+            break;
+    }
+
+    m_nodes[node].m_paramCount = m_parameterNames.size() - m_nodes[node].m_firstParam;
+    return node;
+}
+
+int CCircuitModel::parseTerm(int& pos)
+{
+    if (pos >= m_description.length())
+    {
+        m_lastError = "Unexpected end of circuit";
+        return -2;
+    }
+
+    if (m_description[pos].toLower() != 'p')
+        return parseElement(pos);
+
+    pos++;
+    if ((pos >= m_description.length()) || (m_description[pos] != '('))
+    {
+        m_lastError = QString("Expected '(' after p at %1").arg(pos + 1);
+        return -2;
+    }
+    pos++;
+
+    int node = addNode(ENode_t::eParallel);
+
+    forever
+    {
+        int child = parseSeries(pos);
+        if (child < 0)
+            return child;
+
+        m_nodes[node].m_children.append(child);
+
+        if ((pos < m_description.length()) && (m_description[pos] == ','))
+            pos++;
+        else
+            break;
+    }
+
+    if ((pos >= m_description.length()) || (m_description[pos] != ')'))
+    {
+        m_lastError = QString("Missing ')' at %1").arg(pos + 1);
+        return -3;
+    }
+    pos++;
+
+    if (m_nodes[node].m_children.size() < 2)
+    {
+        m_lastError = "Parallel element needs at least two branches";
+        return -4;
+    }
+
+    m_nodes[node].m_paramCount = m_parameterNames.size() - m_nodes[node].m_firstParam;
+    return node;
+}
+
+int CCircuitModel::parseElement(int& pos)
+{
+    QChar letter = m_description[pos].toUpper();
+    ENode_t type;
+
+    if (letter == 'R')      type = ENode_t::eR;
+    else if (letter == 'C') type = ENode_t::eC;
+    else if (letter == 'L') type = ENode_t::eL;
+    else if (letter == 'Q') type = ENode_t::eQ;
+    else if (letter == 'W') type = ENode_t::eW;
+    else
+    {
+        m_lastError = QString("Unknown element '%1' at %2").arg(m_description[pos]).arg(pos + 1);
+        return -2;
+    }
+
+    int start = pos++;
+    while ((pos < m_description.length()) && m_description[pos].isDigit())
+        pos++;
+
+    QString name = m_description.mid(start, pos - start).toUpper();
+    int node = addNode(type);
+
+    m_parameterNames.append(name);
+    m_upperBounds.append(INFINITY);
+
+    if (ENode_t::eQ == type)
+    {
+        m_parameterNames.append(name + "_n");
+        m_upperBounds.append(1.0); // n = 1 is an ideal capacitor
+    }
+
+    m_nodes[node].m_paramCount = m_parameterNames.size() - m_nodes[node].m_firstParam;
+    return node;
+}
+
+complex_t CCircuitModel::impedance(const double& omega, const double* params,
+                                   complex_t* grad) const
+{
+    Q_ASSERT(params);
+    Q_ASSERT(m_root >= 0);
+
+    return evaluate(m_root, omega, params, grad);
+}
+
+complex_t CCircuitModel::evaluate(const int& index, const double& omega,
+                                  const double* params, complex_t* grad) const
+{
+    const Node_t& node = m_nodes[index];
+    const double* p = params + node.m_firstParam;
+    complex_t* g = grad ? grad + node.m_firstParam : NULL;
+    const complex_t j(0, 1);
+
+    switch (node.m_type)
+    {
+        case ENode_t::eR:
+        {
+            if (g) g[0] = 1;
+            return p[0];
+        }
+
+        case ENode_t::eC:
+        {
+            complex_t z = 1.0 / (j * omega * p[0]);
+            if (g) g[0] = -z / p[0];
+            return z;
+        }
+
+        case ENode_t::eL:
+        {
+            if (g) g[0] = j * omega;
+            return j * omega * p[0];
+        }
+
+        case ENode_t::eQ:
+        {
+            // Z = 1 / (Q (j omega)^n)
+            complex_t lnJw(std::log(omega), M_PI / 2);
+            complex_t z = 1.0 / (p[0] * std::exp(p[1] * lnJw));
+            if (g)
+            {
+                g[0] = -z / p[0];
+                g[1] = -z * lnJw;
+            }
+            return z;
+        }
+
+        case ENode_t::eW:
+        {
+            complex_t unit = complex_t(1, -1) / std::sqrt(omega);
+            if (g) g[0] = unit;
+            return p[0] * unit;
+        }
+
+        case ENode_t::eSeries:
+        {
+            // children own disjoint parameter ranges, gradients just add up
+            complex_t z = 0;
+            for (int child : node.m_children)
+                z += evaluate(child, omega, params, grad);
+            return z;
+        }
+
+        case ENode_t::eParallel:
+        {
+            QVarLengthArray<complex_t, 8> branches(node.m_children.size());
+            complex_t y = 0;
+
+            for (int i = 0; i < node.m_children.size(); i++)
+            {
+                branches[i] = evaluate(node.m_children[i], omega, params, grad);
+                y += 1.0 / branches[i];
+            }
+
+            complex_t z = 1.0 / y;
+
+            // dZ/dZi = (Z / Zi)^2
+            if (grad)
+            {
+                for (int i = 0; i < node.m_children.size(); i++)
+                {
+                    const Node_t& child = m_nodes[node.m_children[i]];
+                    complex_t factor = (z / branches[i]) * (z / branches[i]);
+
+                    for (int k = 0; k < child.m_paramCount; k++)
+                        grad[child.m_firstParam + k] *= factor;
+                }
+            }
+            return z;
+        }
+    }
+
+    return 0;
+}
+
+QVector<double> CCircuitModel::initialGuess(const QVector<double>& omega,
+                                            const QVector<double>& re,
+                                            const QVector<double>& im) const
+{
+    QVector<double> guess(parameterCount(), 1.0);
+
+    if (omega.isEmpty())
+        return guess;
+
+    // high frequency intercept, low frequency span and the arc top
+    double reMin = re[0], reMax = re[0], omegaMin = omega[0];
+    double peak = -im[0], omegaPeak = omega[0];
+
+    for (int i = 1; i < omega.size(); i++)
+    {
+        reMin = qMin(reMin, re[i]);
+        reMax = qMax(reMax, re[i]);
+        omegaMin = qMin(omegaMin, omega[i]);
+
+        if (-im[i] > peak)
+        {
+            peak = -im[i];
+            omegaPeak = omega[i];
+        }
+    }
+
+    double span = qMax(reMax - reMin, 1e-3);
+    double first = (reMin > 0) ? reMin : span * 0.01;
+    bool firstResistor = true;
+
+    for (int i = 0; i < parameterCount(); i++)
+    {
+        QChar type = m_parameterNames[i][0];
+
+        if (m_parameterNames[i].endsWith("_n"))
+            guess[i] = 0.9;
+        else if (type == 'R')
+        {
+            guess[i] = firstResistor ? first : span;
+            firstResistor = false;
+        }
+        else if ((type == 'C') || (type == 'Q'))
+            guess[i] = 1.0 / (omegaPeak * span);
+        else if (type == 'L')
+            guess[i] = 1e-7;
+        else if (type == 'W')
+            guess[i] = span * std::sqrt(omegaMin) * 0.1;
+    }
+
+    return guess;
+}
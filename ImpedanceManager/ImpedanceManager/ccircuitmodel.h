@@ -0,0 +1,72 @@
+#ifndef CCIRCUITMODEL_H
+#define CCIRCUITMODEL_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <complex>
+
+typedef std::complex<double> complex_t;
+
+// Equivalent circuit compiled from a circuit string, e.g. "R0-p(R1,C1)".
+//
+//  R, C, L   resistor, capacitor, inductor             (1 parameter)
+//  Q         constant phase element Q, n               (2 parameters)
+//  W         semi-infinite Warburg, sigma              (1 parameter)
+//  a-b       a and b in series
+//  p(a,b)    a and b in parallel (any number of branches)
+//
+// Each element letter may be followed by digits naming it. Parameters are
+// numbered in the order the elements appear in the string.
+class CCircuitModel
+{
+public:
+    CCircuitModel();
+
+    int compile(const QString& description);
+    bool isValid() const { return !m_nodes.isEmpty(); }
+
+    const QString& description() const { return m_description; }
+    const QString& lastError() const { return m_lastError; }
+
+    int parameterCount() const { return m_parameterNames.size(); }
+    const QStringList& parameterNames() const { return m_parameterNames; }
+    double upperBound(const int& param) const { return m_upperBounds[param]; }
+
+    // Z(omega) and, if grad is given, dZ/dp for every parameter
+    complex_t impedance(const double& omega, const double* params,
+                        complex_t* grad = NULL) const;
+
+    QVector<double> initialGuess(const QVector<double>& omega,
+                                 const QVector<double>& re,
+                                 const QVector<double>& im) const;
+
+private:
+    enum class ENode_t { eSeries = 0, eParallel, eR, eC, eL, eQ, eW };
+
+    typedef struct
+    {
+        ENode_t m_type;
+        int m_firstParam;   // parameters of the node and all its children are
+        int m_paramCount;   // one contiguous range
+        QVector<int> m_children;
+    } Node_t;
+
+    int parseSeries(int& pos);
+    int parseTerm(int& pos);
+    int parseElement(int& pos);
+    int addNode(const ENode_t& type);
+
+    complex_t evaluate(const int& node, const double& omega, const double* params,
+                       complex_t* grad) const;
+
+    QString m_description;
+    QString m_lastError;
+    QVector<Node_t> m_nodes;
+    int m_root;
+
+    QStringList m_parameterNames;
+    QVector<double> m_upperBounds;
+};
+
+#endif // CCIRCUITMODEL_H
@@ -0,0 +1,298 @@
+#include "ccomparedialog.h"
+
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
+
+const int CCompareDialog::m_envelopeBins;
+
+CCompareDialog::CCompareDialog(QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle("Compare measurements");
+    resize(900, 600);
+    m_drawnPoints = 0;
+
+    m_pbAdd.setText("Add files...");
+    m_pbClear.setText("Clear");
+    m_labelColumn.setText("Value column");
+    m_cbColumn.addItem("2", 1);
+    m_cbColumn.addItem("3", 2);
+    m_cbColumn.addItem("4", 3);
+    m_cbEnvelope.setText("Mean +- stdev");
+    m_cbEnvelope.setChecked(true);
+    m_cbTraces.setText("Traces");
+    m_cbTraces.setChecked(true);
+
+    m_toolLayout.addWidget(&m_pbAdd);
+    m_toolLayout.addWidget(&m_pbClear);
+    m_toolLayout.addWidget(&m_labelColumn);
+    m_toolLayout.addWidget(&m_cbColumn);
+    m_toolLayout.addWidget(&m_cbEnvelope);
+    m_toolLayout.addWidget(&m_cbTraces);
+    m_toolLayout.addStretch();
+
+    mp_plot = new QCustomPlot(this);
+    m_layout.addLayout(&m_toolLayout);
+    m_layout.addWidget(mp_plot);
+    m_layout.addWidget(&m_labelStatus);
+    setLayout(&m_layout);
+
+    initPlot();
+
+    connect(&m_pbAdd, SIGNAL(clicked()), this, SLOT(on_pbAdd_clicked()));
+    connect(&m_pbClear, SIGNAL(clicked()), this, SLOT(on_pbClear_clicked()));
+    connect(&m_cbColumn, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(on_cbColumn_currentIndexChanged(int)));
+    connect(&m_cbEnvelope, SIGNAL(toggled(bool)), this, SLOT(on_cbEnvelope_toggled(bool)));
+    connect(&m_cbTraces, SIGNAL(toggled(bool)), this, SLOT(on_cbTraces_toggled(bool)));
+    connect(&m_loadWatcher, SIGNAL(finished()), this, SLOT(on_load_finished()));
+    connect(&m_envelopeWatcher, SIGNAL(finished()), this, SLOT(on_envelope_finished()));
+
+    m_decimateTimer.setSingleShot(true);
+    m_decimateTimer.setInterval(m_decimateDelay_ms);
+    connect(&m_decimateTimer, SIGNAL(timeout()), this, SLOT(on_decimate()));
+
+    updateStatus();
+}
+
+CCompareDialog::~CCompareDialog()
+{
+    m_loadWatcher.waitForFinished();
+    m_envelopeWatcher.waitForFinished();
+}
+
+void CCompareDialog::initPlot()
+{
+    mp_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    mp_plot->setNoAntialiasingOnDrag(true);
+    mp_plot->setPlottingHint(QCP::phFastPolylines, true);
+
+    for (int branch = 0; branch < CComparison::m_branches; branch++)
+    {
+        QCPGraph* mean = mp_plot->addGraph();
+        QCPGraph* upper = mp_plot->addGraph();
+        QCPGraph* lower = mp_plot->addGraph();
+
+        mean->setPen(QPen(Qt::black, 2));
+        upper->setPen(QPen(QColor(0, 0, 0, 60)));
+        lower->setPen(QPen(QColor(0, 0, 0, 60)));
+        upper->setBrush(QBrush(QColor(0, 0, 0, 40)));
+        upper->setChannelFillGraph(lower);
+
+        m_envelopeGraphs << mean << upper << lower;
+    }
+
+    connect(mp_plot->xAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(on_rangeChanged()));
+    connect(mp_plot->yAxis, SIGNAL(rangeChanged(QCPRange)), this, SLOT(on_rangeChanged()));
+}
+
+void CCompareDialog::resizeEvent(QResizeEvent* event)
+{
+    QDialog::resizeEvent(event);
+    on_rangeChanged();
+}
+
+void CCompareDialog::on_pbAdd_clicked()
+{
+    QStringList files = QFileDialog::getOpenFileNames(this, "Add measurements",
+                                                      QDir::currentPath(),
+                                                      tr("CSV Files (*.csv)"));
+    if (files.isEmpty())
+        return;
+
+    startLoad(files);
+}
+
+void CCompareDialog::startLoad(const QStringList& files)
+{
+    m_pbAdd.setEnabled(false);
+    m_cbColumn.setEnabled(false);
+    m_labelStatus.setText(QString("Loading %1 files...").arg(files.size()));
+
+    m_loadWatcher.setFuture(CComparison::startLoad(files,
+                                                   m_cbColumn.currentData().toInt()));
+}
+
+void CCompareDialog::on_load_finished()
+{
+    QVector<CComparison::Series_t> loaded = m_loadWatcher.result();
+    bool first = m_series.isEmpty();
+
+    // the column stays locked until the envelope of these series is in,
+    // a change meanwhile could not be followed
+    m_pbAdd.setEnabled(true);
+
+    for (const CComparison::Series_t& series : loaded)
+    {
+        // the color wheel in steps of the golden angle, neighbours differ
+        QColor color = QColor::fromHsv((m_series.size() * 137) % 360, 200, 200, 110);
+        QCPCurve* curve = new QCPCurve(mp_plot->xAxis, mp_plot->yAxis);
+        mp_plot->addPlottable(curve);
+        curve->setPen(QPen(color));
+        curve->setAntialiased(false);
+        curve->setName(QFileInfo(series.m_fileName).fileName());
+        curve->setVisible(m_cbTraces.isChecked());
+
+        m_series.append(series);
+        m_files.append(series.m_fileName);
+        m_curves.append(curve);
+    }
+
+    if (m_series.isEmpty())
+    {
+        m_cbColumn.setEnabled(true);
+        updateStatus();
+        return;
+    }
+
+    if (first)
+    {
+        mp_plot->xAxis->setLabel(m_series.first().m_xLabel);
+        mp_plot->yAxis->setLabel(m_series.first().m_yLabel);
+
+        double xMin = m_series.first().m_x.first();
+        double xMax = xMin;
+        double yMin = m_series.first().m_y.first();
+        double yMax = yMin;
+
+        for (const CComparison::Series_t& series : m_series)
+        {
+            for (int i = 0; i < series.m_x.size(); i++)
+            {
+                xMin = qMin(xMin, series.m_x[i]);
+                xMax = qMax(xMax, series.m_x[i]);
+                yMin = qMin(yMin, series.m_y[i]);
+                yMax = qMax(yMax, series.m_y[i]);
+            }
+        }
+
+        mp_plot->xAxis->setRange(xMin, xMax);
+        mp_plot->yAxis->setRange(yMin, yMax);
+    }
+
+    m_envelopeWatcher.setFuture(CComparison::startEnvelope(m_series, m_envelopeBins));
+    on_decimate();
+}
+
+void CCompareDialog::on_envelope_finished()
+{
+    QVector<CComparison::Envelope_t> envelopes = m_envelopeWatcher.result();
+
+    for (int branch = 0; branch < envelopes.size(); branch++)
+    {
+        const CComparison::Envelope_t& env = envelopes[branch];
+        QVector<double> upper(env.m_x.size());
+        QVector<double> lower(env.m_x.size());
+
+        for (int i = 0; i < env.m_x.size(); i++)
+        {
+            upper[i] = env.m_mean[i] + env.m_stdev[i];
+            lower[i] = env.m_mean[i] - env.m_stdev[i];
+        }
+
+        m_envelopeGraphs[3 * branch]->setData(env.m_x, env.m_mean);
+        m_envelopeGraphs[3 * branch + 1]->setData(env.m_x, upper);
+        m_envelopeGraphs[3 * branch + 2]->setData(env.m_x, lower);
+    }
+
+    on_cbEnvelope_toggled(m_cbEnvelope.isChecked());
+
+    if (!m_loadWatcher.isRunning())
+        m_cbColumn.setEnabled(true);
+}
+
+void CCompareDialog::on_rangeChanged()
+{
+    if (!m_series.isEmpty())
+        m_decimateTimer.start();
+}
+
+void CCompareDialog::on_decimate()
+{
+    QRect rect = mp_plot->axisRect()->rect();
+    if (rect.isEmpty())
+        return;
+
+    QVector<CComparison::DecimateJob_t> jobs(m_series.size());
+    for (int i = 0; i < m_series.size(); i++)
+    {
+        jobs[i].mp_series = &m_series[i];
+        jobs[i].m_xPerPixel = mp_plot->xAxis->range().size() / rect.width();
+        jobs[i].m_yPerPixel = mp_plot->yAxis->range().size() / rect.height();
+    }
+
+    CComparison::decimate(jobs);
+
+    m_drawnPoints = 0;
+    for (int i = 0; i < jobs.size(); i++)
+    {
+        m_curves[i]->setData(jobs[i].m_x, jobs[i].m_y);
+        m_drawnPoints += jobs[i].m_x.size();
+    }
+
+    updateStatus();
+    mp_plot->replot();
+}
+
+void CCompareDialog::removeTraces()
+{
+    for (QCPCurve* curve : m_curves)
+        mp_plot->removePlottable(curve);
+
+    for (QCPGraph* graph : m_envelopeGraphs)
+        graph->clearData();
+
+    m_curves.clear();
+    m_series.clear();
+    m_files.clear();
+    m_drawnPoints = 0;
+}
+
+void CCompareDialog::on_pbClear_clicked()
+{
+    if (m_loadWatcher.isRunning() || m_envelopeWatcher.isRunning())
+        return;
+
+    removeTraces();
+    updateStatus();
+    mp_plot->replot();
+}
+
+void CCompareDialog::on_cbColumn_currentIndexChanged(int index)
+{
+    Q_UNUSED(index);
+
+    if (m_files.isEmpty() || m_loadWatcher.isRunning() || m_envelopeWatcher.isRunning())
+        return;
+
+    QStringList files = m_files;
+    removeTraces();
+    startLoad(files);
+}
+
+void CCompareDialog::on_cbEnvelope_toggled(bool checked)
+{
+    for (QCPGraph* graph : m_envelopeGraphs)
+        graph->setVisible(checked);
+
+    mp_plot->replot();
+}
+
+void CCompareDialog::on_cbTraces_toggled(bool checked)
+{
+    for (QCPCurve* curve : m_curves)
+        curve->setVisible(checked);
+
+    mp_plot->replot();
+}
+
+void CCompareDialog::updateStatus()
+{
+    int points = 0;
+    for (const CComparison::Series_t& series : m_series)
+        points += series.m_x.size();
+
+    m_labelStatus.setText(QString("%1 runs, %2 points, %3 drawn")
+                          .arg(m_series.size()).arg(points).arg(m_drawnPoints));
+}
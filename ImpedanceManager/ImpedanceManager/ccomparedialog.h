@@ -0,0 +1,73 @@
+#ifndef CCOMPAREDIALOG_H
+#define CCOMPAREDIALOG_H
+
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QLabel>
+#include <QTimer>
+#include <QFutureWatcher>
+
+#include "qcustomplot.h"
+#include "ccomparison.h"
+
+// Non modal workspace overlaying many exported measurements (CSV) on one
+// plot, with the mean +- standard deviation envelope across them. Every
+// trace is decimated to the plot resolution again when the view changes,
+// so hundreds of traces stay interactive.
+class CCompareDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CCompareDialog(QWidget *parent = 0);
+    ~CCompareDialog();
+
+protected:
+    void resizeEvent(QResizeEvent* event);
+
+private slots:
+    void on_pbAdd_clicked();
+    void on_pbClear_clicked();
+    void on_cbColumn_currentIndexChanged(int index);
+    void on_cbEnvelope_toggled(bool checked);
+    void on_cbTraces_toggled(bool checked);
+    void on_load_finished();
+    void on_envelope_finished();
+    void on_rangeChanged();
+    void on_decimate();
+
+private:
+    void initPlot();
+    void startLoad(const QStringList& files);
+    void removeTraces();
+    void updateStatus();
+
+    QVBoxLayout m_layout;
+    QHBoxLayout m_toolLayout;
+    QPushButton m_pbAdd;
+    QPushButton m_pbClear;
+    QLabel m_labelColumn;
+    QComboBox m_cbColumn;
+    QCheckBox m_cbEnvelope;
+    QCheckBox m_cbTraces;
+    QLabel m_labelStatus;
+    QCustomPlot* mp_plot;
+
+    QStringList m_files;                    // loaded, for a reload with another column
+    QVector<CComparison::Series_t> m_series;
+    QVector<QCPCurve*> m_curves;
+    QVector<QCPGraph*> m_envelopeGraphs;    // mean, upper, lower per branch
+    QFutureWatcher<QVector<CComparison::Series_t> > m_loadWatcher;
+    QFutureWatcher<QVector<CComparison::Envelope_t> > m_envelopeWatcher;
+    QTimer m_decimateTimer;
+    int m_drawnPoints;
+
+    static const int m_envelopeBins = 256;
+    static const int m_decimateDelay_ms = 30; // one pass per burst of range changes
+};
+
+#endif // CCOMPAREDIALOG_H
@@ -0,0 +1,186 @@
+#include "ccomparison.h"
+#include "ccsvreader.h"
+
+#include <QtConcurrent>
+#include <QDebug>
+#include <cmath>
+
+void CComparison::loadJob(LoadJob_t& job)
+{
+    CCsvReader::Table_t table;
+    job.m_valid = false;
+
+    if (CCsvReader::read(job.m_fileName, table))
+        return;
+
+    if (job.m_yColumn >= table.m_columns.size())
+    {
+        qWarning() << job.m_fileName << "has no column" << job.m_yColumn + 1;
+        return;
+    }
+
+    job.m_series.m_fileName = job.m_fileName;
+    job.m_series.m_xLabel = table.m_header.first();
+    job.m_series.m_yLabel = table.m_header[job.m_yColumn];
+    job.m_series.m_x = table.m_columns.first();
+    job.m_series.m_y = table.m_columns[job.m_yColumn];
+    job.m_valid = !job.m_series.m_x.isEmpty();
+}
+
+QVector<CComparison::Series_t> CComparison::load(const QStringList& files, const int& yColumn)
+{
+    QVector<LoadJob_t> jobs(files.size());
+    for (int i = 0; i < files.size(); i++)
+    {
+        jobs[i].m_fileName = files[i];
+        jobs[i].m_yColumn = yColumn;
+    }
+
+    QtConcurrent::blockingMap(jobs, loadJob);
+
+    QVector<Series_t> series;
+    for (const LoadJob_t& job : jobs)
+    {
+        if (job.m_valid)
+            series.append(job.m_series);
+    }
+
+    return series;
+}
+
+QFuture<QVector<CComparison::Series_t> > CComparison::startLoad(const QStringList& files,
+                                                               const int& yColumn)
+{
+    return QtConcurrent::run(load, files, yColumn);
+}
+
+void CComparison::binJob(BinJob_t& job)
+{
+    const QVector<double>& x = job.mp_series->m_x;
+    const QVector<double>& y = job.mp_series->m_y;
+    int branch = 0;
+
+    job.m_sum.fill(0, m_branches * job.m_bins);
+    job.m_count.fill(0, m_branches * job.m_bins);
+
+    for (int i = 0; i < x.size(); i++)
+    {
+        // direction of the sweep, a step of 0 keeps the last one
+        double dx = (i + 1 < x.size()) ? x[i + 1] - x[i] : x[i] - x[qMax(i - 1, 0)];
+        if (dx > 0)
+            branch = 0;
+        else if (dx < 0)
+            branch = 1;
+
+        int bin = qBound(0, (int)((x[i] - job.m_xMin) / job.m_binWidth), job.m_bins - 1);
+        job.m_sum[branch * job.m_bins + bin] += y[i];
+        job.m_count[branch * job.m_bins + bin]++;
+    }
+}
+
+QVector<CComparison::Envelope_t> CComparison::envelope(const QVector<Series_t>& series,
+                                                       const int& bins)
+{
+    QVector<Envelope_t> result(m_branches);
+    if (series.isEmpty() || (bins < 1))
+        return result;
+
+    double xMin = series.first().m_x.first();
+    double xMax = xMin;
+    for (const Series_t& item : series)
+    {
+        for (const double& x : item.m_x)
+        {
+            xMin = qMin(xMin, x);
+            xMax = qMax(xMax, x);
+        }
+    }
+
+    double binWidth = (xMax > xMin) ? (xMax - xMin) / bins : 1;
+
+    // every run binned on its own in parallel, the runs are combined after
+    QVector<BinJob_t> jobs(series.size());
+    for (int i = 0; i < series.size(); i++)
+    {
+        jobs[i].mp_series = &series[i];
+        jobs[i].m_xMin = xMin;
+        jobs[i].m_binWidth = binWidth;
+        jobs[i].m_bins = bins;
+    }
+
+    QtConcurrent::blockingMap(jobs, binJob);
+
+    for (int branch = 0; branch < m_branches; branch++)
+    {
+        Envelope_t& env = result[branch];
+
+        for (int bin = 0; bin < bins; bin++)
+        {
+            const int k = branch * bins + bin;
+            double mean = 0;
+            double m2 = 0;
+            int runs = 0;
+
+            // Welford over the runs' means in the bin
+            for (const BinJob_t& job : jobs)
+            {
+                if (!job.m_count[k])
+                    continue;
+
+                double value = job.m_sum[k] / job.m_count[k];
+                double delta = value - mean;
+                runs++;
+                mean += delta / runs;
+                m2 += delta * (value - mean);
+            }
+
+            if (!runs)
+                continue;
+
+            env.m_x.append(xMin + (bin + 0.5) * binWidth);
+            env.m_mean.append(mean);
+            env.m_stdev.append((runs > 1) ? std::sqrt(m2 / (runs - 1)) : 0);
+            env.m_runs.append(runs);
+        }
+    }
+
+    return result;
+}
+
+QFuture<QVector<CComparison::Envelope_t> > CComparison::startEnvelope(
+        const QVector<Series_t>& series, const int& bins)
+{
+    return QtConcurrent::run(envelope, series, bins);
+}
+
+void CComparison::decimateJob(DecimateJob_t& job)
+{
+    const QVector<double>& x = job.mp_series->m_x;
+    const QVector<double>& y = job.mp_series->m_y;
+    const double dxMin = job.m_xPerPixel / 2;
+    const double dyMin = job.m_yPerPixel / 2;
+
+    job.m_x.resize(0);
+    job.m_y.resize(0);
+    if (x.isEmpty())
+        return;
+
+    job.m_x.append(x.first());
+    job.m_y.append(y.first());
+
+    for (int i = 1; i < x.size(); i++)
+    {
+        if ((std::fabs(x[i] - job.m_x.last()) >= dxMin) ||
+            (std::fabs(y[i] - job.m_y.last()) >= dyMin) ||
+            (i == x.size() - 1))
+        {
+            job.m_x.append(x[i]);
+            job.m_y.append(y[i]);
+        }
+    }
+}
+
+void CComparison::decimate(QVector<DecimateJob_t>& jobs)
+{
+    QtConcurrent::blockingMap(jobs, decimateJob);
+}
@@ -0,0 +1,82 @@
+#ifndef CCOMPARISON_H
+#define CCOMPARISON_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QFuture>
+
+// Data side of the comparison of many saved measurements (CSV exports):
+// loading them on the thread pool, the mean / standard deviation envelope
+// across the runs and the decimation of every trace to the plot resolution.
+class CComparison
+{
+public:
+    typedef struct
+    {
+        QString m_fileName;
+        QString m_xLabel;
+        QString m_yLabel;
+        QVector<double> m_x;
+        QVector<double> m_y;
+    } Series_t;
+
+    // statistics of the runs over x bins, for one sweep direction; a run
+    // takes part in a bin with the mean of its samples there
+    typedef struct
+    {
+        QVector<double> m_x;        // centers of the bins with at least one run
+        QVector<double> m_mean;
+        QVector<double> m_stdev;
+        QVector<int> m_runs;
+    } Envelope_t;
+
+    typedef struct
+    {
+        const Series_t* mp_series;
+        double m_xPerPixel;
+        double m_yPerPixel;
+        QVector<double> m_x;
+        QVector<double> m_y;
+    } DecimateJob_t;
+
+    // column 0 is x, yColumn the value; unreadable files are left out
+    static QVector<Series_t> load(const QStringList& files, const int& yColumn);
+    static QFuture<QVector<Series_t> > startLoad(const QStringList& files, const int& yColumn);
+
+    // m_branches envelopes: rising x, falling x (the return of a CV cycle)
+    static QVector<Envelope_t> envelope(const QVector<Series_t>& series, const int& bins);
+    static QFuture<QVector<Envelope_t> > startEnvelope(const QVector<Series_t>& series,
+                                                       const int& bins);
+
+    // keeps a point once it is half a pixel away from the last one kept, in
+    // parallel over the jobs
+    static void decimate(QVector<DecimateJob_t>& jobs);
+
+    static const int m_branches = 2;
+
+private:
+    typedef struct
+    {
+        QString m_fileName;
+        int m_yColumn;
+        Series_t m_series;
+        bool m_valid;
+    } LoadJob_t;
+
+    typedef struct
+    {
+        const Series_t* mp_series;
+        double m_xMin;
+        double m_binWidth;
+        int m_bins;
+        QVector<double> m_sum;      // [branch * m_bins + bin]
+        QVector<int> m_count;
+    } BinJob_t;
+
+    static void loadJob(LoadJob_t& job);
+    static void binJob(BinJob_t& job);
+    static void decimateJob(DecimateJob_t& job);
+};
+
+#endif // CCOMPARISON_H
@@ -0,0 +1,25 @@
+#ifndef CCRC16_H
+#define CCRC16_H
+
+#include <QtGlobal>
+
+// CRC-16-CCITT (polynomial 0x1021, init 0xFFFF, no reflection), table driven,
+// one table lookup per byte. update() is inline, so the frame decoder can
+// verify the checksum byte by byte while the frame streams in.
+class CCrc16
+{
+public:
+    static inline quint16 update(const quint16& crc, const quint8& data)
+    {
+        return (quint16)((crc << 8) ^ m_table[((crc >> 8) ^ data) & 0xFF]);
+    }
+
+    static quint16 compute(const char* data, const int& length, quint16 crc = m_init);
+
+    static const quint16 m_init = 0xFFFF;
+
+private:
+    static const quint16 m_table[256];
+};
+
+#endif // CCRC16_H
@@ -0,0 +1,290 @@
+#include "ccsvreader.h"
+
+#include <QFile>
+#include <QThread>
+#include <QVarLengthArray>
+#include <QtConcurrent>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+EMeasures_t CCsvReader::measureOf(const QStringList& header)
+{
+    // the headers written by the projects' saveToCsv
+    if (header.size() < 2)
+        return EMeasures_t::eDummy;
+
+    if ((header.first() == "Real[Ohm]") && (header.size() >= 3))
+        return EMeasures_t::eEIS;
+    if (header.first() == "Time[s]")
+        return EMeasures_t::eCA;
+    if (header.first() == "Voltage[V]")
+        return EMeasures_t::eCV;
+    if ((header.first() == "Voltage[mV]") && (header.size() >= 4))
+        return EMeasures_t::eSWV;
+    if (header.first() == "Voltage[mV]")
+        return EMeasures_t::eDPV;
+
+    return EMeasures_t::eDummy;
+}
+
+const char* CCsvReader::parseDouble(const char* begin, const char* end, double& value)
+{
+    // exact powers of ten, a mantissa below 2^53 scaled by one of them is
+    // rounded once
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                     1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+                                     1e20, 1e21, 1e22 };
+    const char* p = begin;
+    bool negative = false;
+
+    while ((p < end) && ((*p == ' ') || (*p == '\t')))
+        p++;
+
+    if ((p < end) && ((*p == '-') || (*p == '+')))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // QString::number writes inf and nan
+    if ((end - p >= 3) && (!qstrnicmp(p, "inf", 3) || !qstrnicmp(p, "nan", 3)))
+    {
+        value = ((*p | 0x20) == 'i') ? std::numeric_limits<double>::infinity()
+                                     : std::numeric_limits<double>::quiet_NaN();
+        if (negative)
+            value = -value;
+        return p + 3;
+    }
+
+    quint64 mantissa = 0;
+    int exponent = 0;
+    bool digits = false;
+
+    // 19 digits fit, the rest only moves the exponent
+    for (; (p < end) && ((unsigned)(*p - '0') < 10); p++, digits = true)
+    {
+        if (mantissa < Q_UINT64_C(1000000000000000000))
+            mantissa = mantissa * 10 + (*p - '0');
+        else
+            exponent++;
+    }
+
+    if ((p < end) && (*p == '.'))
+    {
+        for (p++; (p < end) && ((unsigned)(*p - '0') < 10); p++, digits = true)
+        {
+            if (mantissa < Q_UINT64_C(1000000000000000000))
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            }
+        }
+    }
+
+    if (!digits)
+        return begin;
+
+    if ((p < end) && ((*p == 'e') || (*p == 'E')))
+    {
+        const char* q = p + 1;
+        bool negativeExp = false;
+        int exp = 0;
+
+        if ((q < end) && ((*q == '-') || (*q == '+')))
+        {
+            negativeExp = (*q == '-');
+            q++;
+        }
+
+        if ((q < end) && ((unsigned)(*q - '0') < 10))
+        {
+            for (; (q < end) && ((unsigned)(*q - '0') < 10); q++)
+                exp = qMin(exp * 10 + (*q - '0'), 100000);
+
+            exponent += negativeExp ? -exp : exp;
+            p = q;
+        }
+    }
+
+    value = (double)mantissa;
+    if ((exponent < 0) && (exponent >= -22))
+        value /= powers[-exponent];
+    else if ((exponent > 0) && (exponent <= 22))
+        value *= powers[exponent];
+    else if (exponent)
+        value *= std::pow(10.0, exponent);
+
+    if (negative)
+        value = -value;
+
+    return p;
+}
+
+void CCsvReader::parseChunk(Chunk_t& chunk)
+{
+    const char* p = chunk.mp_begin;
+    const char* end = chunk.mp_end;
+    const int columns = chunk.m_columnCount;
+    QVarLengthArray<double, 8> row(columns);
+
+    chunk.m_skipped = 0;
+    chunk.m_columns.resize(columns);
+
+    // rows of this chunk, guessed from its first one
+    const char* firstEnd = (const char*)memchr(p, '\n', end - p);
+    if (firstEnd && (firstEnd > p))
+    {
+        int rows = (int)((end - p) / (firstEnd - p + 1) * 1.1) + 16;
+        for (int c = 0; c < columns; c++)
+            chunk.m_columns[c].reserve(rows);
+    }
+
+    while (p < end)
+    {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (!lineEnd)
+            lineEnd = end;
+
+        const char* q = p;
+        bool ok = true;
+        bool empty = true;
+
+        for (const char* s = p; s < lineEnd; s++)
+        {
+            if ((*s != ' ') && (*s != '\t') && (*s != '\r'))
+            {
+                empty = false;
+                break;
+            }
+        }
+
+        for (int c = 0; (c < columns) && ok && !empty; c++)
+        {
+            const char* next = parseDouble(q, lineEnd, row[c]);
+            ok = (next != q);
+            q = next;
+
+            // fields end with a comma, the last one may be followed by more
+            while ((q < lineEnd) && ((*q == ' ') || (*q == '\t') || (*q == '\r')))
+                q++;
+            if (ok && (c < columns - 1))
+            {
+                ok = (q < lineEnd) && (*q == ',');
+                q++;
+            }
+            else if (ok && (q < lineEnd) && (*q != ','))
+                ok = false;
+        }
+
+        if (empty)
+            ;
+        else if (ok)
+        {
+            for (int c = 0; c < columns; c++)
+                chunk.m_columns[c].append(row[c]);
+        }
+        else
+            chunk.m_skipped++;
+
+        p = lineEnd + 1;
+    }
+}
+
+int CCsvReader::read(const QString& fileName, Table_t& table)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Cannot open" << fileName << file.errorString();
+        return -1;
+    }
+
+    const qint64 size = file.size();
+    if (!size)
+    {
+        qWarning() << fileName << "is empty";
+        return -1;
+    }
+
+    // a file that cannot be mapped (pipe, some file systems) is read whole
+    QByteArray content;
+    const char* data = (const char*)file.map(0, size);
+    if (!data)
+    {
+        content = file.readAll();
+        data = content.constData();
+    }
+
+    const char* end = data + size;
+    const char* headerEnd = (const char*)memchr(data, '\n', size);
+    if (!headerEnd)
+        headerEnd = end;
+
+    table.m_fileName = fileName;
+    table.m_header = QString::fromUtf8(data, headerEnd - data).trimmed().split(',');
+    table.m_columns.clear();
+    table.m_columns.resize(table.m_header.size());
+
+    // chunks end after a newline, so every row lands in exactly one
+    const char* body = qMin(headerEnd + 1, end);
+    qint64 bodySize = end - body;
+    int count = (int)qBound(Q_INT64_C(1), bodySize / m_minChunkSize,
+                            (qint64)QThread::idealThreadCount() * m_chunksPerThread);
+
+    QVector<Chunk_t> chunks(count);
+    const char* begin = body;
+    for (int i = 0; i < count; i++)
+    {
+        const char* chunkEnd = (i == count - 1) ? end : body + bodySize * (i + 1) / count;
+        if (chunkEnd < begin)
+            chunkEnd = begin;
+
+        const char* newline = (const char*)memchr(chunkEnd, '\n', end - chunkEnd);
+        chunkEnd = newline ? newline + 1 : end;
+
+        chunks[i].mp_begin = begin;
+        chunks[i].mp_end = chunkEnd;
+        chunks[i].m_columnCount = table.m_columns.size();
+        begin = chunkEnd;
+    }
+
+    if (count > 1)
+        QtConcurrent::blockingMap(chunks, parseChunk);
+    else
+        parseChunk(chunks[0]);
+
+    int rows = 0;
+    int skipped = 0;
+    for (const Chunk_t& chunk : chunks)
+    {
+        rows += chunk.m_columns.isEmpty() ? 0 : chunk.m_columns.first().size();
+        skipped += chunk.m_skipped;
+    }
+
+    for (int c = 0; c < table.m_columns.size(); c++)
+    {
+        if (1 == count)
+        {
+            table.m_columns[c] = chunks[0].m_columns[c];
+            continue;
+        }
+
+        table.m_columns[c].resize(rows);
+        double* out = table.m_columns[c].data();
+        for (const Chunk_t& chunk : chunks)
+        {
+            memcpy(out, chunk.m_columns[c].constData(), chunk.m_columns[c].size() * sizeof(double));
+            out += chunk.m_columns[c].size();
+        }
+    }
+
+    if (content.isEmpty())
+        file.unmap((uchar*)data);
+
+    if (skipped)
+        qWarning() << fileName << ":" << skipped << "rows skipped";
+
+    return 0;
+}
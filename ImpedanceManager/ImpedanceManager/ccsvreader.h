@@ -0,0 +1,53 @@
+#ifndef CCSVREADER_H
+#define CCSVREADER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "MeasureUtility.h"
+
+using namespace MeasureUtility;
+
+// Reads the CSV files written by the projects' saveToCsv: one header line
+// with the column names, then rows of numbers separated by commas. The file
+// is memory mapped and cut into line aligned chunks that are parsed on the
+// thread pool, without locale or allocations per field, then joined in
+// order.
+class CCsvReader
+{
+public:
+    typedef struct
+    {
+        QString m_fileName;
+        QStringList m_header;
+        QVector<QVector<double> > m_columns;    // m_columns[c][row]
+    } Table_t;
+
+    // 0 on success, rows that do not parse are skipped and counted
+    static int read(const QString& fileName, Table_t& table);
+
+    // technique of the project that wrote the header, eDummy if none
+    static EMeasures_t measureOf(const QStringList& header);
+
+    // from_chars style: the number at begin, returns the character after
+    // it, or begin when there is none
+    static const char* parseDouble(const char* begin, const char* end, double& value);
+
+    static const qint64 m_minChunkSize = 1 << 20;  // smaller bodies are one chunk
+    static const int m_chunksPerThread = 4;
+
+private:
+    typedef struct
+    {
+        const char* mp_begin;       // first character of the first row
+        const char* mp_end;         // after the last row
+        int m_columnCount;
+        QVector<QVector<double> > m_columns;
+        int m_skipped;
+    } Chunk_t;
+
+    static void parseChunk(Chunk_t& chunk);
+};
+
+#endif // CCSVREADER_H
@@ -1,4 +1,7 @@
 #include "ccvproject.h"
+#include "cmeasurelimits.h"
+
+#include <cmath>
 
 CCvProject::CCvProject(CSerialThread* serialThread, QWidget* parent) :
     CGenericProject(serialThread, parent)
@@ -8,6 +11,7 @@ CCvProject::CCvProject(CSerialThread* serialThread, QWidget* parent) :
 
     initPlot();
     initFields();
+    initFilter();
 
     mp_serialThread = serialThread;
     updateTree();
@@ -50,6 +54,7 @@ void CCvProject::initPlot()
     customPlot->addPlottable(customCurve);
     customCurve->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
     customCurve->setName("CV measure");
+    m_cycleCurves.append(customCurve);
 
     /*customPlot->addGraph();
     customPlot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
@@ -112,32 +117,25 @@ void CCvProject::initFields()
     m_leNrOfCycles.setValidator(mv8Validator);
     m_lePotStep.setValidator(mv16Validator);
     m_leScanSpeed.setValidator(mv16ValidatorPositive);
+
+    // per cycle peaks
+    m_labelCycles.setFont(QFont("Courier", 8));
+    m_labelCycles.setAlignment(Qt::AlignTop | Qt::AlignLeft);
+    ui->glControls->addWidget(&m_labelCycles, 6, 0, 1, 2);
 }
 
-void CCvProject::takeMeasure()
+int CCvProject::takeMeasure()
 {
     bool ok;
-    QString badParameters;
 
     qint16 potStart = (qint16)m_lePotStart.text().toInt(&ok, 10);
-    if (!potStart)
-        badParameters += m_labelPotStart.text() + "\n";
-
     qint16 potEnd = (qint16)m_lePotEnd.text().toInt(&ok, 10);
-    if (!potEnd)
-        badParameters += m_labelPotEnd.text() + "\n";
-
     qint16 potStep = (qint16)m_lePotStep.text().toInt(&ok, 10);
-    if (!potStep)
-        badParameters += m_labelPotStep.text() + "\n";
-
     quint8 nrOfCycles = (quint8)m_leNrOfCycles.text().toInt(&ok, 10);
-    if (!nrOfCycles)
-        badParameters += m_labelNrOfCycles.text() + "\n";
-
     qint16 scanDelay = (qint16)m_leScanSpeed.text().toInt(&ok, 10);
-    if (!scanDelay)
-        badParameters += m_labelScanSpeed.text() + "\n";
+
+    QString badParameters = CMeasureLimits::checkCv(potStart, potEnd, nrOfCycles, potStep,
+                                                    scanDelay);
 
     if(badParameters.length())
     {
@@ -146,12 +144,14 @@ void CCvProject::takeMeasure()
         msgBox.setText("Empty fields detected!");
         msgBox.setInformativeText(badParameters);
         msgBox.exec();
-        return;
+        return -1;
     }
 
     clearData();
+    clearCycles();
     qDebug() << "Sending CV measure request";
     emit send_takeMeasCv(potStart, potEnd, nrOfCycles, potStep, scanDelay);
+    return 0;
 }
 
 void CCvProject::changeConnections(const bool con)
@@ -212,22 +212,78 @@ void CCvProject::on_received_giveMeasChunkCv(const quint16& sample,
                                              const union32_t& current,
                                              const union32_t& voltage)
 {
-    float lcur = current.idFl / 10000000;
-    float lvol = voltage.idFl / 1000;
+    MeasSample_t cvSample;
+    cvSample.m_index = sample;
+    cvSample.m_data[0] = current.idFl;
+    cvSample.m_data[1] = voltage.idFl;
+
+    ingestSample(cvSample);
+    updatePlot();
+}
+
+void CCvProject::ingestSample(const MeasSample_t& sample)
+{
+    float lcur = sample.m_data[0] / 10000000;
+    float lvol = sample.m_data[1] / 1000;
 
     m_x.append(lvol);
     m_y.append(lcur);
 
-    addCvPoint(lcur, lvol);
+    if (m_segmenter.addSample(lvol, lcur))
+    {
+        startCycleCurve(m_segmenter.currentCycle());
+        updateCycleSummary();
+    }
+
+    addCvPoint(lcur, lvol, m_segmenter.currentCycle());
     //customPlot->graph(0)->addData(lvol, lcur);
-    customCurve->addData(sample, lvol, lcur);
-    autoScalePlot();
+    m_cycleCurves.last()->addData(sample.m_index, lvol, lcur);
+    filterSample(lvol, lcur);
+}
 
-    qDebug("CV point received. Samp: %u Vol: %f Cur %f", sample, lvol, lcur);
+int CCvProject::importSamples(const CCsvReader::Table_t& table)
+{
+    // Voltage[V],Current[A], the cycles are found again
+    if (table.m_columns.size() < 2)
+        return -1;
+
+    m_x = table.m_columns[0];
+    m_y = table.m_columns[1];
+
+    QVector<QVector<double> > keys(1), voltages(1), currents(1);
+    QList<QTreeWidgetItem*> items;
+
+    for (int i = 0; i < m_x.size(); i++)
+    {
+        if (m_segmenter.addSample(m_x[i], m_y[i]))
+        {
+            startCycleCurve(m_segmenter.currentCycle());
+            keys.resize(m_cycleCurves.size());
+            voltages.resize(m_cycleCurves.size());
+            currents.resize(m_cycleCurves.size());
+        }
+
+        keys.last().append(i);
+        voltages.last().append(m_x[i]);
+        currents.last().append(m_y[i]);
+
+        if (i < m_maxListedPoints)
+            items.append(cvItem(m_y[i], m_x[i], m_segmenter.currentCycle()));
+    }
+
+    for (int i = 0; i < m_cycleCurves.size(); i++)
+        m_cycleCurves[i]->setData(keys[i], voltages[i], currents[i]);
+
+    ui->twPoints->addTopLevelItems(items);
+    updateCycleSummary();
+    return 0;
 }
 
 void CCvProject::on_received_endMeasCv()
 {
+    drainSamples();
+    applyFilter();
+    updateCycleSummary();
     insertLabels();
     emit measureFinished();
 }
@@ -235,12 +291,65 @@ void CCvProject::on_received_endMeasCv()
 void CCvProject::updateTree()
 {
     QStringList list;
-    list << QObject::tr("Voltage[V]") << QObject::tr("Current[A]");
+    list << QObject::tr("Voltage[V]") << QObject::tr("Current[A]") << QObject::tr("Cycle");
 
     ui->twPoints->setColumnCount(list.size());
     ui->twPoints->setHeaderLabels(list);
     ui->twPoints->header()->resizeSection(0, 100);
     ui->twPoints->header()->resizeSection(1, 100);
+    ui->twPoints->header()->resizeSection(2, 40);
+}
+
+void CCvProject::startCycleCurve(const int& cycle)
+{
+    // the first cycle goes to customCurve, the base class handles its data
+    if (cycle < m_cycleCurves.size())
+        return;
+
+    static const Qt::GlobalColor colors[] = { Qt::blue, Qt::red, Qt::darkGreen,
+                                              Qt::magenta, Qt::darkCyan, Qt::darkYellow };
+    const int colorCount = sizeof(colors) / sizeof(colors[0]);
+
+    QCPCurve* curve = new QCPCurve(customPlot->xAxis, customPlot->yAxis);
+    customPlot->addPlottable(curve);
+    curve->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
+    curve->setPen(QPen(colors[cycle % colorCount]));
+    curve->setName(QString("CV cycle %1").arg(cycle + 1));
+    m_cycleCurves.append(curve);
+}
+
+void CCvProject::clearCycles()
+{
+    for (int i = 1; i < m_cycleCurves.size(); i++)
+        customPlot->removePlottable(m_cycleCurves[i]);
+
+    m_cycleCurves.resize(1);
+    m_segmenter.reset();
+    m_labelCycles.clear();
+}
+
+void CCvProject::updateCycleSummary()
+{
+    QString summary;
+    const QVector<CCvSegmenter::Cycle_t>& cycles = m_segmenter.cycles();
+
+    for (int i = 0; i < cycles.size(); i++)
+    {
+        const CCvSegmenter::Cycle_t& cycle = cycles[i];
+        double separation = CCvSegmenter::peakSeparation(cycle);
+
+        if (std::isnan(separation))
+            continue;
+
+        summary += QString("%1: Epa=%2V Epc=%3V\n   dEp=%4mV ipa/ipc=%5\n")
+                .arg(i + 1)
+                .arg(cycle.m_anodic.m_potential, 0, 'f', 3)
+                .arg(cycle.m_cathodic.m_potential, 0, 'f', 3)
+                .arg(separation * 1000, 0, 'f', 0)
+                .arg(CCvSegmenter::peakRatio(cycle), 0, 'f', 2);
+    }
+
+    m_labelCycles.setText(summary);
 }
 
 int CCvProject::insertLabels()
@@ -277,14 +386,21 @@ int CCvProject::insertLabels()
     return 0;
 }
 
-void CCvProject::addCvPoint(const float& current, const float& voltage)
+void CCvProject::addCvPoint(const float& current, const float& voltage, const int& cycle)
 {
-    QTreeWidgetItem* item = new QTreeWidgetItem(ui->twPoints);
+    ui->twPoints->addTopLevelItem(cvItem(current, voltage, cycle));
+    ui->twPoints->scrollToBottom();
+}
+
+QTreeWidgetItem* CCvProject::cvItem(const float& current, const float& voltage, const int& cycle)
+{
+    QTreeWidgetItem* item = new QTreeWidgetItem();
 
     item->setText(0, QString::number(voltage, 'e', 2));
     item->setText(1, QString::number(current, 'e', 2));
+    item->setText(2, QString::number(cycle + 1));
 
-    ui->twPoints->scrollToBottom();
+    return item;
 }
 
 int CCvProject::saveToCsv(QIODevice* device)
@@ -309,6 +425,64 @@ int CCvProject::saveToCsv(QIODevice* device)
     return 0;
 }
 
+int CCvProject::saveProjectAs(QFile& file)
+{
+    qDebug() << "Saving CV project.";
+
+    QList<SettingParam_t> paramList;
+    SettingParam_t param;
+
+    param.m_name = "measType";
+    param.m_value = QString("%1").arg((int)measureType());
+    paramList.append(param);
+
+    param.m_name = "potStart";
+    param.m_value = m_lePotStart.text();
+    paramList.append(param);
+
+    param.m_name = "potEnd";
+    param.m_value = m_lePotEnd.text();
+    paramList.append(param);
+
+    param.m_name = "nrOfCycles";
+    param.m_value = m_leNrOfCycles.text();
+    paramList.append(param);
+
+    param.m_name = "potStep";
+    param.m_value = m_lePotStep.text();
+    paramList.append(param);
+
+    param.m_name = "scanSpeed";
+    param.m_value = m_leScanSpeed.text();
+    paramList.append(param);
+
+    CProjectManager projMan(file, paramList, true);
+    return 0;
+}
+
+int CCvProject::openProject(QFile& file)
+{
+    qDebug() << "Reading CV project.";
+
+    QList<SettingParam_t> paramList;
+    CProjectManager projMan(file, paramList, false);
+
+    if (paramList.size() < 5)
+    {
+        qCritical() << "CV project" << file.fileName() << "is missing fields";
+        return -1;
+    }
+
+    // update fields
+    m_lePotStart.setText(paramList.takeFirst().m_value);
+    m_lePotEnd.setText(paramList.takeFirst().m_value);
+    m_leNrOfCycles.setText(paramList.takeFirst().m_value);
+    m_lePotStep.setText(paramList.takeFirst().m_value);
+    m_leScanSpeed.setText(paramList.takeFirst().m_value);
+
+    return 0;
+}
+
 
 
 
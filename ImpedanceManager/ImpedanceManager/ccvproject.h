@@ -2,6 +2,7 @@
 #define CCVPROJECT_H
 
 #include "cgenericproject.h"
+#include "ccvsegmenter.h"
 
 class CCvProject : public CGenericProject
 {
@@ -12,9 +13,11 @@ public:
     ~CCvProject();
 
     virtual EMeasures_t measureType(){ return EMeasures_t::eCV; }
-    virtual void takeMeasure();
+    virtual int takeMeasure();
     virtual void changeConnections(const bool);
     virtual int saveToCsv(QIODevice* device);
+    virtual int saveProjectAs(QFile& file);
+    virtual int openProject(QFile& file);
 
 signals:
     void send_takeMeasCv(const qint16&, const qint16&, const quint8&,
@@ -25,6 +28,10 @@ private slots:
     void on_received_giveMeasChunkCv(const quint16&, const union32_t&, const union32_t&);
     void on_received_endMeasCv();
 
+protected:
+    virtual void ingestSample(const MeasSample_t& sample);
+    virtual int importSamples(const CCsvReader::Table_t& table);
+
 private:
     virtual void initPlot();
     virtual void initFields();
@@ -32,7 +39,11 @@ private:
 
     virtual int insertLabels();
 
-    void addCvPoint(const float& current, const float& voltage);
+    void addCvPoint(const float& current, const float& voltage, const int& cycle);
+    static QTreeWidgetItem* cvItem(const float& current, const float& voltage, const int& cycle);
+    void startCycleCurve(const int& cycle);
+    void clearCycles();
+    void updateCycleSummary();
 
     QLabel m_labelPotStart;
     QLineEdit m_lePotStart;
@@ -48,6 +59,11 @@ private:
 
     QLabel m_labelScanSpeed;
     QLineEdit m_leScanSpeed;
+
+    // cycles of a multi cycle run, one curve each
+    QLabel m_labelCycles;
+    CCvSegmenter m_segmenter;
+    QVector<QCPCurve*> m_cycleCurves;   // [0] is customCurve
 };
 
 #endif // CCVPROJECT_H
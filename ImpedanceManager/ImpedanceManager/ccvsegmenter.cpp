@@ -0,0 +1,118 @@
+#include "ccvsegmenter.h"
+
+#include <cmath>
+
+CCvSegmenter::CCvSegmenter(const double& hysteresis)
+{
+    m_hysteresis = hysteresis;
+    reset();
+}
+
+void CCvSegmenter::reset()
+{
+    m_cycles.clear();
+    m_samples = 0;
+    m_direction = 0;
+    m_startDirection = 0;
+    m_firstPotential = 0;
+    m_extreme = 0;
+}
+
+bool CCvSegmenter::addSample(const double& potential, const double& current)
+{
+    bool newCycle = false;
+
+    if (!m_samples)
+    {
+        Cycle_t cycle;
+        cycle.m_firstSample = 0;
+        cycle.m_samples = 0;
+        cycle.m_anodic.m_valid = false;
+        cycle.m_cathodic.m_valid = false;
+        m_cycles.append(cycle);
+
+        m_firstPotential = potential;
+        m_extreme = potential;
+        newCycle = true;
+    }
+    else if (!m_direction)
+    {
+        // the first move beyond the hysteresis sets the starting direction
+        if (std::fabs(potential - m_firstPotential) > m_hysteresis)
+        {
+            m_direction = (potential > m_firstPotential) ? 1 : -1;
+            m_startDirection = m_direction;
+            m_extreme = potential;
+        }
+    }
+    else if ((potential - m_extreme) * m_direction > 0)
+    {
+        m_extreme = potential;
+    }
+    else if ((m_extreme - potential) * m_direction > m_hysteresis)
+    {
+        // reversal
+        m_direction = -m_direction;
+        m_extreme = potential;
+
+        if (m_direction == m_startDirection)
+        {
+            Cycle_t cycle;
+            cycle.m_firstSample = m_samples;
+            cycle.m_samples = 0;
+            cycle.m_anodic.m_valid = false;
+            cycle.m_cathodic.m_valid = false;
+            m_cycles.append(cycle);
+            newCycle = true;
+        }
+    }
+
+    Cycle_t& cycle = m_cycles.last();
+    cycle.m_samples++;
+    m_samples++;
+
+    if (m_direction)
+        updatePeak(cycle, m_direction, potential, current);
+
+    return newCycle;
+}
+
+void CCvSegmenter::updatePeak(Cycle_t& cycle, const int& direction,
+                              const double& potential, const double& current)
+{
+    if (direction > 0)
+    {
+        if (!cycle.m_anodic.m_valid || (current > cycle.m_anodic.m_current))
+        {
+            cycle.m_anodic.m_valid = true;
+            cycle.m_anodic.m_potential = potential;
+            cycle.m_anodic.m_current = current;
+        }
+    }
+    else
+    {
+        if (!cycle.m_cathodic.m_valid || (current < cycle.m_cathodic.m_current))
+        {
+            cycle.m_cathodic.m_valid = true;
+            cycle.m_cathodic.m_potential = potential;
+            cycle.m_cathodic.m_current = current;
+        }
+    }
+}
+
+double CCvSegmenter::peakSeparation(const Cycle_t& cycle)
+{
+    if (!cycle.m_anodic.m_valid || !cycle.m_cathodic.m_valid)
+        return NAN;
+
+    return cycle.m_anodic.m_potential - cycle.m_cathodic.m_potential;
+}
+
+double CCvSegmenter::peakRatio(const Cycle_t& cycle)
+{
+    if (!cycle.m_anodic.m_valid || !cycle.m_cathodic.m_valid ||
+        (cycle.m_cathodic.m_current == 0))
+        return NAN;
+
+    return std::fabs(cycle.m_anodic.m_current / cycle.m_cathodic.m_current);
+}
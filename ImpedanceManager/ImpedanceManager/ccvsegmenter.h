@@ -0,0 +1,59 @@
+#ifndef CCVSEGMENTER_H
+#define CCVSEGMENTER_H
+
+#include <QVector>
+
+// Online cycle segmentation of a cyclic voltammetry run. Sweep reversals are
+// detected as the points arrive: the sweep has turned once the potential
+// moved back from its last extreme by more than the hysteresis. A cycle ends
+// when the sweep turns back into its starting direction. The anodic peak is
+// the highest current of the positive going branch, the cathodic one the
+// lowest of the negative going branch (no baseline correction). Every sample
+// costs O(1).
+class CCvSegmenter
+{
+public:
+    typedef struct
+    {
+        bool m_valid;
+        double m_potential;     // [V]
+        double m_current;       // [A]
+    } Peak_t;
+
+    typedef struct
+    {
+        int m_firstSample;      // index of the first sample of the cycle
+        int m_samples;
+        Peak_t m_anodic;
+        Peak_t m_cathodic;
+    } Cycle_t;
+
+    explicit CCvSegmenter(const double& hysteresis = 0.002);
+
+    void reset();
+
+    // returns true when the sample starts a new cycle
+    bool addSample(const double& potential, const double& current);
+
+    int cycleCount() const { return m_cycles.size(); }
+    const QVector<Cycle_t>& cycles() const { return m_cycles; }
+    int currentCycle() const { return m_cycles.size() - 1; }
+
+    // Epa - Epc [V] and |ipa / ipc|, NAN until both peaks of the cycle exist
+    static double peakSeparation(const Cycle_t& cycle);
+    static double peakRatio(const Cycle_t& cycle);
+
+private:
+    void updatePeak(Cycle_t& cycle, const int& direction,
+                    const double& potential, const double& current);
+
+    double m_hysteresis;        // [V]
+    QVector<Cycle_t> m_cycles;
+    int m_samples;
+    int m_direction;            // +1 positive going, -1 negative going, 0 not known yet
+    int m_startDirection;
+    double m_firstPotential;
+    double m_extreme;           // furthest potential in m_direction
+};
+
+#endif // CCVSEGMENTER_H
@@ -0,0 +1,131 @@
+#include "cdiagnosticsdialog.h"
+
+CDiagnosticsDialog::CDiagnosticsDialog(QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle("Diagnostics");
+    resize(640, 360);
+
+    m_pbReset.setText("Reset");
+    m_buttonLayout.addWidget(&m_labelUptime);
+    m_buttonLayout.addStretch();
+    m_buttonLayout.addWidget(&m_pbReset);
+
+    m_layout.addWidget(&m_tree);
+    m_layout.addLayout(&m_buttonLayout);
+    setLayout(&m_layout);
+
+    initTree();
+
+    connect(&m_pbReset, SIGNAL(clicked()), this, SLOT(on_pbReset_clicked()));
+    m_refreshTimer.setInterval(m_refreshInterval_ms);
+    connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(on_refresh()));
+}
+
+CDiagnosticsDialog::~CDiagnosticsDialog()
+{
+
+}
+
+void CDiagnosticsDialog::initTree()
+{
+    m_tree.setColumnCount(6);
+    m_tree.setHeaderLabels(QStringList() << "Stage" << "Count" << "p50" << "p90"
+                                         << "p99" << "Max");
+    m_tree.setRootIsDecorated(true);
+
+    QTreeWidgetItem* stages = new QTreeWidgetItem(&m_tree, QStringList() << "Latency");
+    for (int i = 0; i < (int)CTelemetry::EStage_t::eStageCount; i++)
+    {
+        mp_stageItems[i] = new QTreeWidgetItem(stages, QStringList()
+                                               << CTelemetry::stageName((CTelemetry::EStage_t)i));
+    }
+
+    // the columns of a counter: total and the rate since the last refresh
+    QTreeWidgetItem* counters = new QTreeWidgetItem(&m_tree, QStringList() << "Throughput"
+                                                    << "Total" << "Per second");
+    for (int i = 0; i < (int)CTelemetry::ECounter_t::eCounterCount; i++)
+    {
+        mp_counterItems[i] = new QTreeWidgetItem(counters, QStringList()
+                                                 << CTelemetry::counterName((CTelemetry::ECounter_t)i));
+        m_lastCounters[i] = 0;
+    }
+
+    m_lastRefresh_ns = 0;
+    m_tree.expandAll();
+}
+
+QString CDiagnosticsDialog::formatNs(const qint64& value_ns)
+{
+    if (value_ns < 1000)
+        return QString("%1 ns").arg(value_ns);
+    if (value_ns < 1000000)
+        return QString("%1 us").arg(value_ns / 1e3, 0, 'f', 1);
+    if (value_ns < 1000000000)
+        return QString("%1 ms").arg(value_ns / 1e6, 0, 'f', 1);
+
+    return QString("%1 s").arg(value_ns / 1e9, 0, 'f', 2);
+}
+
+void CDiagnosticsDialog::showEvent(QShowEvent* event)
+{
+    QDialog::showEvent(event);
+
+    on_refresh();
+    m_refreshTimer.start();
+}
+
+void CDiagnosticsDialog::hideEvent(QHideEvent* event)
+{
+    m_refreshTimer.stop();
+    QDialog::hideEvent(event);
+}
+
+void CDiagnosticsDialog::on_refresh()
+{
+    CTelemetry* telemetry = CTelemetry::instance();
+    qint64 now_ns = telemetry->now();
+    double elapsed_s = m_lastRefresh_ns ? (now_ns - m_lastRefresh_ns) / 1e9 : 0;
+
+    for (int i = 0; i < (int)CTelemetry::EStage_t::eStageCount; i++)
+    {
+        const CHdrHistogram& hist = telemetry->histogram((CTelemetry::EStage_t)i);
+        QTreeWidgetItem* item = mp_stageItems[i];
+
+        item->setText(1, QString::number(hist.count()));
+        item->setText(2, formatNs(hist.percentile(0.5)));
+        item->setText(3, formatNs(hist.percentile(0.9)));
+        item->setText(4, formatNs(hist.percentile(0.99)));
+        item->setText(5, formatNs(hist.max()));
+    }
+
+    for (int i = 0; i < (int)CTelemetry::ECounter_t::eCounterCount; i++)
+    {
+        quint64 value = telemetry->counter((CTelemetry::ECounter_t)i);
+        QTreeWidgetItem* item = mp_counterItems[i];
+
+        item->setText(1, QString::number(value));
+        if (elapsed_s > 0)
+            item->setText(2, QString::number((value - m_lastCounters[i]) / elapsed_s, 'f', 1));
+
+        m_lastCounters[i] = value;
+    }
+
+    m_lastRefresh_ns = now_ns;
+    m_labelUptime.setText(QString("Collected over %1 s")
+                          .arg(telemetry->uptime_ns() / 1e9, 0, 'f', 0));
+}
+
+void CDiagnosticsDialog::on_pbReset_clicked()
+{
+    CTelemetry::instance()->reset();
+
+    for (int i = 0; i < (int)CTelemetry::ECounter_t::eCounterCount; i++)
+    {
+        m_lastCounters[i] = 0;
+        mp_counterItems[i]->setText(2, "");
+    }
+
+    m_lastRefresh_ns = 0;
+    on_refresh();
+}
@@ -0,0 +1,52 @@
+#ifndef CDIAGNOSTICSDIALOG_H
+#define CDIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTreeWidget>
+#include <QPushButton>
+#include <QLabel>
+#include <QTimer>
+
+#include "ctelemetry.h"
+
+// Non modal window with the acquisition pipeline telemetry: latency
+// percentiles of every stage and the throughput counters, refreshed once a
+// second while it is shown.
+class CDiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CDiagnosticsDialog(QWidget *parent = 0);
+    ~CDiagnosticsDialog();
+
+protected:
+    void showEvent(QShowEvent* event);
+    void hideEvent(QHideEvent* event);
+
+private slots:
+    void on_refresh();
+    void on_pbReset_clicked();
+
+private:
+    void initTree();
+    static QString formatNs(const qint64& value_ns);
+
+    QVBoxLayout m_layout;
+    QHBoxLayout m_buttonLayout;
+    QTreeWidget m_tree;
+    QLabel m_labelUptime;
+    QPushButton m_pbReset;
+    QTimer m_refreshTimer;
+
+    QTreeWidgetItem* mp_stageItems[(int)CTelemetry::EStage_t::eStageCount];
+    QTreeWidgetItem* mp_counterItems[(int)CTelemetry::ECounter_t::eCounterCount];
+    quint64 m_lastCounters[(int)CTelemetry::ECounter_t::eCounterCount];
+    qint64 m_lastRefresh_ns;
+
+    static const int m_refreshInterval_ms = 1000;
+};
+
+#endif // CDIAGNOSTICSDIALOG_H
@@ -0,0 +1,429 @@
+#include "cdpvanalysis.h"
+#include "clinalg.h"
+#include "csignalfilter.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+CDpvAnalysis::CDpvAnalysis()
+{
+    m_baselineType = EBaseline_t::eAls;
+    m_lambda = 1e5;
+    m_asymmetry = 0.01;
+    m_order = 3;
+    m_minSnr = 5;
+}
+
+void CDpvAnalysis::setBaseline(const EBaseline_t type, const double lambda,
+                               const double asymmetry, const int order)
+{
+    m_baselineType = type;
+    m_lambda = lambda;
+    m_asymmetry = asymmetry;
+    m_order = order;
+}
+
+CDpvAnalysis::Result_t CDpvAnalysis::analyze(const QVector<double>& x,
+                                             const QVector<double>& y) const
+{
+    Result_t result;
+    result.m_noise = 0;
+    result.m_valid = false;
+
+    const int n = y.size();
+    if ((n < m_minPoints) || (x.size() != n))
+        return result;
+
+    // oxidation peaks point up, reduction peaks down: work on the trace with
+    // the larger excursion from its median pointing up
+    QVector<double> sorted(y);
+    std::nth_element(sorted.begin(), sorted.begin() + n / 2, sorted.end());
+    double median = sorted[n / 2];
+    double top = *std::max_element(y.constBegin(), y.constEnd());
+    double bottom = *std::min_element(y.constBegin(), y.constEnd());
+    const double sign = ((median - bottom) > (top - median)) ? -1 : 1;
+
+    QVector<double> signal(n), baseline;
+    for (int i = 0; i < n; i++)
+        signal[i] = sign * y[i];
+
+    if (m_baselineType == EBaseline_t::ePolynomial)
+        polynomialBaseline(x, signal, baseline);
+    else
+        alsBaseline(signal, baseline);
+
+    // both baselines settle on the lower envelope of the noise; most points
+    // are baseline, so their median residual is that offset
+    QVector<double> corrected(n);
+    for (int i = 0; i < n; i++)
+        sorted[i] = signal[i] - baseline[i];
+    std::nth_element(sorted.begin(), sorted.begin() + n / 2, sorted.end());
+    double offset = sorted[n / 2];
+
+    for (int i = 0; i < n; i++)
+    {
+        baseline[i] += offset;
+        corrected[i] = signal[i] - baseline[i];
+    }
+
+    result.m_noise = noiseLevel(corrected);
+
+    // derivative of the smoothed trace, its + to - crossings are maxima
+    CSignalFilter smoother;
+    QVector<double> smooth;
+    smoother.configure(EFilterType_t::eSavitzkyGolay, m_smoothWindow, 2);
+    smoother.apply(corrected, smooth);
+
+    const double minHeight = qMax(m_minSnr * result.m_noise, 1e-300);
+    double previous = smooth[1] - smooth[0];
+    int boundary = 0;   // right edge of the last peak, the walks stop there
+
+    for (int i = 1; i < n - 1; i++)
+    {
+        double derivative = smooth[i + 1] - smooth[i - 1];
+        bool crossing = (previous > 0) && (derivative <= 0);
+        previous = derivative;
+
+        if (!crossing)
+            continue;
+
+        int index = (smooth[i] >= smooth[i - 1]) ? i : i - 1;
+        double height = smooth[index];
+        if (height < minHeight)
+            continue;
+
+        // half height walk, the fitted region is twice that wide; noise
+        // crossings on the same peak are skipped by continuing behind it
+        int left = index;
+        while ((left > boundary) && (smooth[left] > height / 2))
+            left--;
+        int right = index;
+        while ((right < n - 1) && (smooth[right] > height / 2))
+            right++;
+
+        for (int k = left; k <= right; k++)
+        {
+            if (smooth[k] > smooth[index])
+                index = k;
+        }
+        height = smooth[index];
+
+        i = right;
+        boundary = right;
+        previous = (right < n - 1) ? smooth[right + 1] - smooth[right - 1] : 0;
+
+        // a peak cut by the ends of the sweep cannot be quantified
+        if ((left == 0) || (right == n - 1))
+            continue;
+
+        Peak_t peak;
+        peak.m_index = index;
+        peak.m_first = qMax(0, index - qMax(3, 2 * (index - left)));
+        peak.m_last = qMin(n - 1, index + qMax(3, 2 * (right - index)));
+
+        double hwhm = std::fabs(x[right] - x[left]) / 2;
+        if (hwhm <= 0)
+            hwhm = std::fabs(x[qMin(index + 1, n - 1)] - x[qMax(index - 1, 0)]);
+
+        double gauss[3] = { height, x[index], hwhm / std::sqrt(2 * std::log(2.0)) };
+        double lorentz[3] = { height, x[index], hwhm };
+        double chiGauss = fitPeak(EPeakShape_t::eGaussian, x, corrected,
+                                  peak.m_first, peak.m_last, gauss);
+        double chiLorentz = fitPeak(EPeakShape_t::eLorentzian, x, corrected,
+                                    peak.m_first, peak.m_last, lorentz);
+
+        const int points = peak.m_last - peak.m_first + 1;
+        if (chiGauss <= chiLorentz)
+        {
+            peak.m_shape = EPeakShape_t::eGaussian;
+            peak.m_potential = gauss[1];
+            peak.m_height = gauss[0];
+            peak.m_fwhm = 2 * std::sqrt(2 * std::log(2.0)) * gauss[2];
+            peak.m_area = gauss[0] * gauss[2] * std::sqrt(2 * M_PI);
+            peak.m_chiSquare = chiGauss / points;
+        }
+        else
+        {
+            peak.m_shape = EPeakShape_t::eLorentzian;
+            peak.m_potential = lorentz[1];
+            peak.m_height = lorentz[0];
+            peak.m_fwhm = 2 * lorentz[2];
+            peak.m_area = M_PI * lorentz[0] * lorentz[2];
+            peak.m_chiSquare = chiLorentz / points;
+        }
+
+        // a fit that ran away from its region is not a peak
+        double low = qMin(x[peak.m_first], x[peak.m_last]);
+        double high = qMax(x[peak.m_first], x[peak.m_last]);
+        if (!std::isfinite(peak.m_chiSquare) || (peak.m_potential < low) ||
+            (peak.m_potential > high) || (peak.m_height < minHeight))
+            continue;
+
+        peak.m_height *= sign;
+        peak.m_area *= sign;
+        result.m_peaks.append(peak);
+    }
+
+    result.m_baseline.resize(n);
+    result.m_corrected.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        result.m_baseline[i] = sign * baseline[i];
+        result.m_corrected[i] = sign * corrected[i];
+    }
+
+    result.m_valid = true;
+    return result;
+}
+
+void CDpvAnalysis::alsBaseline(const QVector<double>& y, QVector<double>& z) const
+{
+    // (W + lambda D^T D) z = W y, D the second difference; pentadiagonal
+    const int n = y.size();
+    const int width = 2;
+    const int stride = width + 1;
+    const double d[3] = { 1, -2, 1 };
+
+    QVector<double> penalty(n * stride, 0.0), band(n * stride), weight(n, 1.0);
+
+    for (int k = 0; k + 2 < n; k++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            for (int b = 0; b <= a; b++)
+                penalty[(k + a) * stride + (a - b)] += m_lambda * d[a] * d[b];
+        }
+    }
+
+    z.resize(n);
+    for (int iteration = 0; iteration < m_alsIterations; iteration++)
+    {
+        band = penalty;
+        for (int i = 0; i < n; i++)
+        {
+            band[i * stride] += weight[i];
+            z[i] = weight[i] * y[i];
+        }
+
+        if (!CLinAlg::bandCholesky(band.data(), n, width))
+        {
+            qWarning() << "DPV baseline: ALS system is not positive definite";
+            z = y;
+            return;
+        }
+
+        CLinAlg::bandCholeskySolve(band.constData(), n, width, z.data());
+
+        bool changed = false;
+        for (int i = 0; i < n; i++)
+        {
+            double w = (y[i] > z[i]) ? m_asymmetry : 1 - m_asymmetry;
+            if (w != weight[i])
+            {
+                weight[i] = w;
+                changed = true;
+            }
+        }
+
+        if (!changed)
+            break;
+    }
+}
+
+void CDpvAnalysis::polynomialBaseline(const QVector<double>& x, const QVector<double>& y,
+                                      QVector<double>& z) const
+{
+    const int n = y.size();
+    const int terms = qMin(m_order + 1, n);
+
+    double low = *std::min_element(x.constBegin(), x.constEnd());
+    double high = *std::max_element(x.constBegin(), x.constEnd());
+    double center = (high + low) / 2;
+    double half = qMax((high - low) / 2, 1e-300);
+
+    QVector<double> work(y), normal(terms * terms), rhs(terms), powers(terms);
+    z.resize(n);
+
+    for (int iteration = 0; iteration < m_polyIterations; iteration++)
+    {
+        normal.fill(0);
+        rhs.fill(0);
+
+        for (int i = 0; i < n; i++)
+        {
+            double t = (x[i] - center) / half;
+            powers[0] = 1;
+            for (int p = 1; p < terms; p++)
+                powers[p] = powers[p - 1] * t;
+
+            for (int r = 0; r < terms; r++)
+            {
+                rhs[r] += powers[r] * work[i];
+                for (int c = 0; c <= r; c++)
+                    normal[r * terms + c] += powers[r] * powers[c];
+            }
+        }
+
+        if (!CLinAlg::cholesky(normal.data(), terms))
+        {
+            qWarning() << "DPV baseline: polynomial fit is singular";
+            z = y;
+            return;
+        }
+
+        CLinAlg::choleskySolve(normal.constData(), terms, rhs.data());
+
+        // points above the fit are clipped to it, so peaks stop lifting it
+        double change = 0;
+        for (int i = 0; i < n; i++)
+        {
+            double t = (x[i] - center) / half;
+            double value = 0;
+            for (int p = terms - 1; p >= 0; p--)
+                value = value * t + rhs[p];
+
+            z[i] = value;
+            if (work[i] > value)
+            {
+                change = qMax(change, work[i] - value);
+                work[i] = value;
+            }
+        }
+
+        if (change <= 1e-12 * (std::fabs(z[0]) + 1))
+            break;
+    }
+}
+
+double CDpvAnalysis::noiseLevel(const QVector<double>& y)
+{
+    // median absolute first difference, robust to peaks and to slow trends
+    const int n = y.size() - 1;
+    if (n < 1)
+        return 0;
+
+    QVector<double> differences(n);
+    for (int i = 0; i < n; i++)
+        differences[i] = std::fabs(y[i + 1] - y[i]);
+
+    std::nth_element(differences.begin(), differences.begin() + n / 2, differences.end());
+    return 1.4826 * differences[n / 2] / std::sqrt(2.0);
+}
+
+double CDpvAnalysis::shape(const EPeakShape_t shapeType, const double* params, const double& x)
+{
+    double u = (x - params[1]) / params[2];
+
+    if (shapeType == EPeakShape_t::eGaussian)
+        return params[0] * std::exp(-0.5 * u * u);
+
+    return params[0] / (1 + u * u);
+}
+
+double CDpvAnalysis::fitPeak(const EPeakShape_t shapeType, const QVector<double>& x,
+                             const QVector<double>& y, const int& first, const int& last,
+                             double* params)
+{
+    // Levenberg-Marquardt on height, center and width
+    const int count = 3;
+    double lambda = 1e-3;
+    double jtj[count * count], jtr[count], step[count], trial[count], normal[count * count];
+
+    auto chiSquare = [&](const double* p) -> double
+    {
+        double chi = 0;
+        for (int i = first; i <= last; i++)
+        {
+            double r = y[i] - shape(shapeType, p, x[i]);
+            chi += r * r;
+        }
+        return chi;
+    };
+
+    if (params[2] == 0)
+        return INFINITY;
+
+    double chi = chiSquare(params);
+
+    for (int iteration = 0; iteration < m_fitIterations; iteration++)
+    {
+        for (int k = 0; k < count * count; k++)
+            jtj[k] = 0;
+        for (int k = 0; k < count; k++)
+            jtr[k] = 0;
+
+        for (int i = first; i <= last; i++)
+        {
+            double u = (x[i] - params[1]) / params[2];
+            double j[count];
+
+            if (shapeType == EPeakShape_t::eGaussian)
+            {
+                double e = std::exp(-0.5 * u * u);
+                j[0] = e;
+                j[1] = params[0] * e * u / params[2];
+                j[2] = params[0] * e * u * u / params[2];
+            }
+            else
+            {
+                double q = 1 / (1 + u * u);
+                j[0] = q;
+                j[1] = 2 * params[0] * q * q * u / params[2];
+                j[2] = 2 * params[0] * q * q * u * u / params[2];
+            }
+
+            double r = y[i] - shape(shapeType, params, x[i]);
+            for (int a = 0; a < count; a++)
+            {
+                jtr[a] += j[a] * r;
+                for (int b = 0; b <= a; b++)
+                    jtj[a * count + b] += j[a] * j[b];
+            }
+        }
+
+        bool improved = false;
+        while (!improved && (lambda < 1e10))
+        {
+            for (int a = 0; a < count; a++)
+            {
+                for (int b = 0; b <= a; b++)
+                    normal[a * count + b] = jtj[a * count + b];
+                normal[a * count + a] *= 1 + lambda;
+                step[a] = jtr[a];
+            }
+
+            if (!CLinAlg::cholesky(normal, count))
+            {
+                lambda *= 10;
+                continue;
+            }
+            CLinAlg::choleskySolve(normal, count, step);
+
+            for (int a = 0; a < count; a++)
+                trial[a] = params[a] + step[a];
+            trial[2] = std::fabs(trial[2]);
+
+            double trialChi = (trial[2] > 0) ? chiSquare(trial) : INFINITY;
+            if (trialChi < chi)
+            {
+                double gain = chi - trialChi;
+                for (int a = 0; a < count; a++)
+                    params[a] = trial[a];
+                chi = trialChi;
+                lambda = qMax(lambda / 10, 1e-12);
+                improved = true;
+
+                if (gain <= 1e-12 * chi)
+                    return chi;
+            }
+            else
+                lambda *= 10;
+        }
+
+        if (!improved)
+            break;
+    }
+
+    return chi;
+}
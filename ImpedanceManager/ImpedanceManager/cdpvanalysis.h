@@ -0,0 +1,84 @@
+#ifndef CDPVANALYSIS_H
+#define CDPVANALYSIS_H
+
+#include <QVector>
+
+enum class EBaseline_t
+{
+    eAls        = 0,    // asymmetric least squares (Eilers)
+    ePolynomial = 1,    // iterative polynomial, points above the fit are clipped
+};
+
+enum class EPeakShape_t
+{
+    eGaussian   = 0,
+    eLorentzian = 1,
+};
+
+// DPV peak analysis: baseline subtraction, peak detection on the zero
+// crossings of the smoothed derivative and a Gaussian or Lorentzian fit of
+// every peak (whichever fits better). The ALS baseline is a pentadiagonal
+// system solved by a banded Cholesky, the polynomial one a fixed small normal
+// matrix and peak fits are local, so the whole pipeline is linear in the
+// number of points. Reduction peaks (negative currents) are handled by
+// flipping the trace when its largest excursion is negative.
+class CDpvAnalysis
+{
+public:
+    typedef struct
+    {
+        double m_potential;     // fitted center, unit of x
+        double m_height;        // above the baseline, unit of y
+        double m_fwhm;          // unit of x
+        double m_area;
+        double m_chiSquare;     // per point of the fitted region
+        EPeakShape_t m_shape;
+        int m_index;            // sample of the detected maximum
+        int m_first;            // fitted region
+        int m_last;
+    } Peak_t;
+
+    typedef struct
+    {
+        QVector<double> m_baseline;
+        QVector<double> m_corrected;    // y - baseline
+        QVector<Peak_t> m_peaks;
+        double m_noise;                 // robust sigma of the corrected trace
+        bool m_valid;
+    } Result_t;
+
+    CDpvAnalysis();
+
+    Result_t analyze(const QVector<double>& x, const QVector<double>& y) const;
+
+    // ALS smoothing lambda, asymmetry p, polynomial order
+    void setBaseline(const EBaseline_t type, const double lambda = 1e5,
+                     const double asymmetry = 0.01, const int order = 3);
+    void setMinSnr(const double snr) { m_minSnr = snr; }
+
+    // peak value of the given shape at x
+    static double shape(const EPeakShape_t shape, const double* params, const double& x);
+
+    static const int m_minPoints = 10;
+    static const int m_smoothWindow = 7;
+    static const int m_alsIterations = 10;
+    static const int m_polyIterations = 30;
+    static const int m_fitIterations = 50;
+
+private:
+    void alsBaseline(const QVector<double>& y, QVector<double>& z) const;
+    void polynomialBaseline(const QVector<double>& x, const QVector<double>& y,
+                            QVector<double>& z) const;
+    static double noiseLevel(const QVector<double>& y);
+    static double fitPeak(const EPeakShape_t shapeType, const QVector<double>& x,
+                          const QVector<double>& y, const int& first, const int& last,
+                          double* params);
+
+    EBaseline_t m_baselineType;
+    double m_lambda;
+    double m_asymmetry;
+    int m_order;
+    double m_minSnr;
+};
+
+#endif // CDPVANALYSIS_H
@@ -1,4 +1,7 @@
 #include "cdpvproject.h"
+#include "cmeasurelimits.h"
+
+#include <cmath>
 
 CDpvProject::CDpvProject(CSerialThread* serialThread, QWidget* parent) :
     CGenericProject(serialThread, parent)
@@ -7,6 +10,7 @@ CDpvProject::CDpvProject(CSerialThread* serialThread, QWidget* parent) :
 
     initPlot();
     initFields();
+    initFilter();
 
     mp_serialThread = serialThread;
     updateTree();
@@ -27,6 +31,14 @@ void CDpvProject::initPlot()
     customPlot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
     customPlot->graph(0)->setName("DPV measure");
 
+    mp_baselineGraph = customPlot->addGraph();
+    mp_baselineGraph->setName("Baseline");
+    mp_baselineGraph->setPen(QPen(Qt::gray, 1, Qt::DashLine));
+
+    mp_peakFitGraph = customPlot->addGraph();
+    mp_peakFitGraph->setName("Peak fit");
+    mp_peakFitGraph->setPen(QPen(Qt::red));
+
     m_upperXRange = 1500; // mV
     m_lowerXRange = -1500;
     m_upperYRange = 1000; // 1 mA
@@ -172,51 +184,69 @@ void CDpvProject::changeConnections(const bool con)
 
 void CDpvProject::on_received_giveMeasChunkDpv(const union32_t& current, const union32_t& voltage)
 {
-    m_x.append(voltage.idFl);
-    m_y.append(current.idFl);
+    MeasSample_t sample;
+    sample.m_index = 0;
+    sample.m_data[0] = current.idFl;
+    sample.m_data[1] = voltage.idFl;
+
+    ingestSample(sample);
+    updatePlot();
+}
+
+void CDpvProject::ingestSample(const MeasSample_t& sample)
+{
+    float current = sample.m_data[0];
+    float voltage = sample.m_data[1];
+
+    m_x.append(voltage);
+    m_y.append(current);
+
+    addDpvPoint(current, voltage);
+    customPlot->graph(0)->addData(voltage, current);
+    filterSample(voltage, current);
+}
+
+int CDpvProject::importSamples(const CCsvReader::Table_t& table)
+{
+    // Voltage[mV],Current[uA]
+    if (table.m_columns.size() < 2)
+        return -1;
+
+    m_x = table.m_columns[0];
+    m_y = table.m_columns[1];
+    customPlot->graph(0)->setData(m_x, m_y);
 
-    addDpvPoint(current.idFl, voltage.idFl);
-    customPlot->graph(0)->addData(voltage.idFl, current.idFl);
-    autoScalePlot();
+    QList<QTreeWidgetItem*> items;
+    for (int i = 0; i < qMin(m_x.size(), m_maxListedPoints); i++)
+        items.append(dpvItem(m_y[i], m_x[i]));
+    ui->twPoints->addTopLevelItems(items);
 
-    qDebug("DPV point received. Vol: %f Cur: %f", voltage.idFl, current.idFl);
+    analyzePeaks();
+    return 0;
 }
 
 void CDpvProject::on_received_endMeasDpv()
 {
+    drainSamples();
+    applyFilter();
+    analyzePeaks();
     insertLabels();
     emit measureFinished();
 }
 
-void CDpvProject::takeMeasure()
+int CDpvProject::takeMeasure()
 {
-    const qint32 maxVoltage_mv = 1500;
     bool ok;
-    QString badParameters;
 
     qint16 qp = (qint16)m_leQp.text().toInt(&ok, 10);
     quint16 qt = (quint16)m_leQt.text().toInt(&ok, 10);
-    if (!qt)
-        badParameters += m_leQt.text() + "\n";
-
     quint32 pn = (quint32)m_lePn.text().toInt(&ok, 10);
-    if (!pn)
-        badParameters += m_lePn.text() + "\n";
-
     quint16 pa = (quint16)m_lePa.text().toInt(&ok, 10);
     quint16 pp = (quint16)m_lePp.text().toInt(&ok, 10);
     quint16 pw = (quint16)m_lePw.text().toInt(&ok, 10);
     qint16 ps = (qint16)m_lePs.text().toInt(&ok, 10);
 
-    // check either waveform wont overcome 1.5 V
-    qint32 endVoltage_mv = ps * pn + pa;
-    if ( (endVoltage_mv > maxVoltage_mv) ||
-         (endVoltage_mv < (maxVoltage_mv * -1)) )
-    {
-        badParameters += "PS * PN + PA cannot be higher than " +
-                QString("%1").arg(maxVoltage_mv) + " mV and lower than -" +
-                QString("%1").arg(maxVoltage_mv) + " mV";
-    }
+    QString badParameters = CMeasureLimits::checkDpv(qt, pn, pa, ps);
 
     if(badParameters.length())
     {
@@ -225,12 +255,14 @@ void CDpvProject::takeMeasure()
         msgBox.setText("Empty fields detected!");
         msgBox.setInformativeText(badParameters);
         msgBox.exec();
-        return;
+        return -1;
     }
 
     clearData();
+    clearAnalysis();
     qDebug() << "Sending DPV measure request";
     emit send_takeMeasDpv(qp, qt, pn, pa, pp, pw, ps);
+    return 0;
 }
 
 int CDpvProject::saveToCsv(QIODevice* device)
@@ -366,14 +398,77 @@ int CDpvProject::insertLabels()
     return 0;
 }
 
+void CDpvProject::analyzePeaks()
+{
+    clearAnalysis();
+
+    CDpvAnalysis::Result_t result = m_analysis.analyze(m_x, m_y);
+    if (!result.m_valid)
+    {
+        qWarning() << "DPV analysis: not enough points," << m_x.size();
+        return;
+    }
+
+    QVector<double> fit(result.m_baseline);
+    for (const CDpvAnalysis::Peak_t& peak : result.m_peaks)
+    {
+        // shape parameters back from the reported FWHM
+        double width = (peak.m_shape == EPeakShape_t::eGaussian) ?
+                    peak.m_fwhm / (2 * std::sqrt(2 * std::log(2.0))) : peak.m_fwhm / 2;
+        const double params[3] = { peak.m_height, peak.m_potential, width };
+
+        for (int i = peak.m_first; i <= peak.m_last; i++)
+            fit[i] += CDpvAnalysis::shape(peak.m_shape, params, m_x[i]);
+
+        QCPItemText* label = new QCPItemText(customPlot);
+        customPlot->addItem(label);
+        label->setPositionAlignment(Qt::AlignBottom|Qt::AlignHCenter);
+        label->position->setType(QCPItemPosition::ptPlotCoords);
+        label->position->setCoords(peak.m_potential, m_y[peak.m_index]);
+        label->setFont(QFont("Courier", 9));
+        label->setText(QString("Ep=%1mV\nip=%2uA\nFWHM=%3mV")
+                       .arg(peak.m_potential, 0, 'f', 1)
+                       .arg(peak.m_height, 0, 'e', 2)
+                       .arg(peak.m_fwhm, 0, 'f', 1));
+        label->setPen(QPen(Qt::red));
+        label->setBrush(QBrush(Qt::white));
+        m_peakLabels.append(label);
+
+        qDebug() << "DPV peak:" << (peak.m_shape == EPeakShape_t::eGaussian ? "Gaussian" : "Lorentzian")
+                 << "Ep" << peak.m_potential << "mV, ip" << peak.m_height << "uA, FWHM"
+                 << peak.m_fwhm << "mV, area" << peak.m_area;
+    }
+
+    mp_baselineGraph->setData(m_x, result.m_baseline);
+    mp_peakFitGraph->setData(m_x, fit);
+
+    qDebug() << "DPV analysis:" << result.m_peaks.size() << "peaks, noise" << result.m_noise << "uA";
+}
+
+void CDpvProject::clearAnalysis()
+{
+    mp_baselineGraph->clearData();
+    mp_peakFitGraph->clearData();
+
+    for (int i = 0; i < m_peakLabels.size(); i++)
+        customPlot->removeItem(m_peakLabels[i]);
+    m_peakLabels.clear();
+}
+
 void CDpvProject::addDpvPoint(const float& current, const float& voltage)
 {
-    QTreeWidgetItem* item = new QTreeWidgetItem(ui->twPoints);
+    ui->twPoints->addTopLevelItem(dpvItem(current, voltage));
+    ui->twPoints->scrollToBottom();
+}
+
+QTreeWidgetItem* CDpvProject::dpvItem(const float& current, const float& voltage)
+{
+    QTreeWidgetItem* item = new QTreeWidgetItem();
 
     item->setText(0, QString::number(voltage, 'e', 2));
     item->setText(1, QString::number(current, 'e', 2));
 
-    ui->twPoints->scrollToBottom();
+    return item;
 }
 
 
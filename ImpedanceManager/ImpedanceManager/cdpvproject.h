@@ -2,6 +2,7 @@
 #define CDPVPROJECT_H
 
 #include "cgenericproject.h"
+#include "cdpvanalysis.h"
 
 class CDpvProject : public CGenericProject
 {
@@ -11,7 +12,7 @@ public:
     ~CDpvProject();
 
     virtual EMeasures_t measureType(){ return EMeasures_t::eDPV; }
-    virtual void takeMeasure();
+    virtual int takeMeasure();
     virtual void changeConnections(const bool);
     virtual int saveToCsv(QIODevice* device);
     virtual int saveProjectAs(QFile& file);
@@ -26,6 +27,10 @@ private slots:
     void on_received_giveMeasChunkDpv(const union32_t& current, const union32_t& voltage);
     void on_received_endMeasDpv();
 
+protected:
+    virtual void ingestSample(const MeasSample_t& sample);
+    virtual int importSamples(const CCsvReader::Table_t& table);
+
 private:
     virtual void initPlot();
     virtual void initFields();
@@ -34,6 +39,9 @@ private:
     virtual int insertLabels();
 
     void addDpvPoint(const float& current, const float& voltage);
+    static QTreeWidgetItem* dpvItem(const float& current, const float& voltage);
+    void analyzePeaks();
+    void clearAnalysis();
 
     QLabel m_labelQp;
     QLineEdit m_leQp;
@@ -55,6 +63,12 @@ private:
 
     QLabel m_labelPs;
     QLineEdit m_lePs;
+
+    // peak analysis, run when the measure ends
+    CDpvAnalysis m_analysis;
+    QCPGraph* mp_baselineGraph;
+    QCPGraph* mp_peakFitGraph;      // baseline plus the fitted peaks
+    QVector<QCPItemText*> m_peakLabels;
 };
 
 #endif // CDPVPROJECT_H
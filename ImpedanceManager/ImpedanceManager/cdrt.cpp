@@ -0,0 +1,214 @@
+#include "cdrt.h"
+#include "clinalg.h"
+
+#include <QtConcurrent>
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+void CDrt::solve(const Problem_t& problem, const double& lambda,
+                 const double* gram, const double* rhs, double* x)
+{
+    const int cols = problem.m_cols;
+    QVector<double> h(cols * cols);
+
+    for (int i = 0; i < cols * cols; i++)
+        h[i] = gram[i] + lambda * problem.m_penalty[i];
+
+    CLinAlg::nonNegativeSolve(h.constData(), rhs, cols, x);
+}
+
+void CDrt::crossValidate(CvJob_t& job)
+{
+    const Problem_t& problem = *job.mp_problem;
+    const int cols = problem.m_cols;
+    QVector<double> gram(cols * cols), rhs(cols), x(cols);
+
+    job.m_error = 0;
+
+    for (int f = 0; f < problem.m_foldGram.size(); f++)
+    {
+        // training set = all folds but f
+        for (int i = 0; i < cols * cols; i++)
+            gram[i] = problem.m_gram[i] - problem.m_foldGram[f][i];
+        for (int i = 0; i < cols; i++)
+            rhs[i] = problem.m_rhs[i] - problem.m_foldRhs[f][i];
+
+        solve(problem, job.m_lambda, gram.constData(), rhs.constData(), x.data());
+
+        // prediction error on the left out fold
+        const QVector<double>& a = problem.m_foldA[f];
+        const QVector<double>& b = problem.m_foldB[f];
+        const int rows = b.size();
+        QVector<double> residual(b);
+
+        for (int c = 0; c < cols; c++)
+        {
+            if (x[c] == 0)
+                continue;
+
+            const double* col = a.constData() + c * rows;
+            for (int r = 0; r < rows; r++)
+                residual[r] -= col[r] * x[c];
+        }
+
+        job.m_error += CLinAlg::dot(residual.constData(), residual.constData(), rows);
+    }
+}
+
+CDrt::Result_t CDrt::compute(const QVector<double>& freq,
+                             const QVector<double>& re,
+                             const QVector<double>& im)
+{
+    Result_t result;
+    result.m_rInf = 0;
+    result.m_lambda = 0;
+    result.m_valid = false;
+
+    const int n = freq.size();
+    if ((n < 2 * m_folds) || (re.size() != n) || (im.size() != n))
+        return result;
+
+    QVector<double> omega(n), weight(n);
+    double omegaMin = INFINITY, omegaMax = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        omega[i] = 2 * M_PI * qMax(freq[i], 1e-9);
+        weight[i] = CLinAlg::modulusWeight(re[i], im[i]);
+        omegaMin = qMin(omegaMin, omega[i]);
+        omegaMax = qMax(omegaMax, omega[i]);
+    }
+
+    // tau grid a decade beyond the measured band on both sides
+    double tauMin = 0.1 / omegaMax;
+    double tauMax = 10.0 / omegaMin;
+    const int count = (int)std::ceil(std::log10(tauMax / tauMin) * m_gridPerDecade) + 1;
+    const double dLnTau = std::log(tauMax / tauMin) / (count - 1);
+
+    result.m_tau.resize(count);
+    for (int k = 0; k < count; k++)
+        result.m_tau[k] = tauMin * std::exp(k * dLnTau);
+
+    Problem_t problem;
+    problem.m_cols = count + 1;
+    const int cols = problem.m_cols;
+
+    problem.m_foldGram.resize(m_folds);
+    problem.m_foldRhs.resize(m_folds);
+    problem.m_foldA.resize(m_folds);
+    problem.m_foldB.resize(m_folds);
+    problem.m_gram.fill(0, cols * cols);
+    problem.m_rhs.fill(0, cols);
+
+    // every fold is an interleaved subset of the points (i % m_folds), so it
+    // covers the whole band; real rows first, then imaginary rows
+    for (int f = 0; f < m_folds; f++)
+    {
+        QVector<int> points;
+        for (int i = f; i < n; i += m_folds)
+            points.append(i);
+
+        const int pts = points.size();
+        const int rows = 2 * pts;
+        QVector<double>& a = problem.m_foldA[f];
+        QVector<double>& b = problem.m_foldB[f];
+
+        a.fill(0, rows * cols);
+        b.resize(rows);
+
+        for (int p = 0; p < pts; p++)
+        {
+            int i = points[p];
+            b[p] = re[i] * weight[i];
+            b[pts + p] = im[i] * weight[i];
+            a[p] = weight[i]; // R_inf
+        }
+
+        for (int k = 0; k < count; k++)
+        {
+            double* col = a.data() + (k + 1) * rows;
+
+            for (int p = 0; p < pts; p++)
+            {
+                int i = points[p];
+                double wt = omega[i] * result.m_tau[k];
+                double denominator = dLnTau * weight[i] / (1.0 + wt * wt);
+
+                col[p] = denominator;
+                col[pts + p] = -wt * denominator;
+            }
+        }
+
+        problem.m_foldGram[f].resize(cols * cols);
+        problem.m_foldRhs[f].resize(cols);
+        CLinAlg::gram(a.constData(), rows, cols, problem.m_foldGram[f].data());
+        CLinAlg::transposeTimes(a.constData(), rows, cols, b.constData(),
+                                problem.m_foldRhs[f].data());
+
+        for (int i = 0; i < cols * cols; i++)
+            problem.m_gram[i] += problem.m_foldGram[f][i];
+        for (int i = 0; i < cols; i++)
+            problem.m_rhs[i] += problem.m_foldRhs[f][i];
+    }
+
+    // first difference penalty on gamma, scaled to the mean diagonal of the
+    // data, so lambda does not depend on the number of points
+    double scale = 0;
+    for (int c = 1; c < cols; c++)
+        scale += problem.m_gram[c * cols + c];
+    scale /= count;
+
+    problem.m_penalty.fill(0, cols * cols);
+    for (int k = 1; k < cols - 1; k++)
+    {
+        problem.m_penalty[k * cols + k] += scale;
+        problem.m_penalty[(k + 1) * cols + (k + 1)] += scale;
+        problem.m_penalty[k * cols + (k + 1)] -= scale;
+        problem.m_penalty[(k + 1) * cols + k] -= scale;
+    }
+    for (int k = 1; k < cols; k++)
+        problem.m_penalty[k * cols + k] += 1e-6 * scale; // no null space
+
+    // lambda candidates, 1e-8 .. 1e1, in parallel
+    QVector<CvJob_t> jobs(m_lambdaCount);
+    for (int i = 0; i < m_lambdaCount; i++)
+    {
+        jobs[i].mp_problem = &problem;
+        jobs[i].m_lambda = std::pow(10.0, -8.0 + 9.0 * i / (m_lambdaCount - 1));
+        jobs[i].m_error = INFINITY;
+    }
+
+    QtConcurrent::blockingMap(jobs, crossValidate);
+
+    int best = 0;
+    for (int i = 0; i < m_lambdaCount; i++)
+    {
+        result.m_lambdas.append(jobs[i].m_lambda);
+        result.m_cvErrors.append(jobs[i].m_error);
+
+        if (jobs[i].m_error < jobs[best].m_error)
+            best = i;
+    }
+
+    QVector<double> x(cols);
+    solve(problem, jobs[best].m_lambda, problem.m_gram.constData(),
+          problem.m_rhs.constData(), x.data());
+
+    result.m_rInf = x[0];
+    result.m_gamma = x.mid(1);
+    result.m_lambda = jobs[best].m_lambda;
+    result.m_valid = true;
+
+    qDebug() << "DRT:" << count << "time constants, lambda" << result.m_lambda
+             << "cv error" << jobs[best].m_error << "R_inf" << result.m_rInf;
+
+    return result;
+}
+
+QFuture<CDrt::Result_t> CDrt::startCompute(const QVector<double>& freq,
+                                           const QVector<double>& re,
+                                           const QVector<double>& im)
+{
+    return QtConcurrent::run(compute, freq, re, im);
+}
@@ -0,0 +1,68 @@
+#ifndef CDRT_H
+#define CDRT_H
+
+#include <QVector>
+#include <QFuture>
+
+// Distribution of relaxation times. The spectrum is written as
+//
+//  Z(w) = R_inf + sum_k gamma_k * dln(tau) / (1 + j w tau_k)
+//
+// on a log spaced tau grid and solved as Tikhonov regularized non-negative
+// least squares (first derivative penalty on gamma). Lambda is chosen by
+// k-fold cross validation, the lambda candidates are evaluated in parallel.
+class CDrt
+{
+public:
+    typedef struct
+    {
+        QVector<double> m_tau;          // [s]
+        QVector<double> m_gamma;        // [Ohm]
+        double m_rInf;                  // [Ohm]
+        double m_lambda;
+        QVector<double> m_lambdas;      // candidates and their validation errors
+        QVector<double> m_cvErrors;
+        bool m_valid;
+    } Result_t;
+
+    // freq in Hz, im negative for capacitive behaviour
+    static Result_t compute(const QVector<double>& freq,
+                            const QVector<double>& re,
+                            const QVector<double>& im);
+
+    static QFuture<Result_t> startCompute(const QVector<double>& freq,
+                                          const QVector<double>& re,
+                                          const QVector<double>& im);
+
+    static const int m_gridPerDecade = 10;
+    static const int m_folds = 5;
+    static const int m_lambdaCount = 16;
+
+private:
+    // everything the solves share; the normal equations of each fold are
+    // kept separately, a training set is the total minus its fold
+    typedef struct
+    {
+        int m_cols;
+        QVector<double> m_penalty;              // D^T D, scaled to the data
+        QVector<QVector<double> > m_foldGram;   // A_f^T A_f
+        QVector<QVector<double> > m_foldRhs;    // A_f^T b_f
+        QVector<QVector<double> > m_foldA;      // rows of the fold, column major
+        QVector<QVector<double> > m_foldB;
+        QVector<double> m_gram;
+        QVector<double> m_rhs;
+    } Problem_t;
+
+    typedef struct
+    {
+        const Problem_t* mp_problem;
+        double m_lambda;
+        double m_error;
+    } CvJob_t;
+
+    static void solve(const Problem_t& problem, const double& lambda,
+                      const double* gram, const double* rhs, double* x);
+    static void crossValidate(CvJob_t& job);
+};
+
+#endif // CDRT_H
@@ -0,0 +1,46 @@
+#include "cdrtdialog.h"
+
+CDrtDialog::CDrtDialog(const CDrt::Result_t& result, const QString& title, QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle(QString("DRT - %1").arg(title));
+    resize(640, 420);
+
+    mp_plot = new QCustomPlot(this);
+    m_layout.addWidget(mp_plot);
+    m_layout.addWidget(&m_labelSummary);
+    setLayout(&m_layout);
+
+    m_labelSummary.setText(QString("R_inf = %1 Ohm   lambda = %2   %3 time constants")
+                           .arg(result.m_rInf, 0, 'g', 4)
+                           .arg(result.m_lambda, 0, 'g', 2)
+                           .arg(result.m_tau.size()));
+
+    initPlot(result);
+}
+
+CDrtDialog::~CDrtDialog()
+{
+
+}
+
+void CDrtDialog::initPlot(const CDrt::Result_t& result)
+{
+    mp_plot->setInteractions(QCP::iRangeDrag | QCP::iRangeZoom);
+    mp_plot->xAxis->setLabel("tau [s]");
+    mp_plot->yAxis->setLabel("gamma [Ohm]");
+
+    mp_plot->xAxis->setScaleType(QCPAxis::stLogarithmic);
+    mp_plot->xAxis->setScaleLogBase(10);
+    mp_plot->xAxis->setNumberFormat("eb");
+    mp_plot->xAxis->setNumberPrecision(0);
+    mp_plot->xAxis->setSubTickCount(8);
+
+    mp_plot->addGraph();
+    mp_plot->graph(0)->setName("DRT");
+    mp_plot->graph(0)->setData(result.m_tau, result.m_gamma);
+    mp_plot->graph(0)->setBrush(QBrush(QColor(0, 0, 255, 40)));
+
+    mp_plot->rescaleAxes();
+    mp_plot->replot();
+}
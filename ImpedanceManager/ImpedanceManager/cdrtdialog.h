@@ -0,0 +1,29 @@
+#ifndef CDRTDIALOG_H
+#define CDRTDIALOG_H
+
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QLabel>
+
+#include "qcustomplot.h"
+#include "cdrt.h"
+
+// Secondary window with the distribution of relaxation times of a sweep.
+class CDrtDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CDrtDialog(const CDrt::Result_t& result, const QString& title,
+                        QWidget *parent = 0);
+    ~CDrtDialog();
+
+private:
+    void initPlot(const CDrt::Result_t& result);
+
+    QVBoxLayout m_layout;
+    QLabel m_labelSummary;
+    QCustomPlot* mp_plot;
+};
+
+#endif // CDRTDIALOG_H
@@ -1,4 +1,12 @@
 #include "ceisproject.h"
+#include "cmeasurelimits.h"
+#include "cdrtdialog.h"
+#include "clogging.h"
+
+#include <QtMath>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
 
 CEisProject::CEisProject(CSerialThread* serialThread, QWidget *parent) :
     CGenericProject(serialThread, parent)
@@ -6,6 +14,13 @@ CEisProject::CEisProject(CSerialThread* serialThread, QWidget *parent) :
     Q_ASSERT(serialThread);
     //Q_ASSERT(parent);
 
+    mp_liveFit = NULL;
+    m_liveFitRunning = false;
+    m_liveFitShown = false;
+    m_refining = false;
+    m_descending = false;
+    m_amplitude = 0;
+
     initPlot();
     initFields();
 
@@ -15,6 +30,12 @@ CEisProject::CEisProject(CSerialThread* serialThread, QWidget *parent) :
 
 CEisProject::~CEisProject()
 {
+    if (mp_liveFit)
+    {
+        mp_liveFit->quit();
+        mp_liveFit->wait();
+        delete mp_liveFit;
+    }
 
 }
 
@@ -29,6 +50,23 @@ void CEisProject::initPlot()
     customPlot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
     customPlot->graph(0)->setName("EIS measure");
 
+    // fitted model, a curve since Re is not monotonic over frequency
+    mp_fitCurve = new QCPCurve(customPlot->xAxis, customPlot->yAxis);
+    customPlot->addPlottable(mp_fitCurve);
+    mp_fitCurve->setName("Circuit fit");
+    mp_fitCurve->setPen(QPen(Qt::red));
+
+    mp_fitLabel = new QCPItemText(customPlot);
+    customPlot->addItem(mp_fitLabel);
+    mp_fitLabel->setPositionAlignment(Qt::AlignTop|Qt::AlignLeft);
+    mp_fitLabel->position->setType(QCPItemPosition::ptAxisRectRatio);
+    mp_fitLabel->position->setCoords(0.02, 0.02);
+    mp_fitLabel->setFont(QFont("Courier", 10));
+    mp_fitLabel->setTextAlignment(Qt::AlignLeft);
+    mp_fitLabel->setPen(QPen(Qt::black));
+    mp_fitLabel->setBrush(QBrush(Qt::white));
+    mp_fitLabel->setVisible(false);
+
     m_upperXRange = 100000;
     m_lowerXRange = 0;
     m_upperYRange = 100000;
@@ -48,9 +86,114 @@ void CEisProject::initPlot()
     customPlot->yAxis->setScaleType(QCPAxis::stLogarithmic);
    */
 
+    initBodePlot();
     customPlot->replot();
 }
 
+void CEisProject::initBodePlot()
+{
+    mp_bodeRect = new QCPAxisRect(customPlot);
+    customPlot->plotLayout()->addElement(1, 0, mp_bodeRect);
+
+    // keep the left edges of both rects aligned
+    QCPMarginGroup* marginGroup = new QCPMarginGroup(customPlot);
+    customPlot->axisRect(0)->setMarginGroup(QCP::msLeft | QCP::msRight, marginGroup);
+    mp_bodeRect->setMarginGroup(QCP::msLeft | QCP::msRight, marginGroup);
+
+    QCPAxis* freqAxis = mp_bodeRect->axis(QCPAxis::atBottom);
+    QCPAxis* magnitudeAxis = mp_bodeRect->axis(QCPAxis::atLeft);
+    QCPAxis* phaseAxis = mp_bodeRect->axis(QCPAxis::atRight);
+
+    freqAxis->setLabel("Freq [Hz]");
+    freqAxis->setScaleType(QCPAxis::stLogarithmic);
+    freqAxis->setScaleLogBase(10);
+    freqAxis->setNumberFormat("eb");
+    freqAxis->setNumberPrecision(0);
+    freqAxis->setSubTickCount(8);
+
+    magnitudeAxis->setLabel("|Z| [Ohm]");
+    magnitudeAxis->setScaleType(QCPAxis::stLogarithmic);
+    magnitudeAxis->setScaleLogBase(10);
+    magnitudeAxis->setNumberFormat("eb");
+    magnitudeAxis->setNumberPrecision(0);
+
+    phaseAxis->setLabel("Phase [deg]");
+    phaseAxis->setVisible(true);
+    phaseAxis->setTickLabels(true);
+
+    mp_bodeMagnitude = customPlot->addGraph(freqAxis, magnitudeAxis);
+    mp_bodeMagnitude->setName("|Z|");
+    mp_bodeMagnitude->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
+
+    mp_bodePhase = customPlot->addGraph(freqAxis, phaseAxis);
+    mp_bodePhase->setName("Phase");
+    mp_bodePhase->setPen(QPen(Qt::darkGreen));
+    mp_bodePhase->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssSquare));
+
+    clearBode();
+}
+
+void CEisProject::addBodePoint(const double& real, const double& imag, const double& freq)
+{
+    double magnitude = std::hypot(real, imag);
+    double phase = std::atan2(imag, real) * 180.0 / M_PI;
+
+    mp_bodeMagnitude->addData(freq, magnitude);
+    mp_bodePhase->addData(freq, phase);
+
+    if (freq > 0)
+    {
+        m_bodeFreqMin = qMin(m_bodeFreqMin, freq);
+        m_bodeFreqMax = qMax(m_bodeFreqMax, freq);
+    }
+    if (magnitude > 0)
+    {
+        m_bodeMagnitudeMin = qMin(m_bodeMagnitudeMin, magnitude);
+        m_bodeMagnitudeMax = qMax(m_bodeMagnitudeMax, magnitude);
+    }
+    m_bodePhaseMin = qMin(m_bodePhaseMin, phase);
+    m_bodePhaseMax = qMax(m_bodePhaseMax, phase);
+}
+
+void CEisProject::clearBode()
+{
+    mp_bodeMagnitude->clearData();
+    mp_bodePhase->clearData();
+
+    m_bodeFreqMin = INFINITY;
+    m_bodeFreqMax = 0;
+    m_bodeMagnitudeMin = INFINITY;
+    m_bodeMagnitudeMax = 0;
+    m_bodePhaseMin = INFINITY;
+    m_bodePhaseMax = -INFINITY;
+
+    mp_bodeRect->axis(QCPAxis::atBottom)->setRange(1, 1000000);
+    mp_bodeRect->axis(QCPAxis::atLeft)->setRange(1, 100000);
+    mp_bodeRect->axis(QCPAxis::atRight)->setRange(-90, 0);
+}
+
+void CEisProject::autoScalePlot()
+{
+    // the Bode rect is drawn by the same replot as the Nyquist one
+    if (m_bodeFreqMax > 0)
+    {
+        mp_bodeRect->axis(QCPAxis::atBottom)->setRange(m_bodeFreqMin / 1.5, m_bodeFreqMax * 1.5);
+    }
+    if (m_bodeMagnitudeMax > 0)
+    {
+        mp_bodeRect->axis(QCPAxis::atLeft)->setRange(m_bodeMagnitudeMin / 1.5,
+                                                     m_bodeMagnitudeMax * 1.5);
+    }
+    if (m_bodePhaseMax >= m_bodePhaseMin)
+    {
+        double margin = qMax(5.0, 0.1 * (m_bodePhaseMax - m_bodePhaseMin));
+        mp_bodeRect->axis(QCPAxis::atRight)->setRange(m_bodePhaseMin - margin,
+                                                      m_bodePhaseMax + margin);
+    }
+
+    CGenericProject::autoScalePlot();
+}
+
 void CEisProject::initFields()
 {
     // amplitude
@@ -97,33 +240,59 @@ void CEisProject::initFields()
 
     m_cbTypeStep.addItem("Lin");
     m_cbTypeStep.addItem("Log");
+
+    // refinement points
+    m_labelRefine.setText("Refine");
+    ui->glControls->addWidget(&m_labelRefine, 4, 1);
+    m_sbRefine.setRange(0, 200);
+    m_sbRefine.setSpecialValueText("Off");
+    m_sbRefine.setToolTip("Points of a second pass, placed where the Nyquist arc changes fastest");
+    m_sbRefine.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_sbRefine, 5, 1);
+
+    // circuit
+    m_labelCircuit.setText("Circuit");
+    ui->glControls->addWidget(&m_labelCircuit, 6, 0);
+    m_leCircuit.setText("R0-p(R1,Q1)");
+    m_leCircuit.setToolTip("R, C, L, Q (CPE), W (Warburg), '-' series, p(a,b) parallel");
+    ui->glControls->addWidget(&m_leCircuit, 7, 0, 1, 2);
+
+    m_pbFit.setText("Fit");
+    m_pbFit.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_pbFit, 8, 0);
+
+    m_cbLiveFit.setText("Live");
+    m_cbLiveFit.setToolTip("Fit the circuit while the sweep is running");
+    ui->glControls->addWidget(&m_cbLiveFit, 8, 1);
+
+    m_pbDrt.setText("DRT");
+    m_pbDrt.setMaximumWidth(m_maxItemWidth);
+    m_pbDrt.setToolTip("Distribution of relaxation times");
+    ui->glControls->addWidget(&m_pbDrt, 9, 0);
+
+    connect(&m_pbFit, SIGNAL(clicked()), this, SLOT(on_fit_clicked()));
+    connect(&m_fitWatcher, SIGNAL(finished()), this, SLOT(on_fit_finished()));
+    connect(&m_pbDrt, SIGNAL(clicked()), this, SLOT(on_drt_clicked()));
+    connect(&m_drtWatcher, SIGNAL(finished()), this, SLOT(on_drt_finished()));
 }
 
-void CEisProject::takeMeasure()
+int CEisProject::takeMeasure()
 {
     bool ok;
-    QString badParameters;
 
     quint8 amp = (quint8)m_leAmplitude.text().toInt(&ok, 10);
-    if (!amp)
-        badParameters += m_labelAmplitude.text() + "\n";
 
     union32_t freqStart;
     freqStart.idFl = (float)m_leFreqStart.text().toDouble(&ok);
-    if (!freqStart.id32)
-        badParameters += m_labelFreqStart.text() + "\n";
 
     union32_t freqEnd;
     freqEnd.idFl = (float)m_leFreqStop.text().toDouble(&ok);
-    if (!freqEnd.id32)
-        badParameters += m_labelFreqStop.text() + "\n";
 
     qint16 freqStep = (qint16)m_leFreqStep.text().toInt(&ok, 10);
-    if (!freqStep)
-        badParameters += m_labelFreqStep.text() + "\n";
-
     EStepType_t step = (EStepType_t)m_cbTypeStep.currentIndex();
 
+    QString badParameters = CMeasureLimits::checkEis(amp, freqStart, freqEnd, freqStep);
+
     if(badParameters.length())
     {
         QMessageBox msgBox;
@@ -131,12 +300,51 @@ void CEisProject::takeMeasure()
         msgBox.setText("Empty fields detected!");
         msgBox.setInformativeText(badParameters);
         msgBox.exec();
-        return;
+        return -1;
+    }
+
+    m_liveFitRunning = false;
+    m_liveFitShown = false;
+    if (m_cbLiveFit.isChecked())
+    {
+        if (m_circuit.compile(m_leCircuit.text()))
+        {
+            QMessageBox msgBox;
+            msgBox.setIcon(QMessageBox::Critical);
+            msgBox.setText("Cannot fit circuit!");
+            msgBox.setInformativeText(m_circuit.lastError());
+            msgBox.exec();
+            return -1;
+        }
+
+        if (!mp_liveFit)
+        {
+            mp_liveFit = new CLiveCircuitFit();
+            mp_liveFit->moveToThread(mp_liveFit);
+            mp_liveFit->start();
+
+            connect(mp_liveFit, SIGNAL(fitUpdated(const QVector<double>&, const double&, const int&)),
+                    this, SLOT(on_liveFit_updated(const QVector<double>&, const double&, const int&)),
+                    Qt::UniqueConnection);
+        }
+
+        mp_liveFit->restart(m_circuit.description());
+        m_liveFitRunning = true;
+        m_liveFitShown = true;
     }
 
+    // the refinement bands follow the direction of the coarse sweep
+    m_amplitude = amp;
+    m_descending = (freqStart.idFl > freqEnd.idFl);
+    m_refining = false;
+    m_refineBands.clear();
+
     clearData();
+    clearFit();
+    clearBode();
     qDebug() << "Sending EIS measure request";
     emit send_takeMeasEis(amp, freqStart, freqEnd, freqStep, (quint8)step);
+    return 0;
 }
 
 void CEisProject::changeConnections(const bool con)
@@ -182,54 +390,230 @@ void CEisProject::on_received_takeMeasEis(const bool& ack)
         QMessageBox msgBox;
         msgBox.setIcon(QMessageBox::Critical);
         msgBox.setText("Measure init error!");
-        msgBox.setInformativeText("EIS measure cannot be started");
+        msgBox.setInformativeText(m_refining ? "EIS refinement pass cannot be started"
+                                             : "EIS measure cannot be started");
         msgBox.exec();
+
+        // the coarse points are there, they are kept
+        if (m_refining)
+            finishSweep();
+        else
+            m_liveFitRunning = false;
     }
-    else
+    else if (!m_refining)
         emit measureStarted();
 }
 
 void CEisProject::on_received_endMeasEis()
 {
+    drainSamples();
+
+    // a sequence sends its next run behind this end frame, the line is
+    // taken then and the sweep stays as it is
+    if (!m_refining && m_sbRefine.value() && !mp_serialThread->isMeasureActive())
+    {
+        m_refineBands = CEisSweepPlanner::refine(m_z, m_x, m_y, m_sbRefine.value());
+        if (m_descending)
+            std::reverse(m_refineBands.begin(), m_refineBands.end());
+
+        m_refining = !m_refineBands.isEmpty();
+    }
+
+    if (m_refining && !m_refineBands.isEmpty())
+    {
+        requestRefineBand();
+        return;
+    }
+
+    finishSweep();
+}
+
+void CEisProject::requestRefineBand()
+{
+    CEisSweepPlanner::Band_t band = m_refineBands.takeFirst();
+    union32_t freqStart;
+    union32_t freqEnd;
+
+    freqStart.idFl = (float)(m_descending ? band.m_freqLast : band.m_freqFirst);
+    freqEnd.idFl = (float)(m_descending ? band.m_freqFirst : band.m_freqLast);
+
+    // steps between the first and the last frequency
+    qCDebug(lcMeasure) << "EIS refinement:" << band.m_points << "points from" << freqStart.idFl
+                       << "to" << freqEnd.idFl << "Hz," << m_refineBands.size() << "bands left";
+    emit send_takeMeasEis(m_amplitude, freqStart, freqEnd, (qint16)(band.m_points - 1),
+                          (quint8)EStepType_t::eLog);
+}
+
+void CEisProject::finishSweep()
+{
+    if (m_refining)
+    {
+        m_refining = false;
+        m_refineBands.clear();
+        sortByFrequency();
+    }
+
+    m_liveFitRunning = false;
+    validateKramersKronig();
     insertLabels();
     emit measureFinished();
 }
 
+void CEisProject::sortByFrequency()
+{
+    // refinement points came after the coarse ones, the table and the CSV
+    // are in sweep order again
+    QVector<int> order(m_z.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [this](const int& a, const int& b)
+    {
+        return m_descending ? (m_z[a] > m_z[b]) : (m_z[a] < m_z[b]);
+    });
+
+    QVector<double> x(order.size()), y(order.size()), z(order.size());
+    QList<QTreeWidgetItem*> items;
+
+    for (int i = 0; i < order.size(); i++)
+    {
+        x[i] = m_x[order[i]];
+        y[i] = m_y[order[i]];
+        z[i] = m_z[order[i]];
+        items.append(eisItem(x[i], -y[i], z[i]));
+    }
+
+    m_x = x;
+    m_y = y;
+    m_z = z;
+
+    ui->twPoints->clear();
+    ui->twPoints->addTopLevelItems(items);
+}
+
 void CEisProject::on_received_giveMeasChunkEis(const union32_t& realImp,
                                                const union32_t& ImagImp,
                                                const union32_t& freq)
 {
-    m_x.append(realImp.idFl);
-    m_y.append(ImagImp.idFl * -1);
-    m_z.append(freq.idFl);
+    MeasSample_t sample;
+    sample.m_index = 0;
+    sample.m_data[0] = realImp.idFl;
+    sample.m_data[1] = ImagImp.idFl;
+    sample.m_data[2] = freq.idFl;
+
+    ingestSample(sample);
+    updatePlot();
+}
+
+void CEisProject::ingestSample(const MeasSample_t& sample)
+{
+    float real = sample.m_data[0];
+    float imag = sample.m_data[1];
+    float freq = sample.m_data[2];
 
-    addEisPoint(realImp.idFl, ImagImp.idFl, freq.idFl);
+    m_x.append(real);
+    m_y.append(imag * -1);
+    m_z.append(freq);
+
+    addEisPoint(real, imag, freq);
+    addBodePoint(real, imag, freq);
+
+    if (m_liveFitRunning)
+        mp_liveFit->postPoint(2 * M_PI * freq, real, imag);
     //customPlot->graph(0)->setData(m_x, m_y);
-    customPlot->graph(0)->addData(realImp.idFl, ImagImp.idFl * -1);
-    autoScalePlot();
+    customPlot->graph(0)->addData(real, imag * -1);
+}
+
+int CEisProject::importSamples(const CCsvReader::Table_t& table)
+{
+    // Real[Ohm],Imaginary[Ohm],Frequency[Hz], the imaginary part negated
+    if (table.m_columns.size() < 3)
+        return -1;
+
+    m_x = table.m_columns[0];
+    m_y = table.m_columns[1];
+    m_z = table.m_columns[2];
+    customPlot->graph(0)->setData(m_x, m_y);
+
+    QList<QTreeWidgetItem*> items;
+    for (int i = 0; i < m_x.size(); i++)
+    {
+        addBodePoint(m_x[i], -m_y[i], m_z[i]);
+
+        if (i < m_maxListedPoints)
+            items.append(eisItem(m_x[i], -m_y[i], m_z[i]));
+    }
+    ui->twPoints->addTopLevelItems(items);
 
-    qDebug("EIS point received. Real: %f Imag %f Freq %f", realImp.idFl, ImagImp.idFl, freq.idFl);
+    // the residuals go into the rows, so only when all are listed
+    if (m_x.size() <= m_maxListedPoints)
+        validateKramersKronig();
+    return 0;
 }
 
 void CEisProject::updateTree()
 {
     QStringList list;
-    list << QObject::tr("Real[Ohm]") << QObject::tr("Imag[Ohm]") << QObject::tr("Freq[Hz]");
+    list << QObject::tr("Real[Ohm]") << QObject::tr("Imag[Ohm]") << QObject::tr("Freq[Hz]")
+         << QObject::tr("KK Re[%]") << QObject::tr("KK Im[%]");
 
     ui->twPoints->setColumnCount(list.size());
     ui->twPoints->setHeaderLabels(list);
     ui->twPoints->header()->resizeSection(0, 66);
     ui->twPoints->header()->resizeSection(1, 66);
     ui->twPoints->header()->resizeSection(2, 66);
+    ui->twPoints->header()->resizeSection(3, 66);
+    ui->twPoints->header()->resizeSection(4, 66);
+}
+
+void CEisProject::validateKramersKronig()
+{
+    QVector<double> im(m_y.size());
+    for (int i = 0; i < m_y.size(); i++)
+        im[i] = -m_y[i];
+
+    CKramersKronig::Result_t result = CKramersKronig::validate(m_z, m_x, im);
+    if (!result.m_valid || (result.m_residualRe.size() != ui->twPoints->topLevelItemCount()))
+        return;
+
+    int outliers = 0;
+    for (int i = 0; i < result.m_residualRe.size(); i++)
+    {
+        QTreeWidgetItem* item = ui->twPoints->topLevelItem(i);
+        item->setText(3, QString::number(result.m_residualRe[i], 'f', 3));
+        item->setText(4, QString::number(result.m_residualIm[i], 'f', 3));
+
+        if ((qAbs(result.m_residualRe[i]) > m_kkResidualLimit) ||
+            (qAbs(result.m_residualIm[i]) > m_kkResidualLimit))
+        {
+            item->setForeground(3, QBrush(Qt::red));
+            item->setForeground(4, QBrush(Qt::red));
+            outliers++;
+        }
+    }
+
+    qDebug() << "Lin-KK:" << result.m_elements << "RC elements, mu" << result.m_mu
+             << "max residual" << result.m_maxResidual << "% points over"
+             << m_kkResidualLimit << "%:" << outliers;
+
+    if (outliers)
+        qWarning() << "Lin-KK:" << outliers << "points of the sweep fail the validity check";
 }
 
 void CEisProject::addEisPoint(const float& real, const float& imag, const float& freq)
 {
-    QTreeWidgetItem* item = new QTreeWidgetItem(ui->twPoints);
+    ui->twPoints->addTopLevelItem(eisItem(real, imag, freq));
+}
+
+QTreeWidgetItem* CEisProject::eisItem(const float& real, const float& imag, const float& freq)
+{
+    QTreeWidgetItem* item = new QTreeWidgetItem();
 
     item->setText(0, QString::number(real));
     item->setText(1, QString::number(imag));
     item->setText(2, QString::number(freq));
+
+    return item;
 }
 
 int CEisProject::saveToCsv(QIODevice* device)
@@ -255,6 +639,82 @@ int CEisProject::saveToCsv(QIODevice* device)
     return 0;
 }
 
+int CEisProject::saveProjectAs(QFile& file)
+{
+    qDebug() << "Saving EIS project.";
+
+    QList<SettingParam_t> paramList;
+    SettingParam_t param;
+
+    param.m_name = "measType";
+    param.m_value = QString("%1").arg((int)measureType());
+    paramList.append(param);
+
+    param.m_name = "amplitude";
+    param.m_value = m_leAmplitude.text();
+    paramList.append(param);
+
+    param.m_name = "freqStart";
+    param.m_value = m_leFreqStart.text();
+    paramList.append(param);
+
+    param.m_name = "freqStep";
+    param.m_value = m_leFreqStep.text();
+    paramList.append(param);
+
+    param.m_name = "freqStop";
+    param.m_value = m_leFreqStop.text();
+    paramList.append(param);
+
+    param.m_name = "stepType";
+    param.m_value = QString("%1").arg(m_cbTypeStep.currentIndex());
+    paramList.append(param);
+
+    param.m_name = "circuit";
+    param.m_value = m_leCircuit.text();
+    paramList.append(param);
+
+    param.m_name = "liveFit";
+    param.m_value = QString("%1").arg((int)m_cbLiveFit.isChecked());
+    paramList.append(param);
+
+    param.m_name = "refinePoints";
+    param.m_value = QString("%1").arg(m_sbRefine.value());
+    paramList.append(param);
+
+    CProjectManager projMan(file, paramList, true);
+    return 0;
+}
+
+int CEisProject::openProject(QFile& file)
+{
+    qDebug() << "Reading EIS project.";
+
+    QList<SettingParam_t> paramList;
+    CProjectManager projMan(file, paramList, false);
+
+    if (paramList.size() < 7)
+    {
+        qCritical() << "EIS project" << file.fileName() << "is missing fields";
+        return -1;
+    }
+
+    // update fields
+    m_leAmplitude.setText(paramList.takeFirst().m_value);
+    m_leFreqStart.setText(paramList.takeFirst().m_value);
+    m_leFreqStep.setText(paramList.takeFirst().m_value);
+    m_leFreqStop.setText(paramList.takeFirst().m_value);
+    m_cbTypeStep.setCurrentIndex(paramList.takeFirst().m_value.toInt());
+    m_leCircuit.setText(paramList.takeFirst().m_value);
+    m_cbLiveFit.setChecked(paramList.takeFirst().m_value.toInt());
+
+    // projects saved before the adaptive sweep have no refinement
+    if (!paramList.isEmpty())
+        m_sbRefine.setValue(paramList.takeFirst().m_value.toInt());
+
+    return 0;
+}
+
 int CEisProject::insertLabels()
 {
     if (m_x.size() != m_y.size() && m_x.size() != m_z.size())
@@ -288,10 +748,150 @@ int CEisProject::insertLabels()
     return 0;
 }
 
+CCircuitFitter::EisData_t CEisProject::fitData() const
+{
+    // m_y holds -Im, m_z the frequency in Hz
+    CCircuitFitter::EisData_t data;
 
+    for (int i = 0; i < m_x.size(); i++)
+    {
+        data.m_omega.append(2 * M_PI * m_z[i]);
+        data.m_re.append(m_x[i]);
+        data.m_im.append(-m_y[i]);
+    }
 
+    return data;
+}
 
+void CEisProject::on_fit_clicked()
+{
+    if (m_fitWatcher.isRunning() || m_liveFitRunning)
+        return;
+
+    QString error;
 
+    if (m_circuit.compile(m_leCircuit.text()))
+        error = m_circuit.lastError();
+    else if (m_x.size() * 2 < m_circuit.parameterCount())
+        error = QString("%1 parameters need at least %2 points")
+                .arg(m_circuit.parameterCount()).arg((m_circuit.parameterCount() + 1) / 2);
+
+    if (error.length())
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Critical);
+        msgBox.setText("Cannot fit circuit!");
+        msgBox.setInformativeText(error);
+        msgBox.exec();
+        return;
+    }
 
+    m_pbFit.setEnabled(false);
+    m_fitWatcher.setFuture(CCircuitFitter::startMultiStartFit(m_circuit, fitData()));
+}
 
+void CEisProject::on_fit_finished()
+{
+    m_pbFit.setEnabled(true);
 
+    CCircuitFitter::FitResult_t result = m_fitWatcher.result();
+    if (!std::isfinite(result.m_chiSquare))
+    {
+        qWarning() << "Circuit fit of" << m_circuit.description() << "failed";
+        return;
+    }
+
+    showFit(result.m_params, result.m_chiSquare, m_x.size());
+    customPlot->replot();
+}
+
+void CEisProject::on_drt_clicked()
+{
+    if (m_drtWatcher.isRunning() || m_liveFitRunning)
+        return;
+
+    if (m_x.size() < 2 * CDrt::m_folds)
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Critical);
+        msgBox.setText("Cannot compute DRT!");
+        msgBox.setInformativeText(QString("At least %1 points are needed").arg(2 * CDrt::m_folds));
+        msgBox.exec();
+        return;
+    }
+
+    QVector<double> im(m_y.size());
+    for (int i = 0; i < m_y.size(); i++)
+        im[i] = -m_y[i];
+
+    m_pbDrt.setEnabled(false);
+    m_drtWatcher.setFuture(CDrt::startCompute(m_z, m_x, im));
+}
+
+void CEisProject::on_drt_finished()
+{
+    m_pbDrt.setEnabled(true);
+
+    CDrt::Result_t result = m_drtWatcher.result();
+    if (!result.m_valid)
+    {
+        qWarning() << "DRT computation failed";
+        return;
+    }
+
+    QString title = workingFile().length() ? QFileInfo(workingFile()).fileName() : windowTitle();
+
+    CDrtDialog* dialog = new CDrtDialog(result, title, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void CEisProject::on_liveFit_updated(const QVector<double>& params, const double& chiSquare,
+                                     const int& points)
+{
+    // the last updates may come after the end of the sweep, but not after a restart
+    if (!m_liveFitShown || (points > m_x.size()))
+        return;
+
+    showFit(params, chiSquare, points);
+    updatePlot();
+}
+
+void CEisProject::showFit(const QVector<double>& params, const double& chiSquare,
+                          const int& points)
+{
+    if (m_z.isEmpty() || (params.size() != m_circuit.parameterCount()))
+        return;
+
+    double freqMin = m_z[0], freqMax = m_z[0];
+    for (double freq : m_z)
+    {
+        freqMin = qMin(freqMin, freq);
+        freqMax = qMax(freqMax, freq);
+    }
+
+    // log spaced over the measured band
+    mp_fitCurve->clearData();
+    for (int i = 0; i < m_fitCurvePoints; i++)
+    {
+        double freq = freqMin * std::pow(freqMax / freqMin, (double)i / (m_fitCurvePoints - 1));
+        complex_t z = m_circuit.impedance(2 * M_PI * freq, params.constData());
+        mp_fitCurve->addData(i, z.real(), -z.imag());
+    }
+
+    QString text = m_circuit.description();
+    for (int k = 0; k < params.size(); k++)
+        text += QString("\n%1 = %2").arg(m_circuit.parameterNames()[k], -6).arg(params[k], 0, 'g', 4);
+    text += QString("\nchi2  = %1").arg(chiSquare, 0, 'g', 3);
+    text += QString("\npoints = %1").arg(points);
+
+    mp_fitLabel->setText(text);
+    mp_fitLabel->setVisible(true);
+}
+
+void CEisProject::clearFit()
+{
+    mp_fitCurve->clearData();
+    mp_fitLabel->setVisible(false);
+    customPlot->replot();
+}
@@ -1,7 +1,17 @@
 #ifndef CEISPROJECT_H
 #define CEISPROJECT_H
 
+#include <QPushButton>
+#include <QCheckBox>
+#include <QFutureWatcher>
+
 #include "cgenericproject.h"
+#include "ccircuitmodel.h"
+#include "ccircuitfitter.h"
+#include "clivecircuitfit.h"
+#include "ckramerskronig.h"
+#include "cdrt.h"
+#include "ceissweepplanner.h"
 
 class CEisProject : public CGenericProject
 {
@@ -12,9 +22,11 @@ public:
     ~CEisProject();
 
     virtual EMeasures_t measureType(){ return EMeasures_t::eEIS; }
-    virtual void takeMeasure();
+    virtual int takeMeasure();
     virtual void changeConnections(const bool);
     virtual int saveToCsv(QIODevice* device);
+    virtual int saveProjectAs(QFile& file);
+    virtual int openProject(QFile& file);
 
 signals:
     void send_takeMeasEis(const quint8&, const union32_t&, const union32_t&,
@@ -25,6 +37,18 @@ private slots:
     void on_received_giveMeasChunkEis(const union32_t&, const union32_t&, const union32_t&);
     void on_received_endMeasEis();
 
+    void on_fit_clicked();
+    void on_fit_finished();
+    void on_drt_clicked();
+    void on_drt_finished();
+    void on_liveFit_updated(const QVector<double>& params, const double& chiSquare,
+                            const int& points);
+
+protected:
+    virtual void ingestSample(const MeasSample_t& sample);
+    virtual int importSamples(const CCsvReader::Table_t& table);
+    virtual void autoScalePlot();
+
 private:
     virtual void initPlot();
     virtual void initFields();
@@ -33,6 +57,18 @@ private:
     virtual int insertLabels();
 
     void addEisPoint(const float& real, const float& imag, const float& freq);
+    static QTreeWidgetItem* eisItem(const float& real, const float& imag, const float& freq);
+    void initBodePlot();
+    void addBodePoint(const double& real, const double& imag, const double& freq);
+    void clearBode();
+    CCircuitFitter::EisData_t fitData() const;
+    void showFit(const QVector<double>& params, const double& chiSquare,
+                 const int& points);
+    void clearFit();
+    void validateKramersKronig();
+    void requestRefineBand();
+    void finishSweep();
+    void sortByFrequency();
 
     QLabel m_labelAmplitude;
     QLineEdit m_leAmplitude;
@@ -48,6 +84,46 @@ private:
 
     QLabel m_labelStepType;
     QComboBox m_cbTypeStep;
+
+    // adaptive sweep: extra points of a second pass where the arc bends
+    QLabel m_labelRefine;
+    QSpinBox m_sbRefine;
+    QVector<CEisSweepPlanner::Band_t> m_refineBands;   // still to request
+    bool m_refining;                // the running request is a refinement band
+    bool m_descending;              // sweep direction, kept by the bands
+    quint8 m_amplitude;
+
+    // equivalent circuit fit
+    QLabel m_labelCircuit;
+    QLineEdit m_leCircuit;
+    QPushButton m_pbFit;
+    QCheckBox m_cbLiveFit;
+    QPushButton m_pbDrt;
+
+    CCircuitModel m_circuit;
+    QFutureWatcher<CCircuitFitter::FitResult_t> m_fitWatcher;
+    CLiveCircuitFit* mp_liveFit;    // created with the first live fit
+    bool m_liveFitRunning;          // points of the running sweep go to mp_liveFit
+    bool m_liveFitShown;            // its updates are drawn, until the next measure
+
+    QFutureWatcher<CDrt::Result_t> m_drtWatcher;
+    QCPCurve* mp_fitCurve;
+    QCPItemText* mp_fitLabel;
+
+    // Bode view below the Nyquist plot, |Z| on the left axis, phase on the
+    // right one; the ranges are tracked per point so a rescale is O(1)
+    QCPAxisRect* mp_bodeRect;
+    QCPGraph* mp_bodeMagnitude;
+    QCPGraph* mp_bodePhase;
+    double m_bodeFreqMin;
+    double m_bodeFreqMax;
+    double m_bodeMagnitudeMin;
+    double m_bodeMagnitudeMax;
+    double m_bodePhaseMin;
+    double m_bodePhaseMax;
+
+    static const int m_fitCurvePoints = 200;
+    static constexpr double m_kkResidualLimit = 1.0; // [%], beyond marked in the tree
 };
 
 #endif // CEISPROJECT_H
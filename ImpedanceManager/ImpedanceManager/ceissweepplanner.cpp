@@ -0,0 +1,117 @@
+#include "ceissweepplanner.h"
+
+#include <algorithm>
+#include <cmath>
+
+const int CEisSweepPlanner::m_minBandPoints;
+const int CEisSweepPlanner::m_maxBandPoints;
+
+QVector<CEisSweepPlanner::Band_t> CEisSweepPlanner::refine(const QVector<double>& freq,
+                                                           const QVector<double>& re,
+                                                           const QVector<double>& im,
+                                                           const int& budget)
+{
+    QVector<Band_t> bands;
+    if ((budget < m_minBandPoints) || (freq.size() != re.size()) || (freq.size() != im.size()))
+        return bands;
+
+    // frequency order, whatever the direction of the sweep
+    QVector<int> order;
+    for (int i = 0; i < freq.size(); i++)
+    {
+        if (freq[i] > 0)
+            order.append(i);
+    }
+
+    std::sort(order.begin(), order.end(), [&freq](const int& a, const int& b)
+    {
+        return freq[a] < freq[b];
+    });
+
+    const int n = order.size();
+    if (n < 3)
+        return bands;
+
+    double reMin = re[order[0]], reMax = reMin, imMin = im[order[0]], imMax = imMin;
+    for (int i = 1; i < n; i++)
+    {
+        reMin = qMin(reMin, re[order[i]]);
+        reMax = qMax(reMax, re[order[i]]);
+        imMin = qMin(imMin, im[order[i]]);
+        imMax = qMax(imMax, im[order[i]]);
+    }
+
+    const double scale = qMax(reMax - reMin, imMax - imMin);
+    if (scale <= 0)
+        return bands;
+
+    // turning of the arc at every inner point, 0 .. pi
+    QVector<double> turn(n, 0);
+    for (int i = 1; i < n - 1; i++)
+    {
+        double ax = re[order[i]] - re[order[i - 1]];
+        double ay = im[order[i]] - im[order[i - 1]];
+        double bx = re[order[i + 1]] - re[order[i]];
+        double by = im[order[i + 1]] - im[order[i]];
+
+        turn[i] = std::fabs(std::atan2(ax * by - ay * bx, ax * bx + ay * by));
+    }
+
+    QVector<double> weight(n - 1);
+    double mean = 0;
+    for (int i = 0; i < n - 1; i++)
+    {
+        double chord = std::hypot(re[order[i + 1]] - re[order[i]],
+                                  im[order[i + 1]] - im[order[i]]) / scale;
+
+        weight[i] = chord + (turn[i] + turn[i + 1]) / (2 * M_PI);
+        mean += weight[i];
+    }
+    mean /= n - 1;
+
+    if (mean <= 0)
+        return bands;
+
+    // points that bring every part of an interval down to the mean weight
+    QVector<int> points(n - 1, 0);
+    int total = 0;
+    for (int i = 0; i < n - 1; i++)
+    {
+        if ((weight[i] < m_threshold * mean) ||
+            (std::log10(freq[order[i + 1]] / freq[order[i]]) < m_minDecades))
+            continue;
+
+        points[i] = qBound(m_minBandPoints, (int)std::ceil(weight[i] / mean) - 1, m_maxBandPoints);
+        total += points[i];
+    }
+
+    // over budget, every band gives up its share
+    if (total > budget)
+    {
+        for (int i = 0; i < n - 1; i++)
+        {
+            points[i] = points[i] * budget / total;
+            if (points[i] < m_minBandPoints)
+                points[i] = 0;
+        }
+    }
+
+    for (int i = 0; i < n - 1; i++)
+    {
+        if (!points[i])
+            continue;
+
+        // the interval ends are measured already
+        double low = freq[order[i]];
+        double high = freq[order[i + 1]];
+        double ratio = std::pow(high / low, 1.0 / (points[i] + 1));
+
+        Band_t band;
+        band.m_freqFirst = low * ratio;
+        band.m_freqLast = high / ratio;
+        band.m_points = points[i];
+        bands.append(band);
+    }
+
+    return bands;
+}
@@ -0,0 +1,33 @@
+#ifndef CEISSWEEPPLANNER_H
+#define CEISSWEEPPLANNER_H
+
+#include <QVector>
+
+// Plans the refinement pass of an adaptive EIS sweep. The coarse points are
+// taken in frequency order and every interval between neighbours gets a
+// weight: its chord in the Nyquist plane, relative to the extent of the
+// spectrum, plus the turning of the arc at both of its ends. Intervals well
+// above the mean weight are split by extra log spaced frequencies until
+// their parts would weigh about the mean, within the point budget. Flat
+// parts of the spectrum get nothing.
+class CEisSweepPlanner
+{
+public:
+    typedef struct
+    {
+        double m_freqFirst;     // lowest new frequency, above the interval start
+        double m_freqLast;      // highest new one, below the interval end
+        int m_points;           // log spaced from first to last, >= m_minBandPoints
+    } Band_t;
+
+    // bands in ascending frequency, empty when the sweep is smooth enough
+    static QVector<Band_t> refine(const QVector<double>& freq, const QVector<double>& re,
+                                  const QVector<double>& im, const int& budget);
+
+    static constexpr double m_threshold = 1.5;     // of the mean interval weight
+    static constexpr double m_minDecades = 0.005;  // narrower intervals are left alone
+    static const int m_minBandPoints = 2;           // a sweep has a start and an end
+    static const int m_maxBandPoints = 20;
+};
+
+#endif // CEISSWEEPPLANNER_H
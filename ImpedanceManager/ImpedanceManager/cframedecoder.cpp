@@ -0,0 +1,187 @@
+#include "cframedecoder.h"
+#include "ccrc16.h"
+#include "ctelemetry.h"
+
+CFrameDecoder::CFrameDecoder() :
+    m_crcLog(lcFrame, "frames dropped on bad CRC"),
+    m_syncLog(lcFrame, "bytes out of frame skipped")
+{
+    mp_frameStruct = NULL;
+    m_currentIndex = 0;
+    m_newFrame = false;
+
+    m_crcMode.store((int)CSerialThread::ECrcMode_t::eLegacySum);
+    m_armedCrcMode.store(-1);
+    m_runningSum = 0;
+    m_runningCrc = CCrc16::m_init;
+    m_badCrcCount.store(0);
+}
+
+CFrameDecoder::~CFrameDecoder()
+{
+    if (mp_frameStruct && m_currentIndex) delete mp_frameStruct;
+
+    m_crcLog.flush();
+    m_syncLog.flush();
+}
+
+void CFrameDecoder::reset()
+{
+    if (mp_frameStruct && m_currentIndex) delete mp_frameStruct;
+
+    mp_frameStruct = NULL;
+    m_currentIndex = 0;
+    m_newFrame = false;
+    m_badCrcCount.store(0);
+
+    m_crcLog.flush();
+    m_syncLog.flush();
+}
+
+int CFrameDecoder::feed(const char* data, const int& length,
+                        QQueue<CSerialThread::ESerialFrame_t*>& frames)
+{
+    Q_ASSERT(data);
+
+    int errors = 0;
+    int errorCode = 0;
+
+    for (int i = 0; i < length; i++)
+    {
+        errorCode = digForFrames((quint8)data[i], frames);
+        if (errorCode)
+        {
+            qCDebugHot(lcFrame) << "Examinating bytes from serial port failed" << errorCode;
+            errors++;
+        }
+    }
+
+    if (errors)
+        m_syncLog.hit(errors);
+
+    return errors;
+}
+
+void CFrameDecoder::setCrcMode(const CSerialThread::ECrcMode_t& mode)
+{
+    m_crcMode.store((int)mode);
+}
+
+CSerialThread::ECrcMode_t CFrameDecoder::crcMode() const
+{
+    return (CSerialThread::ECrcMode_t)m_crcMode.load();
+}
+
+void CFrameDecoder::armCrcMode(const CSerialThread::ECrcMode_t& mode)
+{
+    // The device acknowledges the change with the old check and uses the new
+    // one from the very next frame, so the switch has to happen here, between
+    // two bytes, not later in the dispatching thread.
+    m_armedCrcMode.store((int)mode);
+}
+
+void CFrameDecoder::disarmCrcMode()
+{
+    m_armedCrcMode.store(-1);
+}
+
+void CFrameDecoder::accumulateCrc(const quint8& data)
+{
+    // legacy sum takes the length as a number, not as its bytes
+    if ((m_currentIndex < 2) || (m_currentIndex >= m_lastLen))
+        m_runningSum += data;
+
+    m_runningCrc = CCrc16::update(m_runningCrc, data);
+}
+
+qint16 CFrameDecoder::finalCrc() const
+{
+    if (CSerialThread::ECrcMode_t::eCrc16Ccitt == crcMode())
+        return (qint16)m_runningCrc;
+
+    quint32 crc = m_runningSum + (qint16)mp_frameStruct->m_length;
+    return ~crc;
+}
+
+int CFrameDecoder::digForFrames(const quint8& data,
+                                QQueue<CSerialThread::ESerialFrame_t*>& frames)
+{
+    if (0 == m_currentIndex)
+    {
+        if (CSerialThread::m_syncByte == data)
+        {
+            mp_frameStruct = new CSerialThread::ESerialFrame_t;
+            mp_frameStruct->m_length = 0;
+
+            mp_frameStruct->m_syncByte = data;
+            m_newFrame = true;
+
+            m_runningSum = 0;
+            m_runningCrc = CCrc16::m_init;
+            accumulateCrc(data);
+        }
+        else return 1;
+    }
+    else if (m_newFrame)
+    {
+        if (1 == m_currentIndex)
+        {
+            mp_frameStruct->m_command = (CSerialThread::ESerialCommand_t)data;
+            accumulateCrc(data);
+        }
+        else if ((m_currentIndex > 1) && (m_currentIndex < m_lastLen))
+        {
+            mp_frameStruct->m_length |= (data << (8 * (m_currentIndex - 2)));
+            accumulateCrc(data);
+        }
+        else
+        {
+            if ((m_currentIndex - m_lastLen) < (mp_frameStruct->m_length - 1))
+            {
+                if ((m_currentIndex - m_lastLen) == (mp_frameStruct->m_length - 2))
+                    mp_frameStruct->m_crc = data;
+                else
+                {
+                    mp_frameStruct->m_data.append(data);
+                    accumulateCrc(data);
+                }
+            }
+            else if ((m_currentIndex - m_lastLen) == (mp_frameStruct->m_length - 1)) // last byte
+            {
+                mp_frameStruct->m_crc |= (data << 8);
+
+                qint16 calculatedCrc = finalCrc();
+                if (mp_frameStruct->m_crc == calculatedCrc)
+                {
+                    if ((CSerialThread::ESerialCommand_t::e_setCrcMode == mp_frameStruct->m_command) &&
+                        (m_armedCrcMode.load() >= 0) && mp_frameStruct->m_data.length() &&
+                        (0 == mp_frameStruct->m_data[0]))
+                    {
+                        m_crcMode.store(m_armedCrcMode.fetchAndStoreOrdered(-1));
+                    }
+
+                    mp_frameStruct->m_received_ns = CTelemetry::instance()->now();
+                    frames.enqueue(mp_frameStruct);
+                    CTelemetry::instance()->count(CTelemetry::ECounter_t::eFrames);
+                }
+                else
+                {
+                    qCDebugHot(lcFrame, "Bad CRC. Received 0x%X Calculated 0x%X",
+                               (quint16)mp_frameStruct->m_crc, (quint16)calculatedCrc);
+                    m_badCrcCount.fetchAndAddRelaxed(1);
+                    m_crcLog.hit();
+                    CTelemetry::instance()->count(CTelemetry::ECounter_t::eCrcErrors);
+                    delete mp_frameStruct;
+                }
+
+                mp_frameStruct = NULL;
+                m_currentIndex = 0;
+                return 0;
+            }
+        }
+    }
+    else return 2;
+
+    m_currentIndex++;
+    return 0;
+}
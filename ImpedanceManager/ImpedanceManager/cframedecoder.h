@@ -0,0 +1,52 @@
+#ifndef CFRAMEDECODER_H
+#define CFRAMEDECODER_H
+
+#include <QQueue>
+#include <QAtomicInt>
+#include <QDebug>
+
+#include "cserialthread.h"
+#include "clogging.h"
+
+// Byte wise frame parser. Keeps its state between calls, so the bytes can be
+// fed in any portions, by any backend (and thread) reading the serial port.
+// The checksum is accumulated while the bytes arrive, so a frame is verified
+// as soon as its last byte is in.
+class CFrameDecoder
+{
+public:
+    CFrameDecoder();
+    ~CFrameDecoder();
+
+    int feed(const char* data, const int& length,
+             QQueue<CSerialThread::ESerialFrame_t*>& frames);
+    void reset();
+
+    void setCrcMode(const CSerialThread::ECrcMode_t& mode);
+    CSerialThread::ECrcMode_t crcMode() const;
+    void armCrcMode(const CSerialThread::ECrcMode_t& mode);
+    void disarmCrcMode();
+    quint32 badCrcCount() const { return (quint32)m_badCrcCount.load(); }
+
+private:
+    int digForFrames(const quint8& data,
+                     QQueue<CSerialThread::ESerialFrame_t*>& frames);
+    void accumulateCrc(const quint8& data);
+    qint16 finalCrc() const;
+
+    CSerialThread::ESerialFrame_t* mp_frameStruct;
+    quint32 m_currentIndex;
+    bool m_newFrame;
+
+    QAtomicInt m_crcMode;       // may be switched from the dispatching thread
+    QAtomicInt m_armedCrcMode;  // taken over with the e_setCrcMode acknowledge, -1 none
+    quint32 m_runningSum;       // legacy additive checksum
+    quint16 m_runningCrc;       // CRC-16-CCITT
+    QAtomicInt m_badCrcCount;
+    CLogThrottle m_crcLog;
+    CLogThrottle m_syncLog;
+
+    static const quint32 m_lastLen = 2 + sizeof(quint32); // sync + command + length
+};
+
+#endif // CFRAMEDECODER_H
@@ -1,4 +1,11 @@
 #include "cgenericproject.h"
+#include "ctelemetry.h"
+#include "clogging.h"
+
+#include <QMetaMethod>
+
+const int CGenericProject::m_drainBatch;
+const int CGenericProject::m_maxListedPoints;
 
 CGenericProject::CGenericProject(CSerialThread* serialThread, QWidget *parent) :
     QDialog(parent),
@@ -16,6 +23,11 @@ CGenericProject::CGenericProject(CSerialThread* serialThread, QWidget *parent) :
 
     mp_serialThread = serialThread;
     m_labelsVisible = false;
+
+    // samples of a running measure arrive through the queue, drained on a tick
+    m_sampleQueue = QSharedPointer<CSampleQueue>(new CSampleQueue());
+    m_drainTimer.setInterval(m_drainInterval_ms);
+    connect(&m_drainTimer, SIGNAL(timeout()), this, SLOT(drainSamples()));
 }
 
 CGenericProject::~CGenericProject()
@@ -92,9 +104,10 @@ void CGenericProject::rangeXChanged(const QCPRange &newRange, const QCPRange &ol
                newRange, oldRange, m_tickStepX);
 }
 
-void CGenericProject::takeMeasure()
+int CGenericProject::takeMeasure()
 {
     qCritical() << "ERROR: Base class takeMeasure method called!";
+    return -1;
 }
 
 void CGenericProject::initFields()
@@ -107,6 +120,33 @@ void CGenericProject::changeConnections(const bool)
     qCritical() << "ERROR: Base class changeConnections method called!";
 }
 
+void CGenericProject::connectRequests(const bool con)
+{
+    // only the send_xxx signals, each to the on_send_xxx slot of the serial
+    // thread, so a project can queue its request while another one owns the
+    // answers and chunks
+    const QMetaObject* sender = metaObject();
+    const QMetaObject* receiver = mp_serialThread->metaObject();
+
+    for (int i = 0; i < sender->methodCount(); i++)
+    {
+        QMetaMethod signal = sender->method(i);
+
+        if ((QMetaMethod::Signal != signal.methodType()) ||
+            !signal.methodSignature().startsWith("send_"))
+            continue;
+
+        int slot = receiver->indexOfSlot("on_" + signal.methodSignature());
+        if (slot < 0)
+            continue;
+
+        if (con)
+            connect(this, signal, mp_serialThread, receiver->method(slot), Qt::UniqueConnection);
+        else
+            disconnect(this, signal, mp_serialThread, receiver->method(slot));
+    }
+}
+
 void CGenericProject::clearData()
 {
     m_x.clear();
@@ -123,9 +163,192 @@ void CGenericProject::clearData()
     else
         customPlot->graph(0)->clearData();
 
+    if (mp_filterCurve)
+    {
+        mp_filterCurve->clearData();
+        m_filter.reset();
+    }
+
     customPlot->replot();
 }
 
+void CGenericProject::initFilter()
+{
+    m_cbFilter.addItem("No filter", (int)EFilterType_t::eNone);
+    m_cbFilter.addItem("Savitzky-Golay", (int)EFilterType_t::eSavitzkyGolay);
+    m_cbFilter.addItem("Median", (int)EFilterType_t::eMedian);
+    m_cbFilter.addItem("Exponential", (int)EFilterType_t::eExponential);
+
+    m_sbFilterWindow.setRange(CSignalFilter::m_minWindow, CSignalFilter::m_maxWindow);
+    m_sbFilterWindow.setValue(9);
+    m_sbFilterWindow.setSingleStep(2);
+    m_sbFilterWindow.setPrefix("W ");
+    m_sbFilterWindow.setToolTip("Window [samples]");
+
+    m_sbFilterOrder.setRange(0, CSignalFilter::m_maxOrder);
+    m_sbFilterOrder.setValue(2);
+    m_sbFilterOrder.setPrefix("O ");
+    m_sbFilterOrder.setToolTip("Savitzky-Golay polynomial order");
+
+    m_glFilter.addWidget(&m_cbFilter, 0, 0, 1, 2);
+    m_glFilter.addWidget(&m_sbFilterWindow, 1, 0);
+    m_glFilter.addWidget(&m_sbFilterOrder, 1, 1);
+    ui->glSpace->addLayout(&m_glFilter, 2, 0);
+
+    mp_filterCurve = new QCPCurve(customPlot->xAxis, customPlot->yAxis);
+    customPlot->addPlottable(mp_filterCurve);
+    mp_filterCurve->setName("Filtered");
+    mp_filterCurve->setPen(QPen(QColor(255, 120, 0), 2));
+    mp_filterCurve->setVisible(false);
+
+    connect(&m_cbFilter, SIGNAL(currentIndexChanged(int)), this, SLOT(on_filter_changed()));
+    connect(&m_sbFilterWindow, SIGNAL(valueChanged(int)), this, SLOT(on_filter_changed()));
+    connect(&m_sbFilterOrder, SIGNAL(valueChanged(int)), this, SLOT(on_filter_changed()));
+}
+
+void CGenericProject::on_filter_changed()
+{
+    EFilterType_t type = (EFilterType_t)m_cbFilter.currentData().toInt();
+    m_sbFilterOrder.setEnabled(type == EFilterType_t::eSavitzkyGolay);
+
+    if (m_filter.configure(type, m_sbFilterWindow.value(), m_sbFilterOrder.value()))
+    {
+        m_filter.configure(EFilterType_t::eNone, m_sbFilterWindow.value());
+        m_cbFilter.setStyleSheet("color: red");
+    }
+    else
+        m_cbFilter.setStyleSheet("");
+
+    applyFilter();
+    customPlot->replot();
+}
+
+void CGenericProject::filterSample(const double& x, const double& y)
+{
+    if (!mp_filterCurve || (m_filter.type() == EFilterType_t::eNone))
+        return;
+
+    mp_filterCurve->addData(m_y.size() - 1, x, m_filter.push(y));
+}
+
+void CGenericProject::applyFilter()
+{
+    if (!mp_filterCurve)
+        return;
+
+    mp_filterCurve->clearData();
+    m_filter.reset();
+
+    bool enabled = (m_filter.type() != EFilterType_t::eNone);
+    mp_filterCurve->setVisible(enabled);
+    if (!enabled || (m_x.size() != m_y.size()))
+        return;
+
+    QVector<double> filtered, keys(m_y.size());
+    m_filter.apply(m_y, filtered);
+
+    for (int i = 0; i < keys.size(); i++)
+        keys[i] = i;
+    mp_filterCurve->setData(keys, m_x, filtered);
+
+    // prime the streaming state, so further samples continue seamlessly
+    for (int i = qMax(0, m_y.size() - m_filter.window()); i < m_y.size(); i++)
+        m_filter.push(m_y[i]);
+}
+
+void CGenericProject::ingestSample(const MeasSample_t&)
+{
+    qCritical() << "ERROR: Base class ingestSample method called!";
+}
+
+int CGenericProject::importSamples(const CCsvReader::Table_t&)
+{
+    qCritical() << "ERROR: Base class importSamples method called!";
+    return -10;
+}
+
+int CGenericProject::importCsv(const CCsvReader::Table_t& table)
+{
+    if (CCsvReader::measureOf(table.m_header) != measureType())
+    {
+        qCritical() << table.m_fileName << "is not a CSV of this measure type";
+        return -1;
+    }
+
+    if (!m_x.isEmpty())
+    {
+        qCritical() << "Cannot import" << table.m_fileName << "into a project holding data";
+        return -1;
+    }
+
+    if (importSamples(table))
+        return -1;
+
+    applyFilter();
+
+    // a label item per point, far too many for a long record
+    if (m_x.size() <= m_maxListedPoints)
+        insertLabels();
+    else
+        qCDebug(lcMeasure) << "Imported" << m_x.size() << "points, only the first"
+                           << m_maxListedPoints << "listed";
+
+    updatePlot();
+    return 0;
+}
+
+void CGenericProject::setSampleStreaming(const bool enable)
+{
+    if (enable)
+    {
+        m_sampleQueue->resetStatistics();
+        m_drainTimer.start();
+    }
+    else
+    {
+        m_drainTimer.stop();
+        drainSamples();
+
+        qCDebug(lcMeasure) << "Sample queue high-water mark" << m_sampleQueue->highWaterMark()
+                           << "of" << m_sampleQueue->capacity();
+
+        if (m_sampleQueue->droppedSamples())
+            qCWarning(lcMeasure) << "Sample queue overflow," << m_sampleQueue->droppedSamples()
+                                 << "samples dropped";
+    }
+}
+
+void CGenericProject::drainSamples()
+{
+    CTelemetry* telemetry = CTelemetry::instance();
+    MeasSample_t samples[m_drainBatch];
+    int total = 0;
+    int count = 0;
+
+    do
+    {
+        count = m_sampleQueue->pop(samples, m_drainBatch);
+        if (!count)
+            break;
+
+        qint64 start_ns = telemetry->now();
+        for (int i = 0; i < count; i++)
+            ingestSample(samples[i]);
+        telemetry->record(CTelemetry::EStage_t::eAppend, start_ns);
+
+        // the newest one, it waited longest for its replot
+        m_lastReceived_ns = samples[count - 1].m_received_ns;
+        total += count;
+    }
+    while (count == m_drainBatch);
+
+    telemetry->count(CTelemetry::ECounter_t::eSamples, total);
+
+    // one replot per tick, no matter how many samples came
+    if (total)
+        updatePlot();
+}
+
 void CGenericProject::updateTree()
 {
     qCritical() << "ERROR: Base class updateTree method called!";
@@ -196,6 +419,38 @@ void CGenericProject::autoScalePlot()
     customPlot->replot();
 }
 
+void CGenericProject::updatePlot()
+{
+    // background tabs keep ingesting data, rendering is deferred until shown
+    if (isVisible())
+    {
+        CTelemetry* telemetry = CTelemetry::instance();
+        qint64 start_ns = telemetry->now();
+
+        autoScalePlot();
+        m_replotPending = false;
+
+        telemetry->record(CTelemetry::EStage_t::eReplot, start_ns);
+        telemetry->count(CTelemetry::ECounter_t::eReplots);
+
+        if (m_lastReceived_ns)
+        {
+            telemetry->record(CTelemetry::EStage_t::eEndToEnd, m_lastReceived_ns);
+            m_lastReceived_ns = 0;
+        }
+    }
+    else
+        m_replotPending = true;
+}
+
+void CGenericProject::showEvent(QShowEvent* event)
+{
+    QDialog::showEvent(event);
+
+    if (m_replotPending)
+        updatePlot();
+}
+
 double CGenericProject::getYMax()
 {
     double topVal = 0;
@@ -364,6 +619,11 @@ void CGenericProject::on_twPoints_itemSelectionChanged()
 {
     int index = ui->twPoints->currentIndex().row();
 
+    // no labels while measuring, nor for a long import
+    if ((index < 0) || (index >= m_pointLabels.size()) ||
+        (m_lastSelectedItemIndex >= m_pointLabels.size()))
+        return;
+
     m_pointLabels[m_lastSelectedItemIndex]->setVisible(false);
     m_pointLabels[index]->setVisible(true);
 
@@ -6,6 +6,11 @@
 #include <QIntValidator>
 #include <QStringList>
 #include <QIODevice>
+#include <QShowEvent>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QComboBox>
+#include <QSpinBox>
 
 #include "ui_cgenericproject.h"
 #include "qcustomplot.h"
@@ -13,6 +18,9 @@
 #include "cserialthread.h"
 #include "doublevalidator.h"
 #include "cprojectmanager.h"
+#include "csamplequeue.h"
+#include "csignalfilter.h"
+#include "ccsvreader.h"
 
 using namespace MeasureUtility;
 
@@ -29,8 +37,9 @@ public:
     ~CGenericProject();
 
     virtual EMeasures_t measureType(){ return EMeasures_t::eDummy; }
-    virtual void takeMeasure();
+    virtual int takeMeasure();
     virtual void changeConnections(const bool);
+    void connectRequests(const bool con);
 
     virtual void zoomOut();
     virtual void zoomIn();
@@ -40,11 +49,18 @@ public:
     virtual int saveProjectAs(QFile& file);
     virtual int openProject(QFile& file);
 
+    // fills an empty project with a table read from one of its own CSV
+    // exports, the tree and the plot are built once at the end
+    int importCsv(const CCsvReader::Table_t& table);
+
     void toggleLabels();
 
     const QString& workingFile(){ return fileName; }
     void setWorkingFile(const QString& file) { fileName = file; }
 
+    QSharedPointer<CSampleQueue> sampleQueue() { return m_sampleQueue; }
+    void setSampleStreaming(const bool enable);
+
 signals:
     void measureStarted();
     void measureFinished();
@@ -57,6 +73,10 @@ private slots:
     void rangeXChanged(const QCPRange &newRange, const QCPRange &oldRange);
 
     void on_twPoints_itemSelectionChanged();
+    void on_filter_changed();
+
+protected slots:
+    void drainSamples();
 
 private:
     virtual void initPlot();
@@ -67,13 +87,18 @@ private:
     QString fileName = NULL;
 
 protected:
-    void autoScalePlot();
+    virtual void showEvent(QShowEvent* event);
+    virtual void ingestSample(const MeasSample_t& sample);
+    virtual int importSamples(const CCsvReader::Table_t& table);
+
+    virtual void autoScalePlot();
+    void updatePlot();
     void clearData();
 
-    double getYMax();
-    double getYMin();
-    double getXMax();
-    double getXMin();
+    virtual double getYMax();
+    virtual double getYMin();
+    virtual double getXMax();
+    virtual double getXMin();
 
     void setNewRange(QCPAxis* axis, const double& upperRange, const double& lowerRange,
                                 const QCPRange &newRange, const QCPRange &oldRange,
@@ -81,6 +106,11 @@ protected:
     void setLabelsVisible(bool val);
     void clearLabels();
 
+    // smoothing of m_y over the sample order, drawn next to the raw trace
+    void initFilter();
+    void filterSample(const double& x, const double& y);
+    void applyFilter();
+
     Ui::CGenericProject *ui;
 
     QCustomPlot* customPlot;
@@ -104,11 +134,27 @@ protected:
     QVector<QCPItemText*> m_pointLabels;
     bool m_labelsVisible;
     int m_lastSelectedItemIndex = 0;
+    bool m_replotPending = false; // data arrived while the tab was hidden
+    qint64 m_lastReceived_ns = 0; // newest drained sample not on screen yet, telemetry
 
     constexpr static double zoomInFactor = 1 / 1.5;
     constexpr static double zoomOutFactor = 1.5;
 
     QStringList m_treeLabels;
+
+    QGridLayout m_glFilter;
+    QComboBox m_cbFilter;
+    QSpinBox m_sbFilterWindow;
+    QSpinBox m_sbFilterOrder;
+    CSignalFilter m_filter;
+    QCPCurve* mp_filterCurve = NULL;    // created by initFilter
+
+    QSharedPointer<CSampleQueue> m_sampleQueue;
+    QTimer m_drainTimer;
+
+    static const int m_drainInterval_ms = 50;
+    static const int m_drainBatch = 256;
+    static const int m_maxListedPoints = 10000; // tree rows and labels of an import
 };
 
 #endif // CGENERICPROJECT_H
@@ -0,0 +1,104 @@
+#include "chdrhistogram.h"
+
+CHdrHistogram::CHdrHistogram()
+{
+    reset();
+}
+
+int CHdrHistogram::bucketIndex(const qint64& value)
+{
+    if (value < 2 * m_subBuckets)
+        return (value < 0) ? 0 : (int)value;
+
+    quint64 v = value;
+    if (value > m_maxValue)
+        v = m_maxValue;
+    int msb = 63 - qCountLeadingZeroBits(v);
+    int shift = msb - m_subBits;
+
+    // top m_subBits + 1 bits, the leading one selects the power of two
+    return 2 * m_subBuckets + (shift - 1) * m_subBuckets + (int)((v >> shift) - m_subBuckets);
+}
+
+qint64 CHdrHistogram::bucketValue(const int& index)
+{
+    if (index < 2 * m_subBuckets)
+        return index;
+
+    int shift = (index - 2 * m_subBuckets) / m_subBuckets + 1;
+    qint64 sub = m_subBuckets + (index - 2 * m_subBuckets) % m_subBuckets;
+    return sub << shift;
+}
+
+void CHdrHistogram::record(const qint64& value)
+{
+    m_buckets[bucketIndex(value)].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_sum.fetchAndAddRelaxed(value);
+
+    qint64 current = m_min.load();
+    while ((value < current) && !m_min.testAndSetRelaxed(current, value))
+        current = m_min.load();
+
+    current = m_max.load();
+    while ((value > current) && !m_max.testAndSetRelaxed(current, value))
+        current = m_max.load();
+}
+
+void CHdrHistogram::reset()
+{
+    for (int i = 0; i < m_bucketCount; i++)
+        m_buckets[i].store(0);
+
+    m_count.store(0);
+    m_sum.store(0);
+    m_min.store(m_maxValue);
+    m_max.store(0);
+}
+
+quint64 CHdrHistogram::count() const
+{
+    return m_count.load();
+}
+
+qint64 CHdrHistogram::min() const
+{
+    return m_count.load() ? m_min.load() : 0;
+}
+
+qint64 CHdrHistogram::max() const
+{
+    return m_max.load();
+}
+
+double CHdrHistogram::mean() const
+{
+    quint64 count = m_count.load();
+    return count ? (double)m_sum.load() / count : 0;
+}
+
+qint64 CHdrHistogram::percentile(const double& quantile) const
+{
+    // the buckets are read one by one while records go on, the total is
+    // taken from them and not from m_count so the walk always ends
+    quint64 total = 0;
+    for (int i = 0; i < m_bucketCount; i++)
+        total += m_buckets[i].load();
+
+    if (!total)
+        return 0;
+
+    quint64 rank = (quint64)(qBound(0.0, quantile, 1.0) * total + 0.5);
+    if (!rank)
+        rank = 1;
+
+    quint64 seen = 0;
+    for (int i = 0; i < m_bucketCount; i++)
+    {
+        seen += m_buckets[i].load();
+        if (seen >= rank)
+            return bucketValue(i);
+    }
+
+    return max();
+}
@@ -0,0 +1,47 @@
+#ifndef CHDRHISTOGRAM_H
+#define CHDRHISTOGRAM_H
+
+#include <QtGlobal>
+#include <QAtomicInteger>
+
+// Log-linear latency histogram in the manner of HdrHistogram: every power of
+// two is split into m_subBuckets linear buckets, so any value is kept with
+// about 3 % relative error from 1 ns up to m_maxValue, in a fixed array.
+// record() is wait-free and may run in any thread while another one reads.
+class CHdrHistogram
+{
+public:
+    CHdrHistogram();
+
+    void record(const qint64& value);
+    void reset();
+
+    quint64 count() const;
+    qint64 min() const;
+    qint64 max() const;
+    double mean() const;
+
+    // value at the given quantile (0 .. 1), lower bound of its bucket
+    qint64 percentile(const double& quantile) const;
+
+    static int bucketIndex(const qint64& value);
+    static qint64 bucketValue(const int& index);
+
+    static const int m_subBits = 5;
+    static const int m_subBuckets = 1 << m_subBits;                 // 32
+    static const int m_maxBits = 40;                                // ~18 minutes in ns
+    static const qint64 m_maxValue = (Q_INT64_C(1) << m_maxBits) - 1;
+    static const int m_bucketCount = 2 * m_subBuckets +
+                                     (m_maxBits - m_subBits - 1) * m_subBuckets;
+
+    quint32 bucket(const int& index) const { return m_buckets[index].load(); }
+
+private:
+    QAtomicInteger<quint32> m_buckets[m_bucketCount];
+    QAtomicInteger<quint64> m_count;
+    QAtomicInteger<qint64> m_sum;
+    QAtomicInteger<qint64> m_min;
+    QAtomicInteger<qint64> m_max;
+};
+
+#endif // CHDRHISTOGRAM_H
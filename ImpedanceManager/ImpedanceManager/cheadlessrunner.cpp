@@ -0,0 +1,444 @@
+#include "cheadlessrunner.h"
+#include "cprojectmanager.h"
+#include "csettingsmanager.h"
+#include "cmeasurelimits.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTextStream>
+
+const int CHeadlessRunner::m_drainBatch;
+const int CHeadlessRunner::m_queueCapacity;
+
+CHeadlessRunner::CHeadlessRunner(const QString& projectFile, const QString& outputFile,
+                                 QObject* parent) :
+    QObject(parent)
+{
+    qRegisterMetaType< MeasureUtility::union32_t >("MeasureUtility::union32_t");
+    qRegisterMetaType< union32_t >("union32_t");
+    qRegisterMetaType< QSharedPointer<CSampleQueue> >("QSharedPointer<CSampleQueue>");
+
+    m_projectFile = projectFile;
+    m_outputFile = outputFile;
+    m_timeout_s = 0;
+    m_maxCrcRate = 0.01;
+    m_measure = EMeasures_t::eDummy;
+    mp_serialThread = NULL;
+    m_samples = 0;
+    m_finished = false;
+
+    m_drainTimer.setInterval(m_drainInterval_ms);
+    connect(&m_drainTimer, SIGNAL(timeout()), this, SLOT(on_drain()));
+
+    m_deadlineTimer.setSingleShot(true);
+    connect(&m_deadlineTimer, SIGNAL(timeout()), this, SLOT(on_deadline()));
+}
+
+CHeadlessRunner::~CHeadlessRunner()
+{
+    if (mp_serialThread)
+    {
+        mp_serialThread->quit();
+        mp_serialThread->wait();
+        delete mp_serialThread;
+    }
+}
+
+int CHeadlessRunner::loadProject()
+{
+    QFile file(m_projectFile);
+    m_measure = CProjectManager::measureType(file);
+
+    QList<SettingParam_t> paramList;
+    CProjectManager projMan(file, paramList, false);
+
+    for (const SettingParam_t& param : paramList)
+        m_params.insert(param.m_name, param.m_value);
+
+    QStringList required;
+    switch (m_measure)
+    {
+        case EMeasures_t::eEIS:
+            required << "amplitude" << "freqStart" << "freqStep" << "freqStop" << "stepType";
+            break;
+
+        case EMeasures_t::eCV:
+            required << "potStart" << "potEnd" << "nrOfCycles" << "potStep" << "scanSpeed";
+            break;
+
+        case EMeasures_t::eCA:
+            required << "potential" << "measTime" << "dt";
+            break;
+
+        case EMeasures_t::eDPV:
+            required << "qp" << "qt" << "pn" << "pa" << "pp" << "pw" << "ps";
+            break;
+
+        case EMeasures_t::eSWV:
+            required << "startPot" << "endPot" << "step" << "amplitude"
+                     << "frequency" << "quietTime";
+            break;
+
+        default:
+            qCritical() << "Headless: measure type" << (int)m_measure << "of"
+                        << m_projectFile << "cannot run headless";
+            return -1;
+    }
+
+    for (const QString& name : required)
+    {
+        if (!m_params.contains(name))
+        {
+            qCritical() << "Headless:" << m_projectFile << "is missing" << name;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int CHeadlessRunner::start()
+{
+    if (loadProject())
+        return (int)EExitCode_t::eError;
+
+    m_output.setFileName(m_outputFile);
+    if (!m_output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCritical() << "Headless: cannot open" << m_outputFile << m_output.errorString();
+        return (int)EExitCode_t::eError;
+    }
+
+    m_stream.setDevice(&m_output);
+    m_stream.setByteOrder(QDataStream::LittleEndian);
+    m_stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    m_stream.writeRawData("IMS1", 4);
+    m_stream << (quint8)m_measure << (quint8)3 << (quint16)0;
+
+    QString settingsFile = QCoreApplication::applicationDirPath() + "/settings.xms";
+    CSettingsManager::instance()->setFilePath(settingsFile);
+    if (m_port.isEmpty())
+        m_port = CSettingsManager::instance()->paramValue(XML_FIELD_PORT);
+
+    mp_serialThread = new CSerialThread(m_port);
+    mp_serialThread->updateSerialBackend((CSerialThread::ESerialBackend_t)
+            CSettingsManager::instance()->paramValue(XML_FIELD_BACKEND).toInt());
+    mp_serialThread->updateCrcMode((CSerialThread::ECrcMode_t)
+            CSettingsManager::instance()->paramValue(XML_FIELD_CRC).toInt());
+    mp_serialThread->updateCaptureFile(CSettingsManager::instance()->paramValue(XML_FIELD_CAPTURE));
+    mp_serialThread->updateReplay(CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY),
+            CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY_FAST).toInt());
+    mp_serialThread->moveToThread(mp_serialThread);
+
+    connect(this, SIGNAL(closeSerialThread()),
+            mp_serialThread, SLOT(on_closePort()));
+    connect(mp_serialThread, SIGNAL(openPort(const int&)),
+            this, SLOT(on_openPort(const int&)), Qt::UniqueConnection);
+    connect(this, SIGNAL(send_getFirmwareID()),
+            mp_serialThread, SLOT(on_send_getFirmwareID()), Qt::UniqueConnection);
+    connect(mp_serialThread, SIGNAL(received_getFirmwareID(const MeasureUtility::union32_t&)),
+            this, SLOT(on_received_getFirmwareID(const MeasureUtility::union32_t&)),
+            Qt::UniqueConnection);
+    connect(mp_serialThread, SIGNAL(rxTimeout(const int&)),
+            this, SLOT(on_rxTimeout(const int&)), Qt::UniqueConnection);
+    connect(mp_serialThread, SIGNAL(portLost()),
+            this, SLOT(on_portLost()), Qt::UniqueConnection);
+    connect(this, SIGNAL(setSampleSink(const QSharedPointer<CSampleQueue>&)),
+            mp_serialThread, SLOT(on_setSampleSink(const QSharedPointer<CSampleQueue>&)),
+            Qt::UniqueConnection);
+    connectMeasure();
+
+    // status lines and the summary are the output of the command, not debug
+    // output, which release builds do not print
+    QTextStream(stdout) << "Headless: running " << m_projectFile << " on " << m_port
+                        << " into " << m_outputFile << endl;
+
+    if (m_timeout_s > 0)
+        m_deadlineTimer.start(m_timeout_s * 1000);
+
+    mp_serialThread->start();
+    return (int)EExitCode_t::eSuccess;
+}
+
+void CHeadlessRunner::connectMeasure()
+{
+    switch (m_measure)
+    {
+        case EMeasures_t::eEIS:
+        {
+            connect(this, SIGNAL(send_takeMeasEis(const quint8&, const union32_t&, const union32_t&,
+                                                  const qint16&, const quint8&)),
+            mp_serialThread, SLOT(on_send_takeMeasEis(const quint8&, const union32_t&, const union32_t&,
+                                                      const qint16&, const quint8&)),
+                    Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_takeMeasEis(const bool&)),
+                    this, SLOT(on_received_takeMeas(const bool&)), Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_endMeasEis()),
+                    this, SLOT(on_received_endMeas()), Qt::UniqueConnection);
+            break;
+        }
+
+        case EMeasures_t::eCV:
+        {
+            connect(this, SIGNAL(send_takeMeasCv(const qint16&, const qint16&, const quint8&,
+                                                 const qint16&, const qint16&)),
+            mp_serialThread, SLOT(on_send_takeMeasCv(const qint16&, const qint16&, const quint8&,
+                                                     const qint16&, const qint16&)),
+                    Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_takeMeasCv(const bool&)),
+                    this, SLOT(on_received_takeMeas(const bool&)), Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_endMeasCv()),
+                    this, SLOT(on_received_endMeas()), Qt::UniqueConnection);
+            break;
+        }
+
+        case EMeasures_t::eCA:
+        {
+            connect(this, SIGNAL(send_takeMeasCa(const qint16&, const quint16&, const union32_t&)),
+            mp_serialThread, SLOT(on_send_takeMeasCa(const qint16&, const quint16&, const union32_t&)),
+                    Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_takeMeasCa(const bool&)),
+                    this, SLOT(on_received_takeMeas(const bool&)), Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_endMeasCa()),
+                    this, SLOT(on_received_endMeas()), Qt::UniqueConnection);
+            break;
+        }
+
+        case EMeasures_t::eDPV:
+        {
+            connect(this, SIGNAL(send_takeMeasDpv(const qint16&, const quint16&, const quint32&,
+                                                  const quint16&, const quint16&, const quint16&,
+                                                  const qint16&)),
+            mp_serialThread, SLOT(on_send_takeMeasDpv(const qint16&, const quint16&, const quint32&,
+                                                      const quint16&, const quint16&, const quint16&,
+                                                      const qint16&)), Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_takeMeasDpv(const bool&)),
+                    this, SLOT(on_received_takeMeas(const bool&)), Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_endMeasDpv()),
+                    this, SLOT(on_received_endMeas()), Qt::UniqueConnection);
+            break;
+        }
+
+        case EMeasures_t::eSWV:
+        {
+            connect(this, SIGNAL(send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                                                  const quint16&, const quint16&, const quint16&)),
+            mp_serialThread, SLOT(on_send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                                                      const quint16&, const quint16&, const quint16&)),
+                    Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_takeMeasSwv(const bool&)),
+                    this, SLOT(on_received_takeMeas(const bool&)), Qt::UniqueConnection);
+            connect(mp_serialThread, SIGNAL(received_endMeasSwv()),
+                    this, SLOT(on_received_endMeas()), Qt::UniqueConnection);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void CHeadlessRunner::on_openPort(const int& val)
+{
+    if (val)
+    {
+        qCritical() << "Headless: cannot open port" << m_port;
+        finish(EExitCode_t::eError);
+        return;
+    }
+
+    emit send_getFirmwareID();
+}
+
+void CHeadlessRunner::on_received_getFirmwareID(const MeasureUtility::union32_t& id)
+{
+    QTextStream(stdout) << "Headless: firmware " << (int)id.id8[3] << "." << (int)id.id8[2] << "."
+                        << (int)id.id8[1] << "." << (int)id.id8[0] << endl;
+
+    // the sink is in place before the request, no chunk takes the signal path
+    m_sampleQueue = QSharedPointer<CSampleQueue>(new CSampleQueue(m_queueCapacity));
+    emit setSampleSink(m_sampleQueue);
+    m_drainTimer.start();
+
+    // the raw values of the project fields, as the projects send them, after
+    // the checks of the project tabs; a hand edited file is not sent as is
+    QString badParameters;
+
+    if (EMeasures_t::eEIS == m_measure)
+    {
+        quint8 amplitude = (quint8)m_params["amplitude"].toInt();
+        union32_t freqStart;
+        union32_t freqEnd;
+        freqStart.idFl = (float)m_params["freqStart"].toDouble();
+        freqEnd.idFl = (float)m_params["freqStop"].toDouble();
+        qint16 freqStep = (qint16)m_params["freqStep"].toInt();
+
+        badParameters = CMeasureLimits::checkEis(amplitude, freqStart, freqEnd, freqStep);
+        if (badParameters.isEmpty())
+            emit send_takeMeasEis(amplitude, freqStart, freqEnd, freqStep,
+                                  (quint8)m_params["stepType"].toInt());
+    }
+    else if (EMeasures_t::eCV == m_measure)
+    {
+        qint16 potStart = (qint16)m_params["potStart"].toInt();
+        qint16 potEnd = (qint16)m_params["potEnd"].toInt();
+        quint8 nrOfCycles = (quint8)m_params["nrOfCycles"].toInt();
+        qint16 potStep = (qint16)m_params["potStep"].toInt();
+        qint16 scanSpeed = (qint16)m_params["scanSpeed"].toInt();
+
+        badParameters = CMeasureLimits::checkCv(potStart, potEnd, nrOfCycles, potStep, scanSpeed);
+        if (badParameters.isEmpty())
+            emit send_takeMeasCv(potStart, potEnd, nrOfCycles, potStep, scanSpeed);
+    }
+    else if (EMeasures_t::eCA == m_measure)
+    {
+        quint16 measTime = (quint16)m_params["measTime"].toInt();
+        union32_t dt;
+        dt.idFl = (float)m_params["dt"].toDouble();
+
+        badParameters = CMeasureLimits::checkCa(measTime, dt);
+        if (badParameters.isEmpty())
+            emit send_takeMeasCa((qint16)m_params["potential"].toInt(), measTime, dt);
+    }
+    else if (EMeasures_t::eDPV == m_measure)
+    {
+        quint16 qt = (quint16)m_params["qt"].toInt();
+        quint32 pn = (quint32)m_params["pn"].toInt();
+        quint16 pa = (quint16)m_params["pa"].toInt();
+        qint16 ps = (qint16)m_params["ps"].toInt();
+
+        badParameters = CMeasureLimits::checkDpv(qt, pn, pa, ps);
+        if (badParameters.isEmpty())
+            emit send_takeMeasDpv((qint16)m_params["qp"].toInt(), qt, pn, pa,
+                                  (quint16)m_params["pp"].toInt(),
+                                  (quint16)m_params["pw"].toInt(), ps);
+    }
+    else if (EMeasures_t::eSWV == m_measure)
+    {
+        qint16 startPot = (qint16)m_params["startPot"].toInt();
+        qint16 endPot = (qint16)m_params["endPot"].toInt();
+        quint16 step = (quint16)m_params["step"].toInt();
+        quint16 amplitude = (quint16)m_params["amplitude"].toInt();
+        quint16 frequency = (quint16)m_params["frequency"].toInt();
+
+        badParameters = CMeasureLimits::checkSwv(startPot, endPot, step, amplitude, frequency);
+        if (badParameters.isEmpty())
+            emit send_takeMeasSwv(startPot, endPot, step, amplitude, frequency,
+                                  (quint16)m_params["quietTime"].toInt());
+    }
+
+    if (!badParameters.isEmpty())
+    {
+        qCritical() << "Headless: bad parameters in" << m_projectFile << ":"
+                    << badParameters.split('\n', QString::SkipEmptyParts).join(", ");
+        finish(EExitCode_t::eError);
+    }
+}
+
+void CHeadlessRunner::on_received_takeMeas(const bool& ack)
+{
+    if (ack)
+    {
+        qCritical() << "Headless: measure request rejected by the device";
+        finish(EExitCode_t::eError);
+        return;
+    }
+
+    QTextStream(stdout) << "Headless: measure started" << endl;
+}
+
+void CHeadlessRunner::on_received_endMeas()
+{
+    // the end frame comes after the last chunk, everything is queued by now
+    on_drain();
+
+    quint32 badCrc = mp_serialThread->badCrcCount();
+    quint64 frames = m_samples + badCrc;
+    double rate = frames ? (double)badCrc / frames : 0;
+
+    QTextStream(stdout) << "Headless: measure finished, " << m_samples << " samples, " << badCrc
+                        << " frames dropped on bad CRC" << endl;
+
+    if (rate > m_maxCrcRate)
+    {
+        qCritical() << "Headless: bad CRC rate" << rate << "over" << m_maxCrcRate;
+        finish(EExitCode_t::eCrcRate);
+        return;
+    }
+
+    finish(EExitCode_t::eSuccess);
+}
+
+void CHeadlessRunner::on_rxTimeout(const int& command)
+{
+    qCritical() << "Headless: command" << command << "without answer";
+    finish(EExitCode_t::eTimeout);
+}
+
+void CHeadlessRunner::on_portLost()
+{
+    qCritical() << "Headless: port" << m_port << "hung up";
+    finish(EExitCode_t::eError);
+}
+
+void CHeadlessRunner::on_deadline()
+{
+    qCritical() << "Headless: measure not finished within" << m_timeout_s << "s";
+    finish(EExitCode_t::eTimeout);
+}
+
+void CHeadlessRunner::on_drain()
+{
+    if (!m_sampleQueue)
+        return;
+
+    MeasSample_t samples[m_drainBatch];
+    int count = 0;
+
+    do
+    {
+        count = m_sampleQueue->pop(samples, m_drainBatch);
+
+        for (int i = 0; i < count; i++)
+        {
+            m_stream << samples[i].m_index << samples[i].m_data[0]
+                     << samples[i].m_data[1] << samples[i].m_data[2];
+        }
+
+        m_samples += count;
+    }
+    while (count == m_drainBatch);
+}
+
+void CHeadlessRunner::finish(const EExitCode_t& code)
+{
+    if (m_finished)
+        return;
+
+    m_finished = true;
+    m_drainTimer.stop();
+    m_deadlineTimer.stop();
+
+    if (m_sampleQueue)
+    {
+        if (m_sampleQueue->droppedSamples())
+            qWarning() << "Headless: sample queue overflow," << m_sampleQueue->droppedSamples()
+                       << "samples dropped";
+        m_sampleQueue.clear();
+    }
+
+    if (m_output.isOpen())
+    {
+        m_output.flush();
+        m_output.close();
+    }
+
+    // on_closePort ends the serial thread's loop
+    if (mp_serialThread && mp_serialThread->isRunning())
+    {
+        emit closeSerialThread();
+        mp_serialThread->wait();
+    }
+
+    emit finished((int)code);
+}
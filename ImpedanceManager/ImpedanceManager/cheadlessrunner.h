@@ -0,0 +1,107 @@
+#ifndef CHEADLESSRUNNER_H
+#define CHEADLESSRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QDataStream>
+#include <QTimer>
+#include <QHash>
+#include <QSharedPointer>
+
+#include "MeasureUtility.h"
+#include "cserialthread.h"
+#include "csamplequeue.h"
+
+using namespace MeasureUtility;
+
+// Unattended measure without any widget (--headless). The project file gives
+// the measure type and its parameters, the port comes from the settings. The
+// samples of the serial thread go through the sample queue straight into a
+// binary file:
+//
+//  header  "IMS1", quint8 measType, quint8 values per sample (3), quint16 0
+//  sample  quint32 index, 3 x float32
+//
+// little endian. The process exit code is one of EExitCode_t.
+class CHeadlessRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class EExitCode_t
+    {
+          eSuccess                  = 0
+        , eError                    = 1 // project, output file, port or measure request
+        , eTimeout                  = 2 // device stopped answering or the run took too long
+        , eCrcRate                  = 3 // finished, but too many frames failed the check
+    };
+
+    CHeadlessRunner(const QString& projectFile, const QString& outputFile,
+                    QObject* parent = 0);
+    ~CHeadlessRunner();
+
+    void setPort(const QString& port) { m_port = port; }
+    void setTimeout(const int& timeout_s) { m_timeout_s = timeout_s; }
+    void setMaxCrcRate(const double& rate) { m_maxCrcRate = rate; }
+
+    // loads the project and opens the port, the result comes with finished()
+    int start();
+
+signals:
+    void finished(const int& exitCode);
+
+    void closeSerialThread();
+    void setSampleSink(const QSharedPointer<CSampleQueue>&);
+    void send_getFirmwareID();
+    void send_takeMeasEis(const quint8&, const union32_t&, const union32_t&,
+                          const qint16&, const quint8&);
+    void send_takeMeasCv(const qint16&, const qint16&, const quint8&,
+                         const qint16&, const qint16&);
+    void send_takeMeasCa(const qint16&, const quint16&, const union32_t&);
+    void send_takeMeasDpv(const qint16&, const quint16&, const quint32&,
+                          const quint16&, const quint16&, const quint16&,
+                          const qint16&);
+    void send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                          const quint16&, const quint16&, const quint16&);
+
+private slots:
+    void on_openPort(const int& val);
+    void on_received_getFirmwareID(const MeasureUtility::union32_t& id);
+    void on_received_takeMeas(const bool& ack);
+    void on_received_endMeas();
+    void on_rxTimeout(const int& command);
+    void on_portLost();
+    void on_deadline();
+    void on_drain();
+
+private:
+    int loadProject();
+    void connectMeasure();
+    void finish(const EExitCode_t& code);
+
+    QString m_projectFile;
+    QString m_outputFile;
+    QString m_port;
+    int m_timeout_s;
+    double m_maxCrcRate;
+
+    EMeasures_t m_measure;
+    QHash<QString, QString> m_params;
+
+    CSerialThread* mp_serialThread;
+    QSharedPointer<CSampleQueue> m_sampleQueue;
+    QFile m_output;
+    QDataStream m_stream;
+    QTimer m_drainTimer;
+    QTimer m_deadlineTimer;
+    quint64 m_samples;
+    bool m_finished;
+
+    static const int m_drainInterval_ms = 50;
+    static const int m_drainBatch = 1024;
+    static const int m_queueCapacity = 65536; // no replot to wait for, but disk may stall
+};
+
+#endif // CHEADLESSRUNNER_H
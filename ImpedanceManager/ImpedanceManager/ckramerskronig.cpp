@@ -0,0 +1,208 @@
+#include "ckramerskronig.h"
+#include "clinalg.h"
+
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+void CKramersKronig::design(const QVector<double>& omega, const QVector<double>& weight,
+                            const int& elements, QVector<double>& a)
+{
+    const int n = omega.size();
+    const int rows = 2 * n;
+    const int cols = elements + 2;
+
+    double omegaMin = omega[0], omegaMax = omega[0];
+    for (double w : omega)
+    {
+        omegaMin = qMin(omegaMin, w);
+        omegaMax = qMax(omegaMax, w);
+    }
+
+    double tauMin = 1.0 / omegaMax;
+    double tauMax = 1.0 / omegaMin;
+
+    // column major, real rows first, then imaginary rows, all weighted
+    a.fill(0, rows * cols);
+    double* col = a.data();
+
+    // R0
+    for (int i = 0; i < n; i++)
+        col[i] = weight[i];
+    col += rows;
+
+    // L
+    for (int i = 0; i < n; i++)
+        col[n + i] = omega[i] * weight[i];
+    col += rows;
+
+    for (int k = 0; k < elements; k++, col += rows)
+    {
+        double tau = (elements > 1) ?
+                    tauMin * std::pow(tauMax / tauMin, (double)k / (elements - 1)) :
+                    std::sqrt(tauMin * tauMax);
+
+        // R / (1 + j w tau)
+        for (int i = 0; i < n; i++)
+        {
+            double wt = omega[i] * tau;
+            double denominator = 1.0 / (1.0 + wt * wt);
+
+            col[i] = denominator * weight[i];
+            col[n + i] = -wt * denominator * weight[i];
+        }
+    }
+}
+
+bool CKramersKronig::solve(const QVector<double>& omega, const QVector<double>& re,
+                           const QVector<double>& im, const int& elements,
+                           QVector<double>& coefficients, double& mu)
+{
+    const int n = omega.size();
+    const int rows = 2 * n;
+    const int cols = elements + 2;
+
+    QVector<double> weight(n), a, b(rows), g(cols * cols);
+
+    for (int i = 0; i < n; i++)
+    {
+        weight[i] = CLinAlg::modulusWeight(re[i], im[i]);
+        b[i] = re[i] * weight[i];
+        b[n + i] = im[i] * weight[i];
+    }
+
+    design(omega, weight, elements, a);
+
+    CLinAlg::gram(a.constData(), rows, cols, g.data());
+    coefficients.resize(cols);
+    CLinAlg::transposeTimes(a.constData(), rows, cols, b.constData(), coefficients.data());
+
+    // columns differ by orders of magnitude (L goes with omega), scale them
+    // to unit norm first; neighbouring time constants are nearly collinear,
+    // a tiny ridge keeps the factorization alive
+    QVector<double> scale(cols);
+    for (int c = 0; c < cols; c++)
+        scale[c] = 1.0 / std::sqrt(qMax(g[c * cols + c], 1e-300));
+
+    for (int r = 0; r < cols; r++)
+    {
+        for (int c = 0; c < cols; c++)
+            g[r * cols + c] *= scale[r] * scale[c];
+
+        g[r * cols + r] += m_ridge;
+        coefficients[r] *= scale[r];
+    }
+
+    if (!CLinAlg::cholesky(g.data(), cols))
+        return false;
+
+    CLinAlg::choleskySolve(g.constData(), cols, coefficients.data());
+
+    for (int c = 0; c < cols; c++)
+        coefficients[c] *= scale[c];
+
+    double positive = 0, negative = 0;
+    for (int k = 2; k < cols; k++)
+    {
+        if (coefficients[k] >= 0)
+            positive += coefficients[k];
+        else
+            negative -= coefficients[k];
+    }
+
+    mu = (positive > 0) ? (1.0 - negative / positive) : 0;
+    return true;
+}
+
+CKramersKronig::Result_t CKramersKronig::validate(const QVector<double>& freq,
+                                                  const QVector<double>& re,
+                                                  const QVector<double>& im,
+                                                  const int elements)
+{
+    Result_t result;
+    result.m_elements = 0;
+    result.m_mu = 0;
+    result.m_chiSquare = 0;
+    result.m_maxResidual = 0;
+    result.m_valid = false;
+
+    const int n = freq.size();
+    if ((n < 3) || (re.size() != n) || (im.size() != n))
+        return result;
+
+    QVector<double> omega(n);
+    for (int i = 0; i < n; i++)
+        omega[i] = 2 * M_PI * qMax(freq[i], 1e-9);
+
+    QVector<double> coefficients;
+    double mu = 0;
+    int count = elements;
+
+    if (count <= 0)
+    {
+        // mu drops with M, bisect for the first M below the threshold; a too
+        // sparse grid cannot follow a single arc, hence the lower bound
+        double omegaMin = omega[0], omegaMax = omega[0];
+        for (double w : omega)
+        {
+            omegaMin = qMin(omegaMin, w);
+            omegaMax = qMax(omegaMax, w);
+        }
+
+        int high = qMax(n - 2, 1);
+        int low = qBound(1, (int)std::ceil(m_elementsPerDecade * std::log10(omegaMax / omegaMin)), high);
+
+        while (low < high)
+        {
+            int middle = (low + high) / 2;
+
+            if (!solve(omega, re, im, middle, coefficients, mu) || (mu < m_muThreshold))
+                high = middle;
+            else
+                low = middle + 1;
+        }
+
+        count = low;
+    }
+
+    if (!solve(omega, re, im, count, coefficients, mu))
+    {
+        qWarning() << "Lin-KK: cannot solve for" << count << "elements";
+        return result;
+    }
+
+    // residuals of the fit, relative to |Z|
+    QVector<double> weight(n), a;
+    for (int i = 0; i < n; i++)
+        weight[i] = CLinAlg::modulusWeight(re[i], im[i]);
+
+    design(omega, weight, count, a);
+
+    const int rows = 2 * n;
+    QVector<double> fit(rows, 0.0);
+    for (int c = 0; c < count + 2; c++)
+    {
+        const double* col = a.constData() + c * rows;
+        for (int r = 0; r < rows; r++)
+            fit[r] += col[r] * coefficients[c];
+    }
+
+    result.m_residualRe.resize(n);
+    result.m_residualIm.resize(n);
+
+    for (int i = 0; i < n; i++)
+    {
+        double dRe = re[i] * weight[i] - fit[i];
+        double dIm = im[i] * weight[i] - fit[n + i];
+
+        result.m_residualRe[i] = 100 * dRe;
+        result.m_residualIm[i] = 100 * dIm;
+        result.m_chiSquare += dRe * dRe + dIm * dIm;
+        result.m_maxResidual = qMax(result.m_maxResidual, 100 * qMax(qAbs(dRe), qAbs(dIm)));
+    }
+
+    result.m_elements = count;
+    result.m_mu = mu;
+    result.m_valid = true;
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef CKRAMERSKRONIG_H
+#define CKRAMERSKRONIG_H
+
+#include <QVector>
+
+// Lin-KK validity test (Schoenleber et al.). The spectrum is fitted with
+// R0, L and M series RC elements with fixed, log spaced time constants, a
+// linear least squares problem. Such a circuit satisfies Kramers-Kronig, so
+// large residuals mark points that do not (drift, non-linearity, noise).
+// M is chosen automatically: the smallest M for which the negative resistances
+// start to take over (mu below m_muThreshold), with at least
+// m_elementsPerDecade time constants per decade of the sweep.
+class CKramersKronig
+{
+public:
+    typedef struct
+    {
+        QVector<double> m_residualRe;   // (Re - Re fit) / |Z| [%]
+        QVector<double> m_residualIm;   // (Im - Im fit) / |Z| [%]
+        int m_elements;
+        double m_mu;
+        double m_chiSquare;
+        double m_maxResidual;           // [%]
+        bool m_valid;
+    } Result_t;
+
+    // freq in Hz, im negative for capacitive behaviour, elements 0 for automatic
+    static Result_t validate(const QVector<double>& freq,
+                             const QVector<double>& re,
+                             const QVector<double>& im,
+                             const int elements = 0);
+
+    static constexpr double m_muThreshold = 0.85;
+    static constexpr double m_ridge = 1e-13;   // relative to unit column norms
+    static constexpr double m_elementsPerDecade = 4;
+
+private:
+    static bool solve(const QVector<double>& omega, const QVector<double>& re,
+                      const QVector<double>& im, const int& elements,
+                      QVector<double>& coefficients, double& mu);
+    static void design(const QVector<double>& omega, const QVector<double>& weight,
+                       const int& elements, QVector<double>& a);
+};
+
+#endif // CKRAMERSKRONIG_H
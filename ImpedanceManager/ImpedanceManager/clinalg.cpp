@@ -0,0 +1,271 @@
+#include "clinalg.h"
+
+#include <QVector>
+#include <cmath>
+
+const int CLinAlg::m_tileRows;
+const int CLinAlg::m_tileCols;
+
+double CLinAlg::dot(const double* a, const double* b, const int& n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+
+    for (; i + 3 < n; i += 4)
+    {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+
+    for (; i < n; i++)
+        s0 += a[i] * b[i];
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+void CLinAlg::gram(const double* a, const int& rows, const int& cols, double* g)
+{
+    for (int i = 0; i < cols * cols; i++)
+        g[i] = 0;
+
+    // Blocked over rows and columns: a tile of m_tileCols columns times
+    // m_tileRows rows stays in L1 while all column pairs of two tiles are
+    // summed up, instead of streaming whole columns once per pair.
+    for (int r0 = 0; r0 < rows; r0 += m_tileRows)
+    {
+        int length = qMin(m_tileRows, rows - r0);
+
+        for (int c0 = 0; c0 < cols; c0 += m_tileCols)
+        {
+            int cEnd = qMin(c0 + m_tileCols, cols);
+
+            for (int k0 = 0; k0 <= c0; k0 += m_tileCols)
+            {
+                int kEnd = qMin(k0 + m_tileCols, cols);
+
+                for (int c = c0; c < cEnd; c++)
+                {
+                    const double* colC = a + (qint64)c * rows + r0;
+
+                    for (int k = k0; (k < kEnd) && (k <= c); k++)
+                        g[c * cols + k] += dot(a + (qint64)k * rows + r0, colC, length);
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < cols; c++)
+    {
+        for (int k = 0; k < c; k++)
+            g[k * cols + c] = g[c * cols + k];
+    }
+}
+
+void CLinAlg::transposeTimes(const double* a, const int& rows, const int& cols,
+                             const double* x, double* y)
+{
+    for (int c = 0; c < cols; c++)
+        y[c] = dot(a + (qint64)c * rows, x, rows);
+}
+
+bool CLinAlg::cholesky(double* g, const int& n)
+{
+    // row major lower triangle, g[r * n + c] with c <= r
+    for (int r = 0; r < n; r++)
+    {
+        for (int c = 0; c <= r; c++)
+        {
+            double sum = g[r * n + c] - dot(g + r * n, g + c * n, c);
+
+            if (r == c)
+            {
+                if (sum <= 0)
+                    return false;
+                g[r * n + r] = std::sqrt(sum);
+            }
+            else
+                g[r * n + c] = sum / g[c * n + c];
+        }
+    }
+
+    return true;
+}
+
+void CLinAlg::choleskySolve(const double* l, const int& n, double* b)
+{
+    // L y = b
+    for (int r = 0; r < n; r++)
+        b[r] = (b[r] - dot(l + r * n, b, r)) / l[r * n + r];
+
+    // L^T x = y
+    for (int r = n - 1; r >= 0; r--)
+    {
+        double sum = b[r];
+        for (int k = r + 1; k < n; k++)
+            sum -= l[k * n + r] * b[k];
+        b[r] = sum / l[r * n + r];
+    }
+}
+
+bool CLinAlg::bandCholesky(double* band, const int& n, const int& width)
+{
+    const int stride = width + 1;
+
+    for (int r = 0; r < n; r++)
+    {
+        for (int k = qMin(width, r); k >= 0; k--)
+        {
+            int c = r - k;
+            double sum = band[r * stride + k];
+
+            // L(r, j) L(c, j) over the columns both rows reach
+            for (int j = qMax(0, r - width); j < c; j++)
+                sum -= band[r * stride + (r - j)] * band[c * stride + (c - j)];
+
+            if (!k)
+            {
+                if (sum <= 0)
+                    return false;
+                band[r * stride] = std::sqrt(sum);
+            }
+            else
+                band[r * stride + k] = sum / band[c * stride];
+        }
+    }
+
+    return true;
+}
+
+void CLinAlg::bandCholeskySolve(const double* band, const int& n, const int& width,
+                                double* b)
+{
+    const int stride = width + 1;
+
+    // L y = b
+    for (int r = 0; r < n; r++)
+    {
+        double sum = b[r];
+        for (int k = 1; (k <= width) && (k <= r); k++)
+            sum -= band[r * stride + k] * b[r - k];
+        b[r] = sum / band[r * stride];
+    }
+
+    // L^T x = y
+    for (int r = n - 1; r >= 0; r--)
+    {
+        double sum = b[r];
+        for (int k = 1; (k <= width) && (r + k < n); k++)
+            sum -= band[(r + k) * stride + k] * b[r + k];
+        b[r] = sum / band[r * stride];
+    }
+}
+
+int CLinAlg::nonNegativeSolve(const double* h, const double* f, const int& n, double* x)
+{
+    QVector<int> passive;               // indices free to move, the rest is 0
+    QVector<bool> isPassive(n, false);
+    QVector<bool> excluded(n, false);   // linearly dependent on the passive set
+    QVector<double> z(n), sub, rhs;
+    int iterations = 0;
+    const int maxIterations = 3 * n + 10;
+
+    for (int i = 0; i < n; i++)
+        x[i] = 0;
+
+    forever
+    {
+        // gradient of the active (zero) variables, the best one joins
+        int best = -1;
+        double bestGradient = 1e-12;
+
+        for (int i = 0; i < n; i++)
+        {
+            if (isPassive[i] || excluded[i])
+                continue;
+
+            double gradient = f[i] - dot(h + i * n, x, n);
+            if (gradient > bestGradient)
+            {
+                bestGradient = gradient;
+                best = i;
+            }
+        }
+
+        if ((best < 0) || (iterations >= maxIterations))
+            break;
+
+        passive.append(best);
+        isPassive[best] = true;
+
+        // inner loop: solve on the passive set, step back while it leaves
+        // the feasible region
+        forever
+        {
+            iterations++;
+            const int p = passive.size();
+            sub.resize(p * p);
+            rhs.resize(p);
+
+            for (int r = 0; r < p; r++)
+            {
+                for (int c = 0; c < p; c++)
+                    sub[r * p + c] = h[passive[r] * n + passive[c]];
+                rhs[r] = f[passive[r]];
+            }
+
+            if (!cholesky(sub.data(), p))
+            {
+                // dependent column, give it up
+                excluded[passive.last()] = true;
+                isPassive[passive.last()] = false;
+                passive.removeLast();
+                break;
+            }
+
+            choleskySolve(sub.constData(), p, rhs.data());
+
+            bool feasible = true;
+            for (int r = 0; r < p; r++)
+            {
+                z[passive[r]] = rhs[r];
+                if (rhs[r] <= 0)
+                    feasible = false;
+            }
+
+            if (feasible)
+            {
+                for (int r = 0; r < p; r++)
+                    x[passive[r]] = z[passive[r]];
+                break;
+            }
+
+            double alpha = 1;
+            for (int r = 0; r < p; r++)
+            {
+                int i = passive[r];
+                if (z[i] <= 0)
+                    alpha = qMin(alpha, x[i] / (x[i] - z[i]));
+            }
+
+            for (int r = p - 1; r >= 0; r--)
+            {
+                int i = passive[r];
+                x[i] += alpha * (z[i] - x[i]);
+
+                if (x[i] <= 1e-15)
+                {
+                    x[i] = 0;
+                    isPassive[i] = false;
+                    passive.remove(r);
+                }
+            }
+
+            if (passive.isEmpty() || (iterations >= maxIterations))
+                break;
+        }
+    }
+
+    return iterations;
+}
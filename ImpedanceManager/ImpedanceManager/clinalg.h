@@ -0,0 +1,46 @@
+#ifndef CLINALG_H
+#define CLINALG_H
+
+#include <QtGlobal>
+#include <cmath>
+
+// Small dense kernels for the linear least squares of the EIS analyses.
+// Matrices are column major with contiguous columns, so the inner loops run
+// over plain double arrays and vectorize (four independent accumulators).
+class CLinAlg
+{
+public:
+    static double dot(const double* a, const double* b, const int& n);
+
+    // g = A^T A (cols x cols, symmetric, both triangles filled)
+    static void gram(const double* a, const int& rows, const int& cols, double* g);
+
+    // y = A^T x
+    static void transposeTimes(const double* a, const int& rows, const int& cols,
+                               const double* x, double* y);
+
+    // g = L L^T in place (lower triangle), false when not positive definite
+    static bool cholesky(double* g, const int& n);
+    static void choleskySolve(const double* l, const int& n, double* b);
+
+    // banded symmetric positive definite matrix, row major lower band:
+    // band[r * (width + 1) + k] = A(r, r - k), k = 0 .. width. O(n width^2)
+    static bool bandCholesky(double* band, const int& n, const int& width);
+    static void bandCholeskySolve(const double* band, const int& n, const int& width,
+                                  double* b);
+
+    // min 1/2 x^T H x - f^T x subject to x >= 0 (Lawson-Hanson active set),
+    // h is n x n symmetric positive definite
+    static int nonNegativeSolve(const double* h, const double* f, const int& n, double* x);
+
+    // 1 / |Z| of a measured point, the row weight of the EIS fits, so every
+    // point counts relative to its own magnitude
+    static double modulusWeight(const double& re, const double& im)
+    { return 1.0 / qMax(std::hypot(re, im), 1e-12); }
+
+private:
+    static const int m_tileRows = 256;  // 2 kB of a column
+    static const int m_tileCols = 16;   // 16 columns of a tile, 32 kB
+};
+
+#endif // CLINALG_H
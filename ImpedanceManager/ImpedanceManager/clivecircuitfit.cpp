@@ -0,0 +1,177 @@
+#include "clivecircuitfit.h"
+
+#include <cmath>
+
+const int CLiveCircuitFit::m_stepsPerPoint;
+
+CLiveCircuitFit::CLiveCircuitFit(QObject *parent) :
+    QThread(parent)
+{
+    m_lambda = 1e-3;
+}
+
+CLiveCircuitFit::~CLiveCircuitFit()
+{
+
+}
+
+void CLiveCircuitFit::run()
+{
+    exec();
+}
+
+void CLiveCircuitFit::restart(const QString& circuit)
+{
+    m_pendingMutex.lock();
+    m_pendingCircuit = circuit;
+    m_pendingMutex.unlock();
+
+    post(QVector<double>());
+}
+
+void CLiveCircuitFit::postPoint(const double& omega, const double& re, const double& im)
+{
+    QVector<double> point(3);
+    point[0] = omega;
+    point[1] = re;
+    point[2] = im;
+
+    post(point);
+}
+
+void CLiveCircuitFit::post(const QVector<double>& point)
+{
+    bool wasEmpty;
+
+    m_pendingMutex.lock();
+    wasEmpty = m_pendingPoints.isEmpty();
+    m_pendingPoints.enqueue(point);
+    m_pendingMutex.unlock();
+
+    // one wakeup per batch, points arriving meanwhile are taken with it
+    if (wasEmpty)
+        QMetaObject::invokeMethod(this, "on_pointsReady", Qt::QueuedConnection);
+}
+
+void CLiveCircuitFit::on_pointsReady()
+{
+    bool newPoints = false;
+
+    forever
+    {
+        m_pendingMutex.lock();
+        if (m_pendingPoints.isEmpty())
+        {
+            m_pendingMutex.unlock();
+            break;
+        }
+
+        QVector<double> point = m_pendingPoints.dequeue();
+        QString circuit = m_pendingCircuit;
+        m_pendingMutex.unlock();
+
+        if (point.isEmpty())
+        {
+            // same circuit keeps the last solution, the next cell starts from it
+            if ((circuit != m_model.description()) || !m_model.isValid())
+            {
+                m_model.compile(circuit);
+                m_params.clear();
+            }
+
+            m_data.m_omega.clear();
+            m_data.m_re.clear();
+            m_data.m_im.clear();
+            m_normals.m_jtr.clear();
+            m_lambda = 1e-3;
+            newPoints = false;
+            continue;
+        }
+
+        if (!m_model.isValid())
+            continue;
+
+        m_data.m_omega.append(point[0]);
+        m_data.m_re.append(point[1]);
+        m_data.m_im.append(point[2]);
+
+        // normal equations stay valid at the current parameters, only the
+        // new point has to be added
+        if (!m_params.isEmpty() && (m_normals.m_jtr.size() == m_params.size()))
+            CCircuitFitter::addPoint(m_model, m_params.constData(), point[0],
+                                     point[1], point[2], m_normals);
+
+        newPoints = true;
+    }
+
+    const int n = m_model.parameterCount();
+
+    if (!newPoints || (m_data.m_omega.size() * 2 <= n))
+        return;
+
+    if (m_params.isEmpty())
+    {
+        // first solution, from scratch
+        CCircuitFitter::FitResult_t result = CCircuitFitter::fit(
+                    m_model, m_data, m_model.initialGuess(m_data.m_omega, m_data.m_re, m_data.m_im));
+
+        m_params = result.m_params;
+        m_lambda = 1e-3;
+        rebuildNormals();
+    }
+    else
+    {
+        if (m_normals.m_jtr.size() != n)
+            rebuildNormals();
+
+        iterate(m_stepsPerPoint);
+    }
+
+    emit fitUpdated(m_params, m_normals.m_chiSquare, m_data.m_omega.size());
+}
+
+void CLiveCircuitFit::rebuildNormals()
+{
+    CCircuitFitter::clearNormals(m_normals, m_model.parameterCount());
+
+    for (int i = 0; i < m_data.m_omega.size(); i++)
+        CCircuitFitter::addPoint(m_model, m_params.constData(), m_data.m_omega[i],
+                                 m_data.m_re[i], m_data.m_im[i], m_normals);
+}
+
+bool CLiveCircuitFit::iterate(const int& steps)
+{
+    const int n = m_model.parameterCount();
+    QVector<double> step, trial(n);
+    bool moved = false;
+
+    for (int s = 0; (s < steps) && (m_lambda < 1e12); s++)
+    {
+        if (!CCircuitFitter::solveStep(m_normals, m_lambda, step))
+        {
+            m_lambda *= 10;
+            continue;
+        }
+
+        for (int k = 0; k < n; k++)
+            trial[k] = qMin(m_params[k] * std::exp(step[k]), m_model.upperBound(k));
+
+        double trialChi = CCircuitFitter::chiSquare(m_model, m_data, trial.constData());
+
+        if (trialChi < m_normals.m_chiSquare)
+        {
+            m_params = trial;
+            m_lambda = qMax(m_lambda / 10, 1e-12);
+            rebuildNormals();
+            moved = true;
+        }
+        else
+            m_lambda *= 10;
+    }
+
+    // stuck on the old data, let the next point try again with a fresh damping
+    if (m_lambda >= 1e12)
+        m_lambda = 1e-3;
+
+    return moved;
+}
@@ -0,0 +1,56 @@
+#ifndef CLIVECIRCUITFIT_H
+#define CLIVECIRCUITFIT_H
+
+#include <QThread>
+#include <QMutex>
+#include <QQueue>
+#include <QVector>
+#include <QDebug>
+
+#include "ccircuitmodel.h"
+#include "ccircuitfitter.h"
+
+// Circuit fit following a running EIS sweep. Points are posted from the GUI
+// thread, the fit runs in this thread. Every new point warm starts from the
+// previous solution: its J^T J / J^T r contribution is added to the cached
+// normal equations and a few Levenberg-Marquardt steps are tried. The cache
+// is rebuilt only when a step moves the parameters.
+class CLiveCircuitFit : public QThread
+{
+    Q_OBJECT
+public:
+    explicit CLiveCircuitFit(QObject *parent = 0);
+    ~CLiveCircuitFit();
+
+    void run(); // inherited
+
+    // both called from the GUI thread, handled in order in this thread
+    void restart(const QString& circuit);
+    void postPoint(const double& omega, const double& re, const double& im);
+
+signals:
+    void fitUpdated(const QVector<double>& params, const double& chiSquare, const int& points);
+
+private slots:
+    void on_pointsReady();
+
+private:
+    void post(const QVector<double>& point);
+    void rebuildNormals();
+    bool iterate(const int& steps);
+
+    CCircuitModel m_model;
+    CCircuitFitter::EisData_t m_data;
+    CCircuitFitter::Normals_t m_normals;    // at m_params, over all m_data
+    QVector<double> m_params;               // empty until the first fit
+    double m_lambda;
+
+    // omega, re, im; an empty entry restarts with m_pendingCircuit
+    QQueue<QVector<double> > m_pendingPoints;
+    QString m_pendingCircuit;
+    QMutex m_pendingMutex;
+
+    static const int m_stepsPerPoint = 3;
+};
+
+#endif // CLIVECIRCUITFIT_H
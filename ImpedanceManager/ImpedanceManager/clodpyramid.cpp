@@ -0,0 +1,206 @@
+#include "clodpyramid.h"
+
+CLodPyramid::CLodPyramid()
+{
+    clear();
+}
+
+void CLodPyramid::clear()
+{
+    m_samples.clear();
+    m_levels.clear();
+
+    m_total.m_keyFirst = 0;
+    m_total.m_keyLast = 0;
+    m_total.m_min = 0;
+    m_total.m_max = 0;
+    m_total.m_sum = 0;
+    m_total.m_count = 0;
+}
+
+void CLodPyramid::startBucket(Bucket_t& bucket, const double& key, const double& value)
+{
+    bucket.m_keyFirst = key;
+    bucket.m_keyLast = key;
+    bucket.m_min = value;
+    bucket.m_max = value;
+    bucket.m_sum = value;
+    bucket.m_count = 1;
+}
+
+void CLodPyramid::mergeBucket(Bucket_t& bucket, const Bucket_t& other)
+{
+    if (!bucket.m_count)
+    {
+        bucket = other;
+        return;
+    }
+
+    bucket.m_keyLast = other.m_keyLast;
+    bucket.m_min = qMin(bucket.m_min, other.m_min);
+    bucket.m_max = qMax(bucket.m_max, other.m_max);
+    bucket.m_sum += other.m_sum;
+    bucket.m_count += other.m_count;
+}
+
+void CLodPyramid::append(const double& key, const double& value)
+{
+    m_samples.append(key);
+    m_samples.append(value);
+
+    Bucket_t sample;
+    startBucket(sample, key, value);
+    mergeBucket(m_total, sample);
+
+    pushBucket(0, sample);
+}
+
+void CLodPyramid::pushBucket(const int& level, const Bucket_t& bucket)
+{
+    if (level == m_levels.size())
+    {
+        Level_t created;
+        created.m_open.m_count = 0;
+        created.m_children = 0;
+        m_levels.append(created);
+    }
+
+    Level_t& current = m_levels[level];
+    mergeBucket(current.m_open, bucket);
+
+    if (++current.m_children < m_fanout)
+        return;
+
+    Bucket_t closed = current.m_open;
+    current.m_closed.append(closed);
+    current.m_open.m_count = 0;
+    current.m_children = 0;
+
+    pushBucket(level + 1, closed);
+}
+
+int CLodPyramid::bucketCount(const int& level) const
+{
+    if (level < 0)
+        return size();
+
+    const Level_t& current = m_levels[level];
+    return current.m_closed.size() + (current.m_open.m_count ? 1 : 0);
+}
+
+const CLodPyramid::Bucket_t& CLodPyramid::bucket(const int& level, const int& index) const
+{
+    const Level_t& current = m_levels[level];
+    return (index < current.m_closed.size()) ? current.m_closed[index] : current.m_open;
+}
+
+int CLodPyramid::lowerBound(const int& level, const double& key) const
+{
+    // first bucket (sample) that ends at or after key
+    int low = 0;
+    int high = bucketCount(level);
+
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        double end = (level < 0) ? sampleKey(middle) : bucket(level, middle).m_keyLast;
+
+        if (end < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+int CLodPyramid::selectLevel(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+                             int& first, int& last) const
+{
+    int level = -1;
+
+    forever
+    {
+        int count = bucketCount(level);
+        first = lowerBound(level, keyLow);
+        last = qMin(lowerBound(level, keyHigh), count - 1);
+
+        // one bucket of margin on each side, so lines leave the view
+        first = qMax(0, first - 1);
+        last = qMin(count - 1, last + 1);
+
+        if ((last - first + 1 <= maxBuckets) || (level + 1 >= m_levels.size()))
+            return level;
+
+        level++;
+    }
+}
+
+void CLodPyramid::appendBucket(const Bucket_t& bucket, const bool& envelope,
+                               QVector<double>& keys, QVector<double>& values)
+{
+    if (envelope)
+    {
+        keys.append(bucket.m_keyFirst);
+        values.append(bucket.m_min);
+        keys.append(bucket.m_keyLast);
+        values.append(bucket.m_max);
+    }
+    else
+    {
+        keys.append(0.5 * (bucket.m_keyFirst + bucket.m_keyLast));
+        values.append(bucket.m_sum / bucket.m_count);
+    }
+}
+
+void CLodPyramid::query(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+                        const bool& envelope, QVector<double>& keys, QVector<double>& values) const
+{
+    keys.clear();
+    values.clear();
+
+    if (!size())
+        return;
+
+    // raw samples up to the point budget; an envelope bucket gives two points
+    int first, last;
+    int level = selectLevel(keyLow, keyHigh, envelope ? 2 * maxBuckets : maxBuckets, first, last);
+
+    if (level < 0)
+    {
+        for (int i = first; i <= last; i++)
+        {
+            keys.append(sampleKey(i));
+            values.append(sampleValue(i));
+        }
+        return;
+    }
+
+    if (envelope)
+        level = selectLevel(keyLow, keyHigh, maxBuckets, first, last);
+
+    for (int i = first; i <= last; i++)
+        appendBucket(bucket(level, i), envelope, keys, values);
+
+    // the newest samples are still in the open buckets of the finer levels
+    if (last == bucketCount(level) - 1)
+    {
+        for (int finer = level - 1; finer >= 0; finer--)
+        {
+            if (m_levels[finer].m_open.m_count)
+                appendBucket(m_levels[finer].m_open, envelope, keys, values);
+        }
+    }
+}
+
+void CLodPyramid::envelope(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+                           QVector<double>& keys, QVector<double>& values) const
+{
+    query(keyLow, keyHigh, maxBuckets, true, keys, values);
+}
+
+void CLodPyramid::mean(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+                       QVector<double>& keys, QVector<double>& values) const
+{
+    query(keyLow, keyHigh, maxBuckets, false, keys, values);
+}
@@ -0,0 +1,80 @@
+#ifndef CLODPYRAMID_H
+#define CLODPYRAMID_H
+
+#include <QVector>
+
+// Level of detail store of a trace with increasing keys (time). Level 0
+// buckets summarize m_fanout samples, every further level m_fanout buckets
+// of the one below. Appending is amortized O(1), only the open bucket of
+// each level changes. A query picks the finest level that gives no more
+// buckets than requested over the range, so drawing costs the pixel width
+// of the plot, not the length of the trace.
+class CLodPyramid
+{
+public:
+    typedef struct
+    {
+        double m_keyFirst;
+        double m_keyLast;
+        double m_min;
+        double m_max;
+        double m_sum;
+        int m_count;
+    } Bucket_t;
+
+    CLodPyramid();
+
+    void clear();
+    void append(const double& key, const double& value);
+
+    int size() const { return m_samples.size() / 2; }
+    int levels() const { return m_levels.size(); }
+
+    // totals of all appended samples, O(1)
+    double keyMin() const { return m_total.m_keyFirst; }
+    double keyMax() const { return m_total.m_keyLast; }
+    double valueMin() const { return m_total.m_min; }
+    double valueMax() const { return m_total.m_max; }
+
+    // min / max envelope over [keyLow, keyHigh] with at most about
+    // 2 * maxBuckets points; raw samples when they are few enough
+    void envelope(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+                  QVector<double>& keys, QVector<double>& values) const;
+
+    // the mean of every bucket instead of the envelope
+    void mean(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+              QVector<double>& keys, QVector<double>& values) const;
+
+    static const int m_fanout = 8;
+
+private:
+    typedef struct
+    {
+        QVector<Bucket_t> m_closed;
+        Bucket_t m_open;
+        int m_children;             // merged into m_open so far
+    } Level_t;
+
+    static void startBucket(Bucket_t& bucket, const double& key, const double& value);
+    static void mergeBucket(Bucket_t& bucket, const Bucket_t& other);
+    void pushBucket(const int& level, const Bucket_t& bucket);
+    static void appendBucket(const Bucket_t& bucket, const bool& envelope,
+                             QVector<double>& keys, QVector<double>& values);
+    void query(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+               const bool& envelope, QVector<double>& keys, QVector<double>& values) const;
+
+    // level -1 means raw samples; first and last index of the range
+    int selectLevel(const double& keyLow, const double& keyHigh, const int& maxBuckets,
+                    int& first, int& last) const;
+    int bucketCount(const int& level) const;
+    const Bucket_t& bucket(const int& level, const int& index) const;
+    double sampleKey(const int& index) const { return m_samples[2 * index]; }
+    double sampleValue(const int& index) const { return m_samples[2 * index + 1]; }
+    int lowerBound(const int& level, const double& key) const;
+
+    QVector<double> m_samples;      // key, value interleaved
+    QVector<Level_t> m_levels;
+    Bucket_t m_total;
+};
+
+#endif // CLODPYRAMID_H
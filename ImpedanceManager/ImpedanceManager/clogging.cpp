@@ -0,0 +1,51 @@
+#include "clogging.h"
+
+Q_LOGGING_CATEGORY(lcSerial, "impedance.serial")
+Q_LOGGING_CATEGORY(lcFrame, "impedance.serial.frame", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcMeasure, "impedance.measure")
+
+CLogThrottle::CLogThrottle(QLoggingCategory::CategoryFunction category, const char* what,
+                           const int& interval_ms)
+{
+    mp_category = category;
+    mp_what = what;
+    m_interval_ms = interval_ms;
+    m_pending.store(0);
+    m_clock.start();
+    m_lastReport_ms.store(-interval_ms);
+}
+
+void CLogThrottle::hit(const int& n)
+{
+    m_pending.fetchAndAddRelaxed(n);
+
+    qint64 now_ms = m_clock.elapsed();
+    qint64 last_ms = m_lastReport_ms.load();
+
+    // one thread wins the interval, the others only count
+    if ((now_ms - last_ms >= m_interval_ms) &&
+        m_lastReport_ms.testAndSetRelaxed(last_ms, now_ms))
+    {
+        report(now_ms - last_ms);
+    }
+}
+
+void CLogThrottle::flush()
+{
+    qint64 now_ms = m_clock.elapsed();
+    report(now_ms - m_lastReport_ms.fetchAndStoreRelaxed(now_ms));
+}
+
+void CLogThrottle::report(const qint64& elapsed_ms)
+{
+    quint64 count = m_pending.fetchAndStoreRelaxed(0);
+    if (!count)
+        return;
+
+    // a long quiet period before the first one says nothing about the rate
+    if (elapsed_ms > 2 * m_interval_ms)
+        qCWarning(mp_category) << count << mp_what;
+    else
+        qCWarning(mp_category).nospace() << count << " " << mp_what << " in the last "
+                                         << elapsed_ms / 1000.0 << " s";
+}
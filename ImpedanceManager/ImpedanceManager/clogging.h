@@ -0,0 +1,49 @@
+#ifndef CLOGGING_H
+#define CLOGGING_H
+
+#include <QLoggingCategory>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+
+// Logging categories, switched at run time with QT_LOGGING_RULES or a
+// qtlogging.ini, e.g. "impedance.serial.frame.debug=true".
+Q_DECLARE_LOGGING_CATEGORY(lcSerial)    // port, commands and their answers
+Q_DECLARE_LOGGING_CATEGORY(lcFrame)     // every frame and byte, hot path
+Q_DECLARE_LOGGING_CATEGORY(lcMeasure)   // sample path of the projects
+
+// Debug output of the hot paths (per byte, frame or sample) is compiled in
+// only with DEFINES += IM_HOT_LOG, otherwise not even the category check is
+// left. Use it like qCDebug, streamed or with printf arguments.
+#ifdef IM_HOT_LOG
+#define qCDebugHot(...) qCDebug(__VA_ARGS__)
+#else
+#define qCDebugHot(category, ...) QT_NO_QDEBUG_MACRO()
+#endif
+
+// Warning that may come with every byte or frame. Occurrences are counted
+// and reported at most once per interval as "N <what> in the last x s",
+// the first one of a quiet period right away. hit() is lock free and may be
+// called from any thread.
+class CLogThrottle
+{
+public:
+    CLogThrottle(QLoggingCategory::CategoryFunction category, const char* what,
+                 const int& interval_ms = 1000);
+
+    void hit(const int& n = 1);
+
+    // reports what was counted since the last report, if anything
+    void flush();
+
+private:
+    void report(const qint64& elapsed_ms);
+
+    QLoggingCategory::CategoryFunction mp_category;
+    const char* mp_what;
+    int m_interval_ms;
+    QElapsedTimer m_clock;
+    QAtomicInteger<quint64> m_pending;
+    QAtomicInteger<qint64> m_lastReport_ms;
+};
+
+#endif // CLOGGING_H
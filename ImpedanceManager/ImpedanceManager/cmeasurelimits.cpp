@@ -0,0 +1,116 @@
+#include "cmeasurelimits.h"
+
+#include <QtGlobal>
+
+const qint32 CMeasureLimits::m_maxVoltage_mv;
+
+QString CMeasureLimits::checkEis(const quint8& amplitude, const union32_t& freqStart,
+                                 const union32_t& freqEnd, const qint16& freqStep)
+{
+    QString badParameters;
+
+    if (!amplitude)
+        badParameters += "Amp[mV]\n";
+
+    if (!freqStart.id32)
+        badParameters += "Freq start\n";
+
+    if (!freqEnd.id32)
+        badParameters += "Freq stop\n";
+
+    if (!freqStep)
+        badParameters += "Freq step\n";
+
+    return badParameters;
+}
+
+QString CMeasureLimits::checkCv(const qint16& potStart, const qint16& potEnd,
+                                const quint8& nrOfCycles, const qint16& potStep,
+                                const qint16& scanSpeed)
+{
+    QString badParameters;
+
+    if (!potStart)
+        badParameters += "StartPot[mV]\n";
+
+    if (!potEnd)
+        badParameters += "EndPot[mV]\n";
+
+    if (!potStep)
+        badParameters += "PotStep[mV]\n";
+
+    if (!nrOfCycles)
+        badParameters += "NrOfCycles\n";
+
+    if (!scanSpeed)
+        badParameters += "ScanSpd[mV/s]\n";
+
+    return badParameters;
+}
+
+QString CMeasureLimits::checkCa(const quint16& measTime, const union32_t& dt)
+{
+    QString badParameters;
+
+    if (!measTime)
+        badParameters += "MeasTime[s]\n";
+
+    if (!dt.id32)
+        badParameters += "dt[s]\n";
+
+    return badParameters;
+}
+
+QString CMeasureLimits::checkDpv(const quint16& qt, const quint32& pn, const quint16& pa,
+                                 const qint16& ps)
+{
+    QString badParameters;
+
+    if (!qt)
+        badParameters += "QT[s]\n";
+
+    if (!pn)
+        badParameters += "PN\n";
+
+    // check either waveform wont overcome 1.5 V
+    qint64 endVoltage_mv = (qint64)ps * pn + pa;
+    if ((endVoltage_mv > m_maxVoltage_mv) || (endVoltage_mv < (m_maxVoltage_mv * -1)))
+    {
+        badParameters += "PS * PN + PA cannot be higher than " +
+                QString("%1").arg(m_maxVoltage_mv) + " mV and lower than -" +
+                QString("%1").arg(m_maxVoltage_mv) + " mV";
+    }
+
+    return badParameters;
+}
+
+QString CMeasureLimits::checkSwv(const qint16& startPot, const qint16& endPot,
+                                 const quint16& step, const quint16& amplitude,
+                                 const quint16& frequency)
+{
+    QString badParameters;
+
+    if (startPot == endPot)
+        badParameters += "EndPot[mV]\n";
+
+    if (!step)
+        badParameters += "Step[mV]\n";
+
+    if (!amplitude)
+        badParameters += "Amp[mV]\n";
+
+    if (!frequency)
+        badParameters += "Freq[Hz]\n";
+
+    // the square wave rides on the staircase, neither end may overcome 1.5 V
+    qint32 highest = qMax(startPot, endPot) + amplitude;
+    qint32 lowest = qMin(startPot, endPot) - amplitude;
+    if ((highest > m_maxVoltage_mv) || (lowest < (m_maxVoltage_mv * -1)))
+    {
+        badParameters += "Potentials +- Amp cannot be higher than " +
+                QString("%1").arg(m_maxVoltage_mv) + " mV and lower than -" +
+                QString("%1").arg(m_maxVoltage_mv) + " mV";
+    }
+
+    return badParameters;
+}
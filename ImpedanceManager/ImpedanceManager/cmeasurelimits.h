@@ -0,0 +1,32 @@
+#ifndef CMEASURELIMITS_H
+#define CMEASURELIMITS_H
+
+#include <QString>
+
+#include "MeasureUtility.h"
+
+using namespace MeasureUtility;
+
+// Checks of the raw measure request values, as they go out to the device.
+// The project tabs and the headless runner send the same requests, so both
+// go through here. Every check returns the bad parameters a line each,
+// named like the fields of the project tab, empty when the request is fine.
+class CMeasureLimits
+{
+public:
+    static QString checkEis(const quint8& amplitude, const union32_t& freqStart,
+                            const union32_t& freqEnd, const qint16& freqStep);
+    static QString checkCv(const qint16& potStart, const qint16& potEnd,
+                           const quint8& nrOfCycles, const qint16& potStep,
+                           const qint16& scanSpeed);
+    static QString checkCa(const quint16& measTime, const union32_t& dt);
+    static QString checkDpv(const quint16& qt, const quint32& pn, const quint16& pa,
+                            const qint16& ps);
+    static QString checkSwv(const qint16& startPot, const qint16& endPot,
+                            const quint16& step, const quint16& amplitude,
+                            const quint16& frequency);
+
+    static const qint32 m_maxVoltage_mv = 1500;     // of the DPV and SWV waveforms
+};
+
+#endif // CMEASURELIMITS_H
@@ -32,6 +32,8 @@ void CNewProjectDialog::on_buttonBox_accepted()
         *mp_measure = EMeasures_t::eCA;
     else if (ui->rbDpv->isChecked())
         *mp_measure = EMeasures_t::eDPV;
+    else if (ui->rbSwv->isChecked())
+        *mp_measure = EMeasures_t::eSWV;
 }
 
 void CNewProjectDialog::on_rbEis_clicked(bool checked)
@@ -0,0 +1,302 @@
+#include "cposixserialreader.h"
+#include "ctelemetry.h"
+#include "clogging.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+const int CPosixSerialReader::m_latencyBudget_ms;
+
+CPosixSerialReader::CPosixSerialReader(const QString& port, CSerialThread* serialThread) :
+    QThread()
+{
+    Q_ASSERT(serialThread);
+
+    mp_serialThread = serialThread;
+    m_portName = port;
+
+    m_ttyFd = -1;
+    m_epollFd = -1;
+    m_flushTimerFd = -1;
+    m_rxTimerFd = -1;
+    m_wakeFd = -1;
+
+    m_stop.store(0);
+}
+
+CPosixSerialReader::~CPosixSerialReader()
+{
+    if (isRunning())
+    {
+        stop();
+        wait();
+    }
+
+    closePort();
+}
+
+bool CPosixSerialReader::openPort()
+{
+    QString device = m_portName;
+    if (!device.startsWith("/"))
+        device.prepend("/dev/");
+
+    m_ttyFd = ::open(device.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_ttyFd < 0)
+    {
+        qCWarning(lcSerial) << "Cannot open tty" << device << "errno" << errno;
+        return false;
+    }
+
+    // 57600 8N1, raw, no flow control (the same as the QSerialPort backend)
+    struct termios tio;
+    if (tcgetattr(m_ttyFd, &tio))
+    {
+        qCWarning(lcSerial) << "Cannot read tty attributes of" << device;
+        closePort();
+        return false;
+    }
+
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, B57600);
+    cfsetospeed(&tio, B57600);
+    tio.c_cflag |= (CLOCAL | CREAD);
+    tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+
+    // read() never blocks, waking up is the job of epoll and the budget timer
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+
+    if (tcsetattr(m_ttyFd, TCSANOW, &tio))
+    {
+        qCWarning(lcSerial) << "Cannot set tty attributes of" << device;
+        closePort();
+        return false;
+    }
+
+    tcflush(m_ttyFd, TCIOFLUSH);
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_flushTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_rxTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if ((m_epollFd < 0) || (m_flushTimerFd < 0) || (m_rxTimerFd < 0) || (m_wakeFd < 0))
+    {
+        qCWarning(lcSerial) << "Cannot create epoll descriptors for" << device;
+        closePort();
+        return false;
+    }
+
+    int fds[] = { m_ttyFd, m_flushTimerFd, m_rxTimerFd, m_wakeFd };
+    for (int fd : fds)
+    {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+
+        if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev))
+        {
+            qCWarning(lcSerial) << "epoll_ctl failed for" << device << "errno" << errno;
+            closePort();
+            return false;
+        }
+    }
+
+    m_stop.store(0);
+    return true;
+}
+
+void CPosixSerialReader::closePort()
+{
+    int* fds[] = { &m_ttyFd, &m_epollFd, &m_flushTimerFd, &m_rxTimerFd, &m_wakeFd };
+    for (int* fd : fds)
+    {
+        if (*fd >= 0)
+            ::close(*fd);
+
+        *fd = -1;
+    }
+
+    m_decoder.reset();
+}
+
+void CPosixSerialReader::stop()
+{
+    m_stop.store(1);
+
+    if (m_wakeFd >= 0)
+    {
+        quint64 one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) != sizeof(one))
+            qCWarning(lcSerial) << "Cannot wake up serial reader";
+    }
+}
+
+void CPosixSerialReader::run()
+{
+    struct epoll_event events[4];
+
+    while (!m_stop.load())
+    {
+        int nrOfEvents = epoll_wait(m_epollFd, events, 4, -1);
+
+        if (nrOfEvents < 0)
+        {
+            if (EINTR == errno)
+                continue;
+
+            qCWarning(lcSerial) << "epoll_wait failed with errno" << errno;
+            break;
+        }
+
+        for (int i = 0; i < nrOfEvents; i++)
+        {
+            int fd = events[i].data.fd;
+
+            if (fd == m_ttyFd)
+            {
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    qCWarning(lcSerial) << "Serial port" << m_portName << "hung up";
+                    m_stop.store(1);
+
+                    // nothing services the rx timer any more, the serial
+                    // thread closes the port and tells its users
+                    QMetaObject::invokeMethod(mp_serialThread, "on_portLost", Qt::QueuedConnection);
+                    break;
+                }
+
+                // first bytes of a burst, let the rest pile up in the driver
+                watchTty(false);
+                armTimer(m_flushTimerFd, m_latencyBudget_ms);
+            }
+            else if (fd == m_flushTimerFd)
+            {
+                ackTimer(m_flushTimerFd);
+                drainTty();
+                watchTty(true);
+            }
+            else if (fd == m_rxTimerFd)
+            {
+                ackTimer(m_rxTimerFd);
+                QMetaObject::invokeMethod(mp_serialThread, "on_rxTimeout", Qt::QueuedConnection);
+            }
+            else if (fd == m_wakeFd)
+            {
+                quint64 value;
+                if (::read(m_wakeFd, &value, sizeof(value)) < 0)
+                    qCWarning(lcSerial) << "Cannot read serial reader wake up event";
+            }
+        }
+    }
+}
+
+void CPosixSerialReader::drainTty()
+{
+    QQueue<CSerialThread::ESerialFrame_t*> frames;
+    CTelemetry* telemetry = CTelemetry::instance();
+
+    forever
+    {
+        qint64 start_ns = telemetry->now();
+        ssize_t len = ::read(m_ttyFd, m_readBuffer, sizeof(m_readBuffer));
+
+        if (len > 0)
+        {
+            telemetry->record(CTelemetry::EStage_t::eRead, start_ns);
+            telemetry->count(CTelemetry::ECounter_t::eBytes, len);
+            mp_serialThread->captureRx(m_readBuffer, (int)len);
+
+            start_ns = telemetry->now();
+            m_decoder.feed(m_readBuffer, (int)len, frames);
+            telemetry->record(CTelemetry::EStage_t::eDecode, start_ns);
+        }
+        else if ((len < 0) && (EINTR == errno))
+            continue;
+        else
+            break; // EAGAIN or no more data
+    }
+
+    if (frames.length())
+        mp_serialThread->postFrames(frames);
+}
+
+void CPosixSerialReader::watchTty(const bool watch)
+{
+    struct epoll_event ev;
+    ev.events = watch ? EPOLLIN : 0;
+    ev.data.fd = m_ttyFd;
+
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, m_ttyFd, &ev))
+        qCWarning(lcSerial) << "epoll_ctl failed for" << m_portName << "errno" << errno;
+}
+
+qint64 CPosixSerialReader::write(const QByteArray& data)
+{
+    const char* ptr = data.constData();
+    qint64 left = data.length();
+
+    while (left > 0)
+    {
+        ssize_t len = ::write(m_ttyFd, ptr, left);
+
+        if (len > 0)
+        {
+            ptr += len;
+            left -= len;
+        }
+        else if ((len < 0) && (EINTR == errno))
+            continue;
+        else if ((len < 0) && (EAGAIN == errno))
+        {
+            // tx buffer full, wait for the driver to take some bytes
+            struct pollfd pfd;
+            pfd.fd = m_ttyFd;
+            pfd.events = POLLOUT;
+
+            if (poll(&pfd, 1, 100) <= 0)
+                return -1;
+        }
+        else
+            return -1;
+    }
+
+    return data.length();
+}
+
+void CPosixSerialReader::armRxTimeout(const int& interval_ms)
+{
+    armTimer(m_rxTimerFd, interval_ms);
+}
+
+void CPosixSerialReader::disarmRxTimeout()
+{
+    armTimer(m_rxTimerFd, 0);
+}
+
+void CPosixSerialReader::armTimer(const int& fd, const int& interval_ms)
+{
+    // single shot, 0 disarms
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = 0;
+    spec.it_interval.tv_nsec = 0;
+    spec.it_value.tv_sec = interval_ms / 1000;
+    spec.it_value.tv_nsec = (interval_ms % 1000) * 1000000L;
+
+    if (timerfd_settime(fd, 0, &spec, NULL))
+        qCWarning(lcSerial) << "timerfd_settime failed with errno" << errno;
+}
+
+void CPosixSerialReader::ackTimer(const int& fd)
+{
+    quint64 expirations;
+    if (::read(fd, &expirations, sizeof(expirations)) < 0 && (EAGAIN != errno))
+        qCWarning(lcSerial) << "Cannot read timerfd, errno" << errno;
+}
@@ -0,0 +1,59 @@
+#ifndef CPOSIXSERIALREADER_H
+#define CPOSIXSERIALREADER_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QDebug>
+
+#include "cserialthread.h"
+#include "cframedecoder.h"
+
+// Linux only serial backend. The tty is read without Qt event loop: epoll
+// reports the first byte of a burst, then the tty is not watched until the
+// latency budget (timerfd) expires, so everything received meanwhile is taken
+// with a single large read. Decoded frames are handed to CSerialThread in
+// batches. The rx timeout of the command pipeline is a timerfd as well.
+class CPosixSerialReader : public QThread
+{
+public:
+    CPosixSerialReader(const QString& port, CSerialThread* serialThread);
+    ~CPosixSerialReader();
+
+    void run(); // inherited
+
+    bool openPort();
+    void closePort();
+    void stop();
+
+    qint64 write(const QByteArray& data);
+    void armRxTimeout(const int& interval_ms);
+    void disarmRxTimeout();
+
+    CFrameDecoder* decoder() { return &m_decoder; }
+
+private:
+    void watchTty(const bool watch);
+    void drainTty();
+    void armTimer(const int& fd, const int& interval_ms);
+    void ackTimer(const int& fd);
+
+    QString m_portName;
+    CSerialThread* mp_serialThread;
+    CFrameDecoder m_decoder;
+
+    int m_ttyFd;
+    int m_epollFd;
+    int m_flushTimerFd;
+    int m_rxTimerFd;
+    int m_wakeFd;
+
+    QAtomicInt m_stop;
+
+    char m_readBuffer[4096];
+
+    static const int m_latencyBudget_ms = 5;
+};
+
+#endif // CPOSIXSERIALREADER_H
@@ -56,3 +56,28 @@ CProjectManager::CProjectManager(QFile& file,
 
     file.close();
 }
+
+EMeasures_t CProjectManager::measureType(QFile& file)
+{
+    EMeasures_t measure = EMeasures_t::eDummy;
+
+    if (!file.open(QFile::ReadOnly | QFile::Text))
+    {
+        qWarning() << "Cannot open " + file.fileName();
+        return measure;
+    }
+
+    QXmlStreamReader xr(&file);
+
+    while (!xr.atEnd())
+    {
+        if (xr.readNextStartElement() && (xr.name() == "measType"))
+        {
+            measure = (EMeasures_t)xr.readElementText().toInt();
+            break;
+        }
+    }
+
+    file.close();
+    return measure;
+}
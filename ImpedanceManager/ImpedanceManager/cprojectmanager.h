@@ -21,6 +21,9 @@ public:
                     QList<SettingParam_t>& paramList,
                     const bool writeProj);
 
+    // measType of a project file, the constructor leaves it out of the list
+    static EMeasures_t measureType(QFile& file);
+
 signals:
 
 public slots:
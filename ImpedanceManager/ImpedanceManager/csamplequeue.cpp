@@ -0,0 +1,68 @@
+#include "csamplequeue.h"
+
+CSampleQueue::CSampleQueue(const int& capacity)
+{
+    // round up to power of 2, so the index wraps with a mask
+    int size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    m_buffer.resize(size);
+    mp_data = m_buffer.data();
+    m_mask = size - 1;
+
+    m_head.store(0);
+    m_tail.store(0);
+    m_highWaterMark.store(0);
+    m_dropped.store(0);
+}
+
+bool CSampleQueue::push(const MeasSample_t& sample)
+{
+    quint32 head = (quint32)m_head.load();
+    quint32 tail = (quint32)m_tail.loadAcquire();
+    quint32 used = head - tail;
+
+    if (used > (quint32)m_mask)
+    {
+        m_dropped.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    mp_data[head & m_mask] = sample;
+    m_head.storeRelease((int)(head + 1));
+
+    if ((int)(used + 1) > m_highWaterMark.load())
+        m_highWaterMark.store((int)(used + 1));
+
+    return true;
+}
+
+int CSampleQueue::pop(MeasSample_t* samples, const int& maxCount)
+{
+    Q_ASSERT(samples);
+
+    quint32 tail = (quint32)m_tail.load();
+    quint32 head = (quint32)m_head.loadAcquire();
+    int count = (int)(head - tail);
+
+    if (count > maxCount)
+        count = maxCount;
+
+    for (int i = 0; i < count; i++)
+        samples[i] = mp_data[(tail + i) & m_mask];
+
+    m_tail.storeRelease((int)(tail + count));
+    return count;
+}
+
+int CSampleQueue::size() const
+{
+    return (int)((quint32)m_head.loadAcquire() - (quint32)m_tail.load());
+}
+
+void CSampleQueue::resetStatistics()
+{
+    m_highWaterMark.store(0);
+    m_dropped.store(0);
+}
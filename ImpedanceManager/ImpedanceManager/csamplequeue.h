@@ -0,0 +1,46 @@
+#ifndef CSAMPLEQUEUE_H
+#define CSAMPLEQUEUE_H
+
+#include <QAtomicInt>
+#include <QVector>
+
+#include "MeasureUtility.h"
+
+using namespace MeasureUtility;
+
+// Lock-free single producer / single consumer ring buffer of decoded samples.
+// The serial thread pushes, the GUI thread pops on its drain timer. When the
+// consumer falls behind, the newest samples are dropped and counted.
+class CSampleQueue
+{
+public:
+    explicit CSampleQueue(const int& capacity = 8192);
+
+    // producer side
+    bool push(const MeasSample_t& sample);
+
+    // consumer side
+    int pop(MeasSample_t* samples, const int& maxCount);
+    int size() const;
+    void resetStatistics();
+
+    int capacity() const { return m_mask + 1; }
+    int highWaterMark() const { return m_highWaterMark.load(); }
+    int droppedSamples() const { return m_dropped.load(); }
+
+private:
+    QVector<MeasSample_t> m_buffer;
+    MeasSample_t* mp_data; // m_buffer storage, never detached after construction
+    int m_mask;
+
+    // head and tail on separate cache lines, each written by one side only
+    QAtomicInt m_head;                  // producer
+    char m_padHead[64 - sizeof(QAtomicInt)];
+    QAtomicInt m_tail;                  // consumer
+    char m_padTail[64 - sizeof(QAtomicInt)];
+
+    QAtomicInt m_highWaterMark;
+    QAtomicInt m_dropped;
+};
+
+#endif // CSAMPLEQUEUE_H
@@ -0,0 +1,119 @@
+#include "csequencedialog.h"
+
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QSpinBox>
+#include <QDir>
+
+CSequenceDialog::CSequenceDialog(QWidget *parent) :
+    QDialog(parent)
+{
+    setWindowTitle("Measure sequence");
+    resize(520, 320);
+
+    m_twSteps.setColumnCount(2);
+    m_twSteps.setHorizontalHeaderLabels(QStringList() << "Project" << "Repetitions");
+    m_twSteps.horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_twSteps.setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_twSteps.setSelectionMode(QAbstractItemView::SingleSelection);
+    m_twSteps.setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    m_pbAdd.setText("Add...");
+    m_pbRemove.setText("Remove");
+    m_pbUp.setText("Up");
+    m_pbDown.setText("Down");
+    m_layoutButtons.addWidget(&m_pbAdd);
+    m_layoutButtons.addWidget(&m_pbRemove);
+    m_layoutButtons.addWidget(&m_pbUp);
+    m_layoutButtons.addWidget(&m_pbDown);
+    m_layoutButtons.addStretch();
+
+    m_buttonBox.setStandardButtons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    m_buttonBox.button(QDialogButtonBox::Ok)->setText("Run");
+
+    m_layout.addWidget(&m_twSteps);
+    m_layout.addLayout(&m_layoutButtons);
+    m_layout.addWidget(&m_buttonBox);
+    setLayout(&m_layout);
+
+    connect(&m_pbAdd, SIGNAL(clicked()), this, SLOT(on_add_clicked()));
+    connect(&m_pbRemove, SIGNAL(clicked()), this, SLOT(on_remove_clicked()));
+    connect(&m_pbUp, SIGNAL(clicked()), this, SLOT(on_up_clicked()));
+    connect(&m_pbDown, SIGNAL(clicked()), this, SLOT(on_down_clicked()));
+    connect(&m_buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(&m_buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+}
+
+CSequenceDialog::~CSequenceDialog()
+{
+
+}
+
+QList<CSequencer::Step_t> CSequenceDialog::steps()
+{
+    QList<CSequencer::Step_t> list;
+
+    for (int row = 0; row < m_twSteps.rowCount(); row++)
+    {
+        CSequencer::Step_t step;
+        step.m_file = m_twSteps.item(row, 0)->data(Qt::UserRole).toString();
+        step.m_repetitions = qobject_cast<QSpinBox*>(m_twSteps.cellWidget(row, 1))->value();
+        list.append(step);
+    }
+
+    return list;
+}
+
+void CSequenceDialog::insertStep(const int& row, const QString& file, const int& repetitions)
+{
+    m_twSteps.insertRow(row);
+
+    QTableWidgetItem* item = new QTableWidgetItem(QFileInfo(file).fileName());
+    item->setData(Qt::UserRole, file);
+    item->setToolTip(file);
+    m_twSteps.setItem(row, 0, item);
+
+    QSpinBox* sbRepetitions = new QSpinBox();
+    sbRepetitions->setRange(1, m_maxRepetitions);
+    sbRepetitions->setValue(repetitions);
+    m_twSteps.setCellWidget(row, 1, sbRepetitions);
+}
+
+void CSequenceDialog::moveStep(const int& from, const int& to)
+{
+    if ((from < 0) || (to < 0) || (to >= m_twSteps.rowCount()))
+        return;
+
+    // cell widgets cannot be moved, the row is built again
+    QString file = m_twSteps.item(from, 0)->data(Qt::UserRole).toString();
+    int repetitions = qobject_cast<QSpinBox*>(m_twSteps.cellWidget(from, 1))->value();
+
+    m_twSteps.removeRow(from);
+    insertStep(to, file, repetitions);
+    m_twSteps.selectRow(to);
+}
+
+void CSequenceDialog::on_add_clicked()
+{
+    QStringList files = QFileDialog::getOpenFileNames(this, tr("Add Project Files"),
+                                                      QDir::currentPath(),
+                                                      tr("IMP Files (*.imp)"));
+    for (const QString& file : files)
+        insertStep(m_twSteps.rowCount(), file, 1);
+}
+
+void CSequenceDialog::on_remove_clicked()
+{
+    if (m_twSteps.currentRow() >= 0)
+        m_twSteps.removeRow(m_twSteps.currentRow());
+}
+
+void CSequenceDialog::on_up_clicked()
+{
+    moveStep(m_twSteps.currentRow(), m_twSteps.currentRow() - 1);
+}
+
+void CSequenceDialog::on_down_clicked()
+{
+    moveStep(m_twSteps.currentRow(), m_twSteps.currentRow() + 1);
+}
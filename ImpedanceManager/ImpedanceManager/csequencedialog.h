@@ -0,0 +1,47 @@
+#ifndef CSEQUENCEDIALOG_H
+#define CSEQUENCEDIALOG_H
+
+#include <QDialog>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTableWidget>
+#include <QPushButton>
+#include <QDialogButtonBox>
+
+#include "csequencer.h"
+
+// Editor of a measure sequence: project files and their repetition counts,
+// measured top to bottom.
+class CSequenceDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CSequenceDialog(QWidget *parent = 0);
+    ~CSequenceDialog();
+
+    QList<CSequencer::Step_t> steps();
+
+private slots:
+    void on_add_clicked();
+    void on_remove_clicked();
+    void on_up_clicked();
+    void on_down_clicked();
+
+private:
+    void insertStep(const int& row, const QString& file, const int& repetitions);
+    void moveStep(const int& from, const int& to);
+
+    QVBoxLayout m_layout;
+    QHBoxLayout m_layoutButtons;
+    QTableWidget m_twSteps;
+    QPushButton m_pbAdd;
+    QPushButton m_pbRemove;
+    QPushButton m_pbUp;
+    QPushButton m_pbDown;
+    QDialogButtonBox m_buttonBox;
+
+    static const int m_maxRepetitions = 999;
+};
+
+#endif // CSEQUENCEDIALOG_H
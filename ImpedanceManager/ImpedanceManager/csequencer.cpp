@@ -0,0 +1,63 @@
+#include "csequencer.h"
+
+#include <QFileInfo>
+#include <QDebug>
+
+CSequencer::CSequencer()
+{
+    m_current = 0;
+    m_running = false;
+}
+
+void CSequencer::start(const QList<Step_t>& steps)
+{
+    m_runs.clear();
+
+    for (int s = 0; s < steps.size(); s++)
+    {
+        for (int r = 0; r < steps[s].m_repetitions; r++)
+        {
+            Run_t run;
+            run.m_file = steps[s].m_file;
+            run.m_step = s;
+            run.m_repetition = r;
+            run.m_repetitions = steps[s].m_repetitions;
+            m_runs.append(run);
+        }
+    }
+
+    m_current = 0;
+    m_running = !m_runs.isEmpty();
+
+    qDebug() << "Sequence of" << m_runs.size() << "runs in" << steps.size() << "steps";
+}
+
+void CSequencer::stop()
+{
+    if (m_running)
+        qDebug() << "Sequence stopped at run" << m_current + 1 << "of" << m_runs.size();
+
+    m_running = false;
+}
+
+void CSequencer::advance()
+{
+    if (hasNext())
+        m_current++;
+}
+
+bool CSequencer::hasNext() const
+{
+    return m_running && (m_current + 1 < m_runs.size());
+}
+
+QString CSequencer::runTitle(const Run_t& run)
+{
+    QFileInfo fi(run.m_file);
+
+    if (run.m_repetitions > 1)
+        return QString("%1 (%2/%3)").arg(fi.baseName()).arg(run.m_repetition + 1)
+                .arg(run.m_repetitions);
+
+    return fi.baseName();
+}
@@ -0,0 +1,50 @@
+#ifndef CSEQUENCER_H
+#define CSEQUENCER_H
+
+#include <QString>
+#include <QList>
+
+// Run list of a measure sequence (Measure > Sequence). Every step is a
+// project file measured m_repetitions times, each run gets its own tab.
+// MainWindow drives it: while a run is measuring the next one is opened and
+// its request is staged in the serial thread, so it leaves right behind the
+// end frame of the running measure.
+class CSequencer
+{
+public:
+    typedef struct
+    {
+        QString m_file;
+        int m_repetitions;
+    } Step_t;
+
+    typedef struct
+    {
+        QString m_file;
+        int m_step;         // from 0
+        int m_repetition;   // from 0
+        int m_repetitions;
+    } Run_t;
+
+    CSequencer();
+
+    void start(const QList<Step_t>& steps);
+    void stop();
+    void advance();
+
+    bool isRunning() const { return m_running; }
+    bool hasNext() const;
+    int runCount() const { return m_runs.size(); }
+    int currentIndex() const { return m_current; }
+    const Run_t& current() const { return m_runs[m_current]; }
+    const Run_t& next() const { return m_runs[m_current + 1]; }
+
+    static QString runTitle(const Run_t& run);
+
+private:
+    QList<Run_t> m_runs;
+    int m_current;
+    bool m_running;
+};
+
+#endif // CSEQUENCER_H
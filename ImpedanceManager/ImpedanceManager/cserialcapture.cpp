@@ -0,0 +1,98 @@
+#include "cserialcapture.h"
+#include "clogging.h"
+
+#include <QtEndian>
+#include <QDebug>
+
+const char CSerialCapture::m_magic[4] = { 'I', 'M', 'C', '1' };
+
+CSerialCapture::CSerialCapture(const QString& fileName) :
+    QThread()
+{
+    m_file.setFileName(fileName);
+    m_stop = false;
+    m_bytes = 0;
+    m_buffer.reserve(2 * m_flushSize);
+}
+
+CSerialCapture::~CSerialCapture()
+{
+    if (isRunning())
+    {
+        stop();
+        wait();
+    }
+}
+
+bool CSerialCapture::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qCWarning(lcSerial) << "Cannot open capture file" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    if (!m_file.size())
+        m_file.write(m_magic, sizeof(m_magic));
+
+    m_stop = false;
+    m_clock.start();
+    record(EDirection_t::eSession, NULL, 0);
+    return true;
+}
+
+void CSerialCapture::stop()
+{
+    m_mutex.lock();
+    m_stop = true;
+    m_wake.wakeOne();
+    m_mutex.unlock();
+}
+
+void CSerialCapture::record(const EDirection_t& direction, const char* data, const int& length)
+{
+    char header[m_recordHeader];
+    header[0] = (char)direction;
+    qToLittleEndian<quint64>((quint64)m_clock.nsecsElapsed(), (uchar*)header + 1);
+    qToLittleEndian<quint32>((quint32)length, (uchar*)header + 9);
+
+    m_mutex.lock();
+    m_buffer.append(header, m_recordHeader);
+    if (length)
+        m_buffer.append(data, length);
+
+    if (m_buffer.size() >= m_flushSize)
+        m_wake.wakeOne();
+    m_mutex.unlock();
+}
+
+void CSerialCapture::run()
+{
+    QByteArray pending;
+    pending.reserve(2 * m_flushSize);
+    bool stopping = false;
+
+    while (!stopping)
+    {
+        m_mutex.lock();
+        if (!m_stop && (m_buffer.size() < m_flushSize))
+            m_wake.wait(&m_mutex, m_flushInterval_ms);
+
+        stopping = m_stop;
+        m_buffer.swap(pending);
+        m_mutex.unlock();
+
+        if (pending.isEmpty())
+            continue;
+
+        if (m_file.write(pending) != pending.size())
+            qCWarning(lcSerial) << "Capture file" << m_file.fileName() << "write failed";
+
+        m_file.flush();
+        m_bytes += pending.size();
+        pending.resize(0); // keeps the reserved capacity
+    }
+
+    m_file.close();
+    qCDebug(lcSerial) << "Capture" << m_file.fileName() << m_bytes << "bytes written";
+}
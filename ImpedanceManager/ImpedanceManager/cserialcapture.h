@@ -0,0 +1,58 @@
+#ifndef CSERIALCAPTURE_H
+#define CSERIALCAPTURE_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+
+// Append-only capture of the raw serial stream (Settings > Capture). Every
+// received and sent portion of bytes is one record:
+//
+//  quint8 direction (EDirection_t), quint64 time [ns], quint32 length, bytes
+//
+// little endian, after the "IMC1" magic of a new file. The time is monotonic
+// from the start of the session, every connection starts with an eSession
+// record. record() only copies into a buffer, the file is written by this
+// thread every m_flushInterval_ms or m_flushSize bytes.
+class CSerialCapture : public QThread
+{
+public:
+    enum class EDirection_t
+    {
+          eRx                       = 0
+        , eTx                       = 1
+        , eSession                  = 2 // new connection, time starts from 0
+    };
+
+    explicit CSerialCapture(const QString& fileName);
+    ~CSerialCapture();
+
+    void run(); // inherited
+
+    bool open();
+    void stop();
+
+    // any thread
+    void record(const EDirection_t& direction, const char* data, const int& length);
+
+    static const char m_magic[4];
+    static const int m_recordHeader = 1 + 8 + 4;
+
+private:
+    QFile m_file;
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QByteArray m_buffer;        // filled by record(), swapped out by run()
+    QElapsedTimer m_clock;
+    bool m_stop;
+    quint64 m_bytes;
+
+    static const int m_flushInterval_ms = 200;
+    static const int m_flushSize = 64 * 1024;
+};
+
+#endif // CSERIALCAPTURE_H
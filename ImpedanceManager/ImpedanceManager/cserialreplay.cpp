@@ -0,0 +1,167 @@
+#include "cserialreplay.h"
+#include "clogging.h"
+
+#include <QDebug>
+#include <cstring>
+
+CSerialReplay::CSerialReplay(const QString& fileName, const bool fast,
+                             CSerialThread* serialThread) :
+    QThread()
+{
+    Q_ASSERT(serialThread);
+
+    m_file.setFileName(fileName);
+    m_fast = fast;
+    mp_serialThread = serialThread;
+    m_stop = false;
+}
+
+CSerialReplay::~CSerialReplay()
+{
+    if (isRunning())
+    {
+        stop();
+        wait();
+    }
+}
+
+bool CSerialReplay::openCapture()
+{
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qCWarning(lcSerial) << "Cannot open capture file" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    char magic[sizeof(CSerialCapture::m_magic)];
+    if ((m_file.read(magic, sizeof(magic)) != sizeof(magic)) ||
+        memcmp(magic, CSerialCapture::m_magic, sizeof(magic)))
+    {
+        qCWarning(lcSerial) << m_file.fileName() << "is not a capture file";
+        m_file.close();
+        return false;
+    }
+
+    m_stream.setDevice(&m_file);
+    m_stream.setByteOrder(QDataStream::LittleEndian);
+    m_stop = false;
+    return true;
+}
+
+void CSerialReplay::stop()
+{
+    m_mutex.lock();
+    m_stop = true;
+    m_wake.wakeOne();
+    m_mutex.unlock();
+}
+
+qint64 CSerialReplay::write(const QByteArray& data)
+{
+    m_mutex.lock();
+    m_written.enqueue(data);
+    m_wake.wakeOne();
+    m_mutex.unlock();
+
+    return data.length();
+}
+
+bool CSerialReplay::readRecord(CSerialCapture::EDirection_t& direction, qint64& time_ns,
+                               QByteArray& data)
+{
+    quint8 dir;
+    quint64 time;
+    quint32 length;
+
+    m_stream >> dir >> time >> length;
+    if (QDataStream::Ok != m_stream.status())
+        return false;
+
+    data.resize(length);
+    if (m_stream.readRawData(data.data(), length) != (int)length)
+        return false;
+
+    direction = (CSerialCapture::EDirection_t)dir;
+    time_ns = (qint64)time;
+    return true;
+}
+
+bool CSerialReplay::waitForWrite(QByteArray& written)
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_stop && m_written.isEmpty())
+        m_wake.wait(&m_mutex);
+
+    if (m_stop)
+        return false;
+
+    written = m_written.dequeue();
+    return true;
+}
+
+bool CSerialReplay::waitUntil(const qint64& due_ns)
+{
+    QMutexLocker locker(&m_mutex);
+
+    forever
+    {
+        if (m_stop)
+            return false;
+
+        qint64 left_ms = (due_ns - m_clock.nsecsElapsed()) / 1000000;
+        if (left_ms <= 0)
+            return true;
+
+        m_wake.wait(&m_mutex, (unsigned long)left_ms); // stop() wakes up early
+    }
+}
+
+void CSerialReplay::run()
+{
+    CSerialCapture::EDirection_t direction;
+    qint64 time_ns;
+    qint64 offset_ns = 0;   // capture time to replay clock
+    QByteArray data, written;
+    quint64 rxBytes = 0;
+    int txRecords = 0;
+    int txMismatches = 0;
+
+    m_clock.start();
+
+    while (readRecord(direction, time_ns, data))
+    {
+        if (CSerialCapture::EDirection_t::eTx == direction)
+        {
+            // the answers follow the program's request, not the recorded time
+            if (!waitForWrite(written))
+                break;
+
+            txRecords++;
+            if (written != data)
+                txMismatches++;
+
+            offset_ns = m_clock.nsecsElapsed() - time_ns;
+        }
+        else if (CSerialCapture::EDirection_t::eRx == direction)
+        {
+            if (!m_fast && !waitUntil(time_ns + offset_ns))
+                break;
+
+            QQueue<CSerialThread::ESerialFrame_t*> frames;
+            m_decoder.feed(data.constData(), data.length(), frames);
+            rxBytes += data.length();
+
+            if (frames.length())
+                mp_serialThread->postFrames(frames);
+        }
+        else
+            offset_ns = m_clock.nsecsElapsed() - time_ns;
+    }
+
+    qCDebug(lcSerial) << "Replay of" << m_file.fileName() << "done in" << m_clock.elapsed() << "ms,"
+                      << rxBytes << "bytes received," << txRecords << "frames sent,"
+                      << txMismatches << "different from the capture";
+
+    m_file.close();
+}
@@ -0,0 +1,57 @@
+#ifndef CSERIALREPLAY_H
+#define CSERIALREPLAY_H
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QDataStream>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QElapsedTimer>
+
+#include "cserialthread.h"
+#include "cframedecoder.h"
+#include "cserialcapture.h"
+
+// Serial backend playing a CSerialCapture file instead of a port. Received
+// bytes go through the decoder in the recorded portions, at the recorded
+// pace or as fast as possible. Playback is kept in step with the program:
+// the bytes after a sent record are released only once the program has sent
+// its own frame, which is compared with the recorded one.
+class CSerialReplay : public QThread
+{
+public:
+    CSerialReplay(const QString& fileName, const bool fast, CSerialThread* serialThread);
+    ~CSerialReplay();
+
+    void run(); // inherited
+
+    bool openCapture();
+    void stop();
+
+    qint64 write(const QByteArray& data);
+
+    CFrameDecoder* decoder() { return &m_decoder; }
+
+private:
+    bool readRecord(CSerialCapture::EDirection_t& direction, qint64& time_ns,
+                    QByteArray& data);
+    bool waitForWrite(QByteArray& written);
+    bool waitUntil(const qint64& due_ns);
+
+    QFile m_file;
+    QDataStream m_stream;
+    bool m_fast;
+    CSerialThread* mp_serialThread;
+    CFrameDecoder m_decoder;
+    QElapsedTimer m_clock;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QQueue<QByteArray> m_written;   // sent by the program, not matched yet
+    bool m_stop;
+};
+
+#endif // CSERIALREPLAY_H
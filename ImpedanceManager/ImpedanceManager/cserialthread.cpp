@@ -1,12 +1,40 @@
 #include "cserialthread.h"
+#include "cframedecoder.h"
+#include "ccrc16.h"
+#include "cserialcapture.h"
+#include "cserialreplay.h"
+#include "ctelemetry.h"
+#include "clogging.h"
+
+#ifdef Q_OS_LINUX
+#include "cposixserialreader.h"
+#endif
 
 
 CSerialThread::CSerialThread(const QString& port, QObject *parent) :
-    QThread(parent)
+    QThread(parent),
+    m_unknownCommandLog(lcSerial, "frames with unknown command")
 {
     //Q_ASSERT(parent);
 
     mp_serial = new QSerialPort(this);
+    mp_posixReader = NULL;
+    mp_replay = NULL;
+    mp_capture = NULL;
+    m_replayFast = false;
+    mp_frameDecoder = new CFrameDecoder;
+    mp_RxTimeoutTimer = NULL;
+    m_backend = ESerialBackend_t::eQtSerialPort;
+    m_preferredCrcMode = ECrcMode_t::eLegacySum;
+    m_crcMode = ECrcMode_t::eLegacySum;
+    m_requestedCrcMode = ECrcMode_t::eLegacySum;
+    m_badCrcCount = 0;
+    m_frameReceived_ns = 0;
+    m_measureActive.store(0);
+    m_staging = false;
+    m_hasStagedMeasure = false;
+    m_stagedAnswerPending = false;
+    m_clock.start();
 
     foreach (const QSerialPortInfo &info, QSerialPortInfo::availablePorts())
     {
@@ -18,7 +46,7 @@ CSerialThread::CSerialThread(const QString& port, QObject *parent) :
     }
 
     if (mp_serial->portName() != port)
-        qWarning() << "Serial port" << port << "not found!";
+        qCWarning(lcSerial) << "Serial port" << port << "not found!";
 
     // just to mark the last used port name
     mp_serial->setPortName(port);
@@ -26,9 +54,15 @@ CSerialThread::CSerialThread(const QString& port, QObject *parent) :
 
 CSerialThread::~CSerialThread()
 {   
-    if (mp_frameStruct) delete mp_frameStruct;
+    if (mp_frameDecoder) delete mp_frameDecoder;
     if (mp_RxTimeoutTimer) delete mp_RxTimeoutTimer;
 
+#ifdef Q_OS_LINUX
+    if (mp_posixReader) delete mp_posixReader;
+#endif
+    if (mp_replay) delete mp_replay;
+    if (mp_capture) delete mp_capture;
+
     if (mp_serial)
     {
         mp_serial->close();
@@ -38,10 +72,71 @@ CSerialThread::~CSerialThread()
 
 void CSerialThread::run()
 {
+    // statistics of this connection only
+    m_statsMutex.lock();
+    m_commandStats.clear();
+    m_statsMutex.unlock();
+
+    if (ESerialBackend_t::eReplay == m_backend)
+    {
+        mp_replay = new CSerialReplay(m_replayFile, m_replayFast, this);
+
+        if (!mp_replay->openCapture())
+        {
+            delete mp_replay;
+            mp_replay = NULL;
+
+            emit openPort(1);
+            exit(1);
+            return;
+        }
+
+        mp_RxTimeoutTimer = new QTimer();
+        connect(mp_RxTimeoutTimer, SIGNAL(timeout()),
+                this, SLOT(on_rxTimeout()), Qt::UniqueConnection);
+        mp_RxTimeoutTimer->setSingleShot(true);
+
+        mp_replay->start();
+
+        emit openPort(0);
+        exec();
+        return;
+    }
+
+    openCapture();
+
+#ifdef Q_OS_LINUX
+    if (ESerialBackend_t::ePosixEpoll == m_backend)
+    {
+        // the reader thread reads and decodes, this thread only dispatches
+        // frames and sends commands
+        mp_posixReader = new CPosixSerialReader(mp_serial->portName(), this);
+
+        if (!mp_posixReader->openPort())
+        {
+            delete mp_posixReader;
+            mp_posixReader = NULL;
+
+            closeCapture();
+            emit openPort(1);
+            qCWarning(lcSerial) << "Cannot open serial port" << mp_serial->portName();
+            exit(1);
+            return;
+        }
+
+        mp_posixReader->start();
+
+        emit openPort(0);
+        exec();
+        return;
+    }
+#endif
+
     if (!mp_serial->open(QIODevice::ReadWrite))
     {
+        closeCapture();
         emit openPort(1);
-        qWarning() << "Cannot open serial port" << mp_serial->portName();
+        qCWarning(lcSerial) << "Cannot open serial port" << mp_serial->portName();
         exit(1);
         return;
     }
@@ -59,7 +154,6 @@ void CSerialThread::run()
             this, SLOT(on_rxTimeout()), Qt::UniqueConnection);
 
     mp_RxTimeoutTimer->setSingleShot(true);
-    mp_RxTimeoutTimer->setInterval(m_rxTimeoutInterval_ms);
 
     mp_serial->setBaudRate(QSerialPort::Baud57600);
     mp_serial->setDataBits(QSerialPort::Data8);
@@ -72,7 +166,8 @@ void CSerialThread::run()
 }
 
 void CSerialThread::sendData(const ESerialCommand_t& command,
-                             const QByteArray& data, const bool wantAck)
+                             const QByteArray& data, const bool wantAck,
+                             const int retryLimit)
 {
     qint16 crc = 0;
     quint32 len = 0;
@@ -80,7 +175,6 @@ void CSerialThread::sendData(const ESerialCommand_t& command,
     m_sendBuffer.clear();
     m_sendBuffer.append(m_syncByte);                      // sync byte
     m_sendBuffer.append((quint8)command);                 // command
-    m_sentCommand = command;                              // timeout purposes
 
     len = data.length() + sizeof(crc);                    // len = data + crc
     m_sendBuffer.append((quint8)(len & 0xFF));            // len
@@ -93,131 +187,297 @@ void CSerialThread::sendData(const ESerialCommand_t& command,
     m_sendBuffer.append((quint8)(crc & 0xFF));            // crc
     m_sendBuffer.append((quint8)((crc >> 8) & 0xFF));     // crc
 
-    if (!mp_serial->write(m_sendBuffer))
-        qWarning() << "Sending data on port" << mp_serial->portName() << "failed";
+    if (!wantAck)
+    {
+        if (writeData(m_sendBuffer) <= 0)
+            qCWarning(lcSerial) << "Sending data on port" << mp_serial->portName() << "failed";
+
+        return;
+    }
+
+    PendingCommand_t pending;
+    pending.m_command = command;
+    pending.m_frame = m_sendBuffer;
+    pending.m_retries = 0;
+    pending.m_retryLimit = retryLimit;
+
+    if (isMeasureRequest(command))
+    {
+        if (m_staging)
+        {
+            m_staging = false;
+
+            if (m_measureActive.load())
+            {
+                // goes out with the end frame of the running measure
+                m_stagedMeasure = pending;
+                m_hasStagedMeasure = true;
+                return;
+            }
+
+            // nothing running any more, no reason to wait
+            m_sampleSink = m_stagedSink;
+            m_stagedSink.clear();
+            m_stagedAnswerPending = true;
+        }
+
+        m_measureActive.store(1);
+    }
+
+    // several commands may wait for their answers at once
+    if (m_pendingCommands.length() < m_windowSize)
+        transmitCommand(pending);
     else
+        m_waitingCommands.enqueue(pending);
+}
+
+bool CSerialThread::isMeasureRequest(const ESerialCommand_t& command)
+{
+    switch (command)
     {
-        if (wantAck)
-            mp_RxTimeoutTimer->start();
+        case ESerialCommand_t::e_takeMeasEis:
+        case ESerialCommand_t::e_takeMeasCv:
+        case ESerialCommand_t::e_takeMeasCa:
+        case ESerialCommand_t::e_takeMeasDpv:
+        case ESerialCommand_t::e_takeMeasSwv:
+            return true;
+
+        default:
+            return false;
     }
 }
 
-qint16 CSerialThread::getCrc(const QByteArray& bArray)
+void CSerialThread::sendStagedMeasure()
 {
-    qint16 crc = 0;
+    m_measureActive.store(0);
 
-    for (auto item : bArray)
-        crc += (qint16)((quint8)item);
+    if (!m_hasStagedMeasure)
+        return;
 
-    return ~crc;
+    // chunks of the next measure go to its project from the first one on
+    m_hasStagedMeasure = false;
+    m_sampleSink = m_stagedSink;
+    m_stagedSink.clear();
+    m_measureActive.store(1);
+    m_stagedAnswerPending = true;
+
+    if (m_pendingCommands.length() < m_windowSize)
+        transmitCommand(m_stagedMeasure);
+    else
+        m_waitingCommands.enqueue(m_stagedMeasure);
 }
 
-qint16 CSerialThread::getCrc(const ESerialFrame_t& frame)
+void CSerialThread::transmitCommand(PendingCommand_t& pending)
 {
-    quint32 crc = 0;
+    if (writeData(pending.m_frame) <= 0)
+        qCWarning(lcSerial) << "Sending data on port" << mp_serial->portName() << "failed";
 
-    crc += frame.m_syncByte;
-    crc += (qint16)((quint8)frame.m_command);
-    crc += (qint16)frame.m_length;
+    // a failed write is retried on the timeout like a lost answer
+    pending.m_sent_us = m_clock.nsecsElapsed() / 1000;
+    pending.m_deadline_ms = m_clock.elapsed() + m_rxTimeoutInterval_ms;
 
-    for (auto item : frame.m_data)
-        crc += (qint16)((quint8)item);
+    if (!pending.m_retries)
+        m_pendingCommands.append(pending);
 
-    return ~crc;
+    scheduleRxTimeout();
 }
 
-void CSerialThread::on_readyRead()
+void CSerialThread::completeCommand(const ESerialCommand_t& command)
 {
-    mp_RxTimeoutTimer->start(); // reset timer
-    QByteArray receiveBuffer(mp_serial->readAll());
-    int errorCode = 0;
-
-    while(receiveBuffer.length())
+    // oldest command of this type is the one being answered
+    for (int i = 0; i < m_pendingCommands.length(); i++)
     {
-        errorCode = digForFrames(receiveBuffer);
-        if (errorCode)
-            qWarning() << "Examinating bytes from serial port failed" << errorCode;
+        if (m_pendingCommands[i].m_command != command)
+            continue;
+
+        PendingCommand_t pending = m_pendingCommands.takeAt(i);
+        qint64 latency_us = m_clock.nsecsElapsed() / 1000 - pending.m_sent_us;
+
+        m_statsMutex.lock();
+        CommandStats_t& stats = m_commandStats[(int)command];
+        if (!stats.m_answered || (latency_us < stats.m_latencyMin_us))
+            stats.m_latencyMin_us = latency_us;
+        if (latency_us > stats.m_latencyMax_us)
+            stats.m_latencyMax_us = latency_us;
+        stats.m_latencySum_us += latency_us;
+        stats.m_answered++;
+        m_statsMutex.unlock();
+
+        // window has a free slot now
+        if (m_waitingCommands.length())
+        {
+            PendingCommand_t next = m_waitingCommands.dequeue();
+            transmitCommand(next);
+        }
+
+        scheduleRxTimeout();
+        return;
     }
+}
 
-    if (m_frameQueue.length() >= 1)
-        frameReady();
+QHash<int, CSerialThread::CommandStats_t> CSerialThread::commandStats()
+{
+    QMutexLocker locker(&m_statsMutex);
+    return m_commandStats;
 }
 
-int CSerialThread::digForFrames(QByteArray& buffer)
+qint64 CSerialThread::writeData(const QByteArray& data)
 {
-    static thread_local quint32 currentIndex = 0;
-    static thread_local bool newFrame = false;
-    static thread_local quint32 lastLen = 2 + sizeof(quint32);
-    quint8 data = 0;
+    if (mp_capture)
+        mp_capture->record(CSerialCapture::EDirection_t::eTx, data.constData(), data.length());
 
-    if (0 == buffer.length())
-        return 3;
+    if (mp_replay)
+        return mp_replay->write(data);
 
-    data = (quint8)buffer[0];
-    buffer.remove(0, 1);
+#ifdef Q_OS_LINUX
+    if (mp_posixReader)
+        return mp_posixReader->write(data);
+#endif
+
+    return mp_serial->write(data);
+}
 
-    if (0 == currentIndex)
+void CSerialThread::scheduleRxTimeout()
+{
+    // one timer for the whole pipeline, armed to the nearest deadline
+    if (m_pendingCommands.isEmpty())
     {
-        if (m_syncByte == data)
-        {
-            mp_frameStruct = new ESerialFrame_t;
-            mp_frameStruct->m_length = 0;
+        stopRxTimeout();
+        return;
+    }
 
-            mp_frameStruct->m_syncByte = data;
-            newFrame = true;
-        }
-        else return 1;
+    qint64 deadline = m_pendingCommands.first().m_deadline_ms;
+    for (const PendingCommand_t& pending : m_pendingCommands)
+    {
+        if (pending.m_deadline_ms < deadline)
+            deadline = pending.m_deadline_ms;
     }
-    else if (newFrame)
+
+    qint64 interval = deadline - m_clock.elapsed();
+    armRxTimeout(interval > 0 ? (int)interval : 1);
+}
+
+void CSerialThread::armRxTimeout(const int& interval_ms)
+{
+#ifdef Q_OS_LINUX
+    if (mp_posixReader)
     {
-        if (1 == currentIndex)
-            mp_frameStruct->m_command = (ESerialCommand_t)data;
-        else if ((currentIndex > 1) && (currentIndex < lastLen))
-            mp_frameStruct->m_length |= (data << (8 * (currentIndex - 2)));
-        else
-        {
-            if ((currentIndex - lastLen) < (mp_frameStruct->m_length - 1))
-            {
-                if ((currentIndex - lastLen) == (mp_frameStruct->m_length - 2))
-                    mp_frameStruct->m_crc = data;
-                else
-                    mp_frameStruct->m_data.append(data);
-            }
-            else if ((currentIndex - lastLen) == (mp_frameStruct->m_length - 1)) // last byte
-            {
-                mp_frameStruct->m_crc |= (data << 8);
+        mp_posixReader->armRxTimeout(interval_ms);
+        return;
+    }
+#endif
 
-                qint16 calculatedCrc = getCrc(*mp_frameStruct);
-                if (mp_frameStruct->m_crc == calculatedCrc)
-                    m_frameQueue.enqueue(mp_frameStruct);
-                else
-                {
-                    qWarning("Bad CRC. Received 0x%X Calculated 0x%X",
-                             mp_frameStruct->m_crc, calculatedCrc);
-                    delete mp_frameStruct;
-                }
+    if (mp_RxTimeoutTimer)
+        mp_RxTimeoutTimer->start(interval_ms);
+}
 
-                currentIndex = 0;
-                return 0;
-            }
-        }
+void CSerialThread::stopRxTimeout()
+{
+#ifdef Q_OS_LINUX
+    if (mp_posixReader)
+    {
+        mp_posixReader->disarmRxTimeout();
+        return;
     }
-    else return 2;
+#endif
 
-    currentIndex++;
-    return 0;
+    if (mp_RxTimeoutTimer)
+        mp_RxTimeoutTimer->stop();
+}
+
+qint16 CSerialThread::getCrc(const QByteArray& bArray)
+{
+    if (ECrcMode_t::eCrc16Ccitt == m_crcMode)
+        return (qint16)CCrc16::compute(bArray.constData(), bArray.length());
+
+    qint16 crc = 0;
+
+    for (auto item : bArray)
+        crc += (qint16)((quint8)item);
+
+    return ~crc;
+}
+
+CFrameDecoder* CSerialThread::activeDecoder()
+{
+    if (mp_replay)
+        return mp_replay->decoder();
+
+#ifdef Q_OS_LINUX
+    if (mp_posixReader)
+        return mp_posixReader->decoder();
+#endif
+
+    return mp_frameDecoder;
+}
+
+quint32 CSerialThread::badCrcCount()
+{
+    return m_badCrcCount + activeDecoder()->badCrcCount();
+}
+
+void CSerialThread::on_readyRead()
+{
+    CTelemetry* telemetry = CTelemetry::instance();
+    qint64 start_ns = telemetry->now();
+    QByteArray receiveBuffer(mp_serial->readAll());
+    QQueue<ESerialFrame_t*> frames;
+
+    telemetry->record(CTelemetry::EStage_t::eRead, start_ns);
+    telemetry->count(CTelemetry::ECounter_t::eBytes, receiveBuffer.length());
+    captureRx(receiveBuffer.constData(), receiveBuffer.length());
+
+    start_ns = telemetry->now();
+    mp_frameDecoder->feed(receiveBuffer.constData(), receiveBuffer.length(), frames);
+    telemetry->record(CTelemetry::EStage_t::eDecode, start_ns);
+
+    if (frames.length() >= 1)
+        postFrames(frames);
+}
+
+void CSerialThread::postFrames(QQueue<ESerialFrame_t*>& frames)
+{
+    bool wasEmpty;
+
+    m_frameQueueMutex.lock();
+    wasEmpty = m_frameQueue.isEmpty();
+    while (frames.length())
+        m_frameQueue.enqueue(frames.dequeue());
+    m_frameQueueMutex.unlock();
+
+    if (QThread::currentThread() == this)
+        frameReady();
+    else if (wasEmpty) // one wakeup per batch, the rest is already scheduled
+        QMetaObject::invokeMethod(this, "on_framesReady", Qt::QueuedConnection);
+}
+
+void CSerialThread::on_framesReady()
+{
+    frameReady();
 }
 
 void CSerialThread::frameReady()
 {
-    mp_RxTimeoutTimer->stop();
     static ESerialFrame_t frame;
 
-    do
+    forever
     {
-        frame = *m_frameQueue.head();
-        delete m_frameQueue.head();
-        m_frameQueue.dequeue();
+        m_frameQueueMutex.lock();
+        if (m_frameQueue.isEmpty())
+        {
+            m_frameQueueMutex.unlock();
+            break;
+        }
+
+        ESerialFrame_t* head = m_frameQueue.dequeue();
+        m_frameQueueMutex.unlock();
+
+        frame = *head;
+        delete head;
+
+        qint64 start_ns = CTelemetry::instance()->now();
+        m_frameReceived_ns = frame.m_received_ns;
+        completeCommand(frame.m_command);
 
         m_sendBuffer.clear();
         m_sendBuffer.append(m_syncByte);
@@ -233,6 +493,30 @@ void CSerialThread::frameReady()
                     id.id8[i] = frame.m_data[i];
 
                 emit received_getFirmwareID(id);
+
+                // firmware is there, try the stronger frame check
+                if ((ECrcMode_t::eCrc16Ccitt == m_preferredCrcMode) &&
+                    (ECrcMode_t::eLegacySum == m_crcMode))
+                {
+                    send_setCrcMode(ECrcMode_t::eCrc16Ccitt, true);
+                }
+                break;
+            }
+
+            case ESerialCommand_t::e_setCrcMode: // answer
+            {
+                if (frame.m_data.length() && (0 == frame.m_data[0]))
+                {
+                    // the decoder has switched itself already
+                    m_crcMode = m_requestedCrcMode;
+                    qCDebug(lcSerial) << "SERIAL: CRC mode" << (int)m_crcMode << "accepted";
+                }
+                else
+                {
+                    activeDecoder()->disarmCrcMode();
+                    qCWarning(lcSerial) << "SERIAL: CRC mode" << (int)m_requestedCrcMode
+                                        << "declined, keeping" << (int)m_crcMode;
+                }
                 break;
             }
 
@@ -240,8 +524,11 @@ void CSerialThread::frameReady()
 
             case ESerialCommand_t::e_takeMeasEis: // answer
             {
-                qDebug() << "SERIAL: Answer for e_takeMeasEis";
-                emit received_takeMeasEis((bool)frame.m_data[0]);
+                qCDebug(lcSerial) << "SERIAL: Answer for e_takeMeasEis";
+                if (frame.m_data[0])
+                    m_measureActive.store(0);
+                if (!answerStaged((bool)frame.m_data[0]))
+                    emit received_takeMeasEis((bool)frame.m_data[0]);
                 break;
             }
 
@@ -261,13 +548,15 @@ void CSerialThread::frameReady()
                 for (size_t k = 0; k < sizeof(union32_t); i++, k++)
                     freqPoint.id8[k] = frame.m_data[i];
 
-                emit received_giveMeasChunkEis(realImp, imagImp, freqPoint);
+                if (!sinkSample(0, realImp, imagImp, freqPoint))
+                    emit received_giveMeasChunkEis(realImp, imagImp, freqPoint);
                 break;
             }
 
             case ESerialCommand_t::e_endMeasEis: // command
             {
                 send_endMeasEis();
+                sendStagedMeasure();
                 emit received_endMeasEis();
                 break;
             }
@@ -276,8 +565,11 @@ void CSerialThread::frameReady()
 
             case ESerialCommand_t::e_takeMeasCv: // answer
             {
-                qDebug() << "SERIAL: Answer for e_takeMeasCv";
-                emit received_takeMeasCv((bool)frame.m_data[0]);
+                qCDebug(lcSerial) << "SERIAL: Answer for e_takeMeasCv";
+                if (frame.m_data[0])
+                    m_measureActive.store(0);
+                if (!answerStaged((bool)frame.m_data[0]))
+                    emit received_takeMeasCv((bool)frame.m_data[0]);
                 break;
             }
 
@@ -297,13 +589,15 @@ void CSerialThread::frameReady()
                 for (size_t k = 0; k < sizeof(union32_t); i++, k++)
                     voltage.id8[k] = frame.m_data[i];
 
-                emit received_giveMeasChunkCv(sampleNr, current, voltage);
+                if (!sinkSample(sampleNr, current, voltage, union32_t()))
+                    emit received_giveMeasChunkCv(sampleNr, current, voltage);
                 break;
             }
 
             case ESerialCommand_t::e_endMeasCv: // command
             {
                 send_endMeasCv();
+                sendStagedMeasure();
                 emit received_endMeasCv();
                 break;
             }
@@ -312,8 +606,11 @@ void CSerialThread::frameReady()
 
             case ESerialCommand_t::e_takeMeasCa: // answer
             {
-                qDebug() << "SERIAL: Answer for e_takeMeasCa";
-                emit received_takeMeasCa((bool)frame.m_data[0]);
+                qCDebug(lcSerial) << "SERIAL: Answer for e_takeMeasCa";
+                if (frame.m_data[0])
+                    m_measureActive.store(0);
+                if (!answerStaged((bool)frame.m_data[0]))
+                    emit received_takeMeasCa((bool)frame.m_data[0]);
                 break;
             }
 
@@ -329,13 +626,15 @@ void CSerialThread::frameReady()
                 for (size_t k = 0; k < sizeof(union32_t); i++, k++)
                     time.id8[k] = frame.m_data[i];
 
-                emit received_giveMeasChunkCa(current, time);
+                if (!sinkSample(0, current, time, union32_t()))
+                    emit received_giveMeasChunkCa(current, time);
                 break;
             }
 
             case ESerialCommand_t::e_endMeasCa: // command
             {
                 send_endMeasCa();
+                sendStagedMeasure();
                 emit received_endMeasCa();
                 break;
             }
@@ -344,8 +643,11 @@ void CSerialThread::frameReady()
 
             case ESerialCommand_t::e_takeMeasDpv: // answer
             {
-                qDebug() << "SERIAL: Answer for e_takeMeasDpv";
-                emit received_takeMeasDpv((bool)frame.m_data[0]);
+                qCDebug(lcSerial) << "SERIAL: Answer for e_takeMeasDpv";
+                if (frame.m_data[0])
+                    m_measureActive.store(0);
+                if (!answerStaged((bool)frame.m_data[0]))
+                    emit received_takeMeasDpv((bool)frame.m_data[0]);
                 break;
             }
 
@@ -361,40 +663,263 @@ void CSerialThread::frameReady()
                 for (size_t k = 0; k < sizeof(union32_t); i++, k++)
                     voltage.id8[k] = frame.m_data[i];
 
-                emit received_giveMeasChunkDpv(current, voltage);
+                if (!sinkSample(0, current, voltage, union32_t()))
+                    emit received_giveMeasChunkDpv(current, voltage);
                 break;
             }
 
             case ESerialCommand_t::e_endMeasDpv: // command
             {
                 send_endMeasDpv();
+                sendStagedMeasure();
                 emit received_endMeasDpv();
                 break;
             }
 
+            // SWV
+
+            case ESerialCommand_t::e_takeMeasSwv: // answer
+            {
+                qCDebug(lcSerial) << "SERIAL: Answer for e_takeMeasSwv";
+                if (frame.m_data[0])
+                    m_measureActive.store(0);
+                if (!answerStaged((bool)frame.m_data[0]))
+                    emit received_takeMeasSwv((bool)frame.m_data[0]);
+                break;
+            }
+
+            case ESerialCommand_t::e_giveMeasChunkSwv: // command
+            {
+                union32_t forward;
+                union32_t reverse;
+                union32_t voltage;
+                quint32 i = 0;
+
+                for (size_t k = 0; k < sizeof(union32_t); i++, k++)
+                    forward.id8[k] = frame.m_data[i];
+
+                for (size_t k = 0; k < sizeof(union32_t); i++, k++)
+                    reverse.id8[k] = frame.m_data[i];
+
+                for (size_t k = 0; k < sizeof(union32_t); i++, k++)
+                    voltage.id8[k] = frame.m_data[i];
+
+                if (!sinkSample(0, forward, reverse, voltage))
+                    emit received_giveMeasChunkSwv(forward, reverse, voltage);
+                break;
+            }
+
+            case ESerialCommand_t::e_endMeasSwv: // command
+            {
+                send_endMeasSwv();
+                sendStagedMeasure();
+                emit received_endMeasSwv();
+                break;
+            }
+
             // UNKNOWN
 
             default:
             {
-                qCritical() << "Unknown command received with code" << (int)frame.m_command
-                            << "and length" << frame.m_length;
+                qCDebugHot(lcFrame) << "Unknown command received with code" << (int)frame.m_command
+                                    << "and length" << frame.m_length;
+                m_unknownCommandLog.hit();
             }
         }
+
+        CTelemetry::instance()->record(CTelemetry::EStage_t::eDispatch, start_ns);
     }
-    while(m_frameQueue.length());
+}
+
+bool CSerialThread::answerStaged(const bool& ack)
+{
+    // the staged project is not connected to the answer signals yet, it
+    // gets them once the GUI has handled the end of the previous measure;
+    // a queued signal only reaches the receivers connected when it is sent
+    if (!m_stagedAnswerPending)
+        return false;
+
+    m_stagedAnswerPending = false;
+    emit received_takeMeasStaged(ack);
+    return true;
+}
+
+bool CSerialThread::sinkSample(const quint32& index, const union32_t& a,
+                               const union32_t& b, const union32_t& c)
+{
+    if (!m_sampleSink)
+        return false;
+
+    MeasSample_t sample;
+    sample.m_index = index;
+    sample.m_data[0] = a.idFl;
+    sample.m_data[1] = b.idFl;
+    sample.m_data[2] = c.idFl;
+    sample.m_data[3] = 0;
+    sample.m_received_ns = m_frameReceived_ns;
+
+    // a full queue drops the sample, it is counted by the queue itself
+    m_sampleSink->push(sample);
+    return true;
+}
+
+void CSerialThread::on_setSampleSink(const QSharedPointer<CSampleQueue>& sink)
+{
+    m_sampleSink = sink;
+}
+
+void CSerialThread::on_stageMeasure(const QSharedPointer<CSampleQueue>& sink)
+{
+    m_staging = true;
+    m_stagedSink = sink;
+}
+
+void CSerialThread::on_clearStagedMeasure()
+{
+    m_staging = false;
+    m_hasStagedMeasure = false;
+    m_stagedSink.clear();
 }
 
 void CSerialThread::on_closePort()
 {
+    // leave the device in the mode every firmware understands
+    if (ECrcMode_t::eLegacySum != m_crcMode)
+        send_setCrcMode(ECrcMode_t::eLegacySum, false);
+
+    m_badCrcCount += mp_frameDecoder->badCrcCount();
+#ifdef Q_OS_LINUX
+    if (mp_posixReader)
+    {
+        m_badCrcCount += mp_posixReader->decoder()->badCrcCount();
+        mp_posixReader->stop();
+        mp_posixReader->wait();
+        delete mp_posixReader;
+        mp_posixReader = NULL;
+    }
+#endif
+
+    if (mp_replay)
+    {
+        m_badCrcCount += mp_replay->decoder()->badCrcCount();
+        mp_replay->stop();
+        mp_replay->wait();
+        delete mp_replay;
+        mp_replay = NULL;
+    }
+
+    closeCapture();
     mp_serial->close();
+    mp_frameDecoder->reset();
+    mp_frameDecoder->setCrcMode(ECrcMode_t::eLegacySum);
+    mp_frameDecoder->disarmCrcMode();
+    m_crcMode = ECrcMode_t::eLegacySum;
+
+    m_pendingCommands.clear();
+    m_waitingCommands.clear();
+    on_clearStagedMeasure();
+    m_measureActive.store(0);
+    m_stagedAnswerPending = false;
+    if (mp_RxTimeoutTimer)
+        mp_RxTimeoutTimer->stop();
+
+    // per command latency summary
+    QHash<int, CommandStats_t> stats = commandStats();
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it)
+    {
+        const CommandStats_t& item = it.value();
+        qCDebug(lcSerial) << "Command" << it.key() << "answered" << item.m_answered
+                          << "retries" << item.m_retries << "timeouts" << item.m_timeouts
+                          << "latency us min/avg/max" << item.m_latencyMin_us
+                          << (item.m_answered ? item.m_latencySum_us / item.m_answered : 0)
+                          << item.m_latencyMax_us;
+    }
+
+    m_statsMutex.lock();
+    m_commandStats.clear();
+    m_statsMutex.unlock();
+
+    if (m_badCrcCount)
+        qCWarning(lcSerial) << "Frames dropped on bad CRC so far:" << m_badCrcCount;
+
+    m_unknownCommandLog.flush();
+
     exit(0);
 }
 
-void CSerialThread::on_rxTimeout()
+void CSerialThread::on_portLost()
 {
-    qWarning() << "Rx timeout on command" << (int)m_sentCommand;
-    emit rxTimeout((int)m_sentCommand);
+    // device unplugged under the posix reader, pending commands cannot
+    // time out any more since the reader serviced their timer
     on_closePort();
+    emit portLost();
+}
+
+void CSerialThread::on_rxTimeout()
+{
+    qint64 now = m_clock.elapsed();
+
+    for (int i = 0; i < m_pendingCommands.length(); )
+    {
+        PendingCommand_t& pending = m_pendingCommands[i];
+
+        if (pending.m_deadline_ms > now)
+        {
+            i++;
+            continue;
+        }
+
+        int command = (int)pending.m_command;
+        QMutexLocker locker(&m_statsMutex);
+
+        if (pending.m_retries < pending.m_retryLimit)
+        {
+            pending.m_retries++;
+            m_commandStats[command].m_retries++;
+            locker.unlock();
+
+            qCWarning(lcSerial) << "Rx timeout on command" << command << "retry" << pending.m_retries;
+            transmitCommand(pending);
+            i++;
+        }
+        else
+        {
+            // give up on this command only, the connection stays open
+            m_commandStats[command].m_timeouts++;
+            locker.unlock();
+
+            int retryLimit = pending.m_retryLimit;
+            m_pendingCommands.removeAt(i);
+
+            if (ESerialCommand_t::e_setCrcMode == (ESerialCommand_t)command)
+            {
+                // older firmware does not know the command, stay with the sum
+                activeDecoder()->disarmCrcMode();
+                qCWarning(lcSerial) << "SERIAL: no answer for CRC mode" << (int)m_requestedCrcMode
+                                    << "keeping" << (int)m_crcMode;
+            }
+            else
+            {
+                qCWarning(lcSerial) << "Rx timeout on command" << command << "no answer after"
+                                    << retryLimit << "retries";
+
+                if (isMeasureRequest((ESerialCommand_t)command))
+                {
+                    m_measureActive.store(0);
+                    m_stagedAnswerPending = false;
+                }
+                emit rxTimeout(command);
+            }
+
+            if (m_waitingCommands.length())
+            {
+                PendingCommand_t next = m_waitingCommands.dequeue();
+                transmitCommand(next);
+            }
+        }
+    }
+
+    scheduleRxTimeout();
 }
 
 void CSerialThread::on_send_getFirmwareID()
@@ -422,7 +947,10 @@ void CSerialThread::on_send_takeMeasEis(const quint8& amplitude,
         sendArr.append((quint8)(nrOfSteps >> (i * 8)) & 0xFF);
 
     sendArr.append((quint8)stepType);
-    sendData(ESerialCommand_t::e_takeMeasEis, sendArr, true);
+
+    // starting a measure is not idempotent and the frames carry no sequence
+    // number: a late answer could not be told from the answer to a retry
+    sendData(ESerialCommand_t::e_takeMeasEis, sendArr, true, 0);
 }
 
 void CSerialThread::on_send_takeMeasCv( const qint16& potStart,
@@ -446,7 +974,7 @@ void CSerialThread::on_send_takeMeasCv( const qint16& potStart,
     for (quint32 i = 0; i < sizeof(qint16); i++)
             sendArr.append((quint8)(scanDelay >> (i * 8)) & 0xFF);
 
-    sendData(ESerialCommand_t::e_takeMeasCv, sendArr, true);
+    sendData(ESerialCommand_t::e_takeMeasCv, sendArr, true, 0);
 }
 
 void CSerialThread::on_send_takeMeasCa( const qint16& potential,
@@ -463,7 +991,7 @@ void CSerialThread::on_send_takeMeasCa( const qint16& potential,
     for (quint32 i = 0; i < sizeof(union32_t); i++)
         sendArr.append(dt.id8[i]);
 
-    sendData(ESerialCommand_t::e_takeMeasCa, sendArr, true);
+    sendData(ESerialCommand_t::e_takeMeasCa, sendArr, true, 0);
 }
 
 void CSerialThread::on_send_takeMeasDpv( const qint16&  qp,
@@ -496,7 +1024,36 @@ void CSerialThread::on_send_takeMeasDpv( const qint16&  qp,
     for (quint32 i = 0; i < sizeof(qint16); i++)
         sendArr.append((quint8)(ps >> (i * 8)) & 0xFF);
 
-    sendData(ESerialCommand_t::e_takeMeasDpv, sendArr, true);
+    sendData(ESerialCommand_t::e_takeMeasDpv, sendArr, true, 0);
+}
+
+void CSerialThread::on_send_takeMeasSwv( const qint16&  startPot,
+                                         const qint16&  endPot,
+                                         const quint16& step,
+                                         const quint16& amplitude,
+                                         const quint16& frequency,
+                                         const quint16& quietTime)
+{
+    QByteArray sendArr;
+    for (quint32 i = 0; i < sizeof(qint16); i++)
+        sendArr.append((quint8)(startPot >> (i * 8)) & 0xFF);
+
+    for (quint32 i = 0; i < sizeof(qint16); i++)
+        sendArr.append((quint8)(endPot >> (i * 8)) & 0xFF);
+
+    for (quint32 i = 0; i < sizeof(quint16); i++)
+        sendArr.append((quint8)(step >> (i * 8)) & 0xFF);
+
+    for (quint32 i = 0; i < sizeof(quint16); i++)
+        sendArr.append((quint8)(amplitude >> (i * 8)) & 0xFF);
+
+    for (quint32 i = 0; i < sizeof(quint16); i++)
+        sendArr.append((quint8)(frequency >> (i * 8)) & 0xFF);
+
+    for (quint32 i = 0; i < sizeof(quint16); i++)
+        sendArr.append((quint8)(quietTime >> (i * 8)) & 0xFF);
+
+    sendData(ESerialCommand_t::e_takeMeasSwv, sendArr, true, 0);
 }
 
 void CSerialThread::send_endMeasEis()
@@ -523,11 +1080,99 @@ void CSerialThread::send_endMeasDpv()
     sendData(ESerialCommand_t::e_endMeasDpv, sendArr, false);
 }
 
+void CSerialThread::send_endMeasSwv()
+{
+    QByteArray sendArr;
+    sendData(ESerialCommand_t::e_endMeasSwv, sendArr, false);
+}
+
+void CSerialThread::send_setCrcMode(const ECrcMode_t& mode, const bool wantAck)
+{
+    QByteArray sendArr;
+    sendArr.append((quint8)mode);
+
+    // the request itself goes with the current check, the answer as well
+    m_requestedCrcMode = mode;
+    if (wantAck)
+    {
+        activeDecoder()->armCrcMode(mode);
+        sendData(ESerialCommand_t::e_setCrcMode, sendArr, true, 0);
+    }
+    else
+        sendData(ESerialCommand_t::e_setCrcMode, sendArr, false);
+}
+
 void CSerialThread::updateSerialPort(const QString& port)
 {
     mp_serial->setPortName(port);
 }
 
+void CSerialThread::updateSerialBackend(const ESerialBackend_t& backend)
+{
+#ifndef Q_OS_LINUX
+    if (ESerialBackend_t::ePosixEpoll == backend)
+    {
+        qCWarning(lcSerial) << "Epoll serial backend is available on Linux only";
+        return;
+    }
+#endif
+
+    m_backend = backend;
+}
+
+void CSerialThread::updateCaptureFile(const QString& fileName)
+{
+    // empty switches the capture off, takes effect with the next connection
+    m_captureFile = fileName;
+}
+
+void CSerialThread::updateReplay(const QString& fileName, const bool fast)
+{
+    m_replayFile = fileName;
+    m_replayFast = fast;
+}
+
+void CSerialThread::openCapture()
+{
+    if (m_captureFile.isEmpty())
+        return;
+
+    mp_capture = new CSerialCapture(m_captureFile);
+
+    if (!mp_capture->open())
+    {
+        delete mp_capture;
+        mp_capture = NULL;
+        return;
+    }
+
+    mp_capture->start(QThread::LowPriority);
+}
+
+void CSerialThread::closeCapture()
+{
+    if (!mp_capture)
+        return;
+
+    mp_capture->stop();
+    mp_capture->wait();
+    delete mp_capture;
+    mp_capture = NULL;
+}
+
+void CSerialThread::captureRx(const char* data, const int& length)
+{
+    // reader threads too, the capture is opened before and closed after them
+    if (mp_capture)
+        mp_capture->record(CSerialCapture::EDirection_t::eRx, data, length);
+}
+
+void CSerialThread::updateCrcMode(const ECrcMode_t& mode)
+{
+    // takes effect with the next connection, after the firmware ID
+    m_preferredCrcMode = mode;
+}
+
 
 
 
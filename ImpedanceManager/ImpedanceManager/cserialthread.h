@@ -9,11 +9,24 @@
 #include <QByteArray>
 #include <QQueue>
 #include <QTimer>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QHash>
 
 #include "MeasureUtility.h"
+#include "csamplequeue.h"
+#include "clogging.h"
 
 using namespace MeasureUtility;
 
+class CFrameDecoder;
+class CPosixSerialReader;
+class CSerialCapture;
+class CSerialReplay;
+
 class CSerialThread : public QThread
 {
     Q_OBJECT
@@ -36,10 +49,25 @@ public:
         , e_takeMeasSwv             = 0x0E
         , e_giveMeasChunkSwv        = 0x0F
         , e_endMeasSwv              = 0x10
+        , e_setCrcMode              = 0x11
         ,
 
     };
 
+    enum class ESerialBackend_t
+    {
+          eQtSerialPort             = 0 // QSerialPort + readyRead in the event loop
+        , ePosixEpoll               = 1 // Linux only, CPosixSerialReader
+        , eReplay                   = 2 // CSerialReplay, a capture file instead of the port
+    };
+
+    // frame check sum, negotiated with e_setCrcMode after the firmware ID
+    enum class ECrcMode_t
+    {
+          eLegacySum                = 0 // inverted additive sum, every firmware
+        , eCrc16Ccitt               = 1 // CRC-16-CCITT (0x1021, 0xFFFF), CCrc16
+    };
+
     typedef struct
     {
         quint8 m_syncByte;
@@ -47,17 +75,51 @@ public:
         quint32 m_length;
         QByteArray m_data;
         qint16 m_crc;
+        qint64 m_received_ns;       // CTelemetry clock, when the last byte was in
     } ESerialFrame_t;
 
+    // command waiting for its answer
+    typedef struct
+    {
+        ESerialCommand_t m_command;
+        QByteArray m_frame;         // whole frame, for retransmission
+        qint64 m_sent_us;           // last (re)transmission
+        qint64 m_deadline_ms;
+        int m_retries;
+        int m_retryLimit;
+    } PendingCommand_t;
+
+    typedef struct
+    {
+        quint32 m_answered;
+        quint32 m_retries;
+        quint32 m_timeouts;
+        qint64 m_latencyMin_us;
+        qint64 m_latencyMax_us;
+        qint64 m_latencySum_us;
+    } CommandStats_t;
+
     explicit CSerialThread(const QString& port, QObject *parent = 0);
     ~CSerialThread();
 
     void run(); // inherited
     void updateSerialPort(const QString& port);
+    void updateSerialBackend(const ESerialBackend_t& backend);
+    void updateCrcMode(const ECrcMode_t& mode);
+    void updateCaptureFile(const QString& fileName);
+    void updateReplay(const QString& fileName, const bool fast);
+    void captureRx(const char* data, const int& length);
+    quint32 badCrcCount();
+    bool isMeasureActive() const { return m_measureActive.load(); } // also after a staged one went out
+    void postFrames(QQueue<ESerialFrame_t*>& frames);
+    QHash<int, CommandStats_t> commandStats();
+
+    static const quint8 m_syncByte = '?';
 
 signals:
     void openPort(const int& val);
     void rxTimeout(const int&);
+    void portLost();
 
     // frames (IM- impredance manager, ES- embedded system):            // Sender:
     void received_getFirmwareID(const MeasureUtility::union32_t& id);   // IM
@@ -84,10 +146,24 @@ signals:
     void received_giveMeasChunkDpv(const union32_t&, const union32_t&); // ES
     void received_endMeasDpv();                                         // ES
 
+    // SWV
+    void received_takeMeasSwv(const bool& ack);                         // IM
+    void received_giveMeasChunkSwv(const union32_t&, const union32_t&,
+                                   const union32_t&);                   // ES
+    void received_endMeasSwv();                                         // ES
+
+    // answer to a request staged behind an end frame, instead of the
+    // technique's received_takeMeas* signal
+    void received_takeMeasStaged(const bool& ack);                      // IM
 
 public slots:
     void on_readyRead();
+    void on_framesReady();
     void on_closePort();
+    void on_portLost();
+    void on_setSampleSink(const QSharedPointer<CSampleQueue>& sink);
+    void on_stageMeasure(const QSharedPointer<CSampleQueue>& sink);
+    void on_clearStagedMeasure();
 
     // frames:
     void on_rxTimeout();
@@ -116,30 +192,83 @@ public slots:
                              const quint16&,
                              const qint16&);
 
+    void on_send_takeMeasSwv(const qint16&,
+                             const qint16&,
+                             const quint16&,
+                             const quint16&,
+                             const quint16&,
+                             const quint16&);
+
 private:
     qint16 getCrc(const QByteArray& bArray);
-    qint16 getCrc(const ESerialFrame_t& frame);
-    int digForFrames(QByteArray& buffer);
+    CFrameDecoder* activeDecoder();
+    qint64 writeData(const QByteArray& data);
+    void openCapture();
+    void closeCapture();
+    void transmitCommand(PendingCommand_t& pending);
+    void completeCommand(const ESerialCommand_t& command);
+    void scheduleRxTimeout();
+    void armRxTimeout(const int& interval_ms);
+    void stopRxTimeout();
     void sendData(const ESerialCommand_t& command,
                   const QByteArray& data,
-                  const bool wantAck);
+                  const bool wantAck,
+                  const int retryLimit = m_maxRetries);
     void frameReady();
+    void sendStagedMeasure();
+    static bool isMeasureRequest(const ESerialCommand_t& command);
+    bool answerStaged(const bool& ack);
+    bool sinkSample(const quint32& index, const union32_t& a,
+                    const union32_t& b, const union32_t& c);
 
     // frames
     void send_endMeasEis();
     void send_endMeasCv();
     void send_endMeasCa();
     void send_endMeasDpv();
+    void send_endMeasSwv();
+    void send_setCrcMode(const ECrcMode_t& mode, const bool wantAck);
 
     QSerialPort* mp_serial;
+    CPosixSerialReader* mp_posixReader;
+    CSerialReplay* mp_replay;
+    CSerialCapture* mp_capture;     // raw stream tee, NULL when off
+    QString m_captureFile;
+    QString m_replayFile;
+    bool m_replayFast;
+    CFrameDecoder* mp_frameDecoder;
+    ESerialBackend_t m_backend;
+    ECrcMode_t m_preferredCrcMode;  // from the settings
+    ECrcMode_t m_crcMode;           // in use for transmitted frames
+    ECrcMode_t m_requestedCrcMode;  // e_setCrcMode waiting for the answer
+    quint32 m_badCrcCount;          // of the decoders already closed
     QByteArray m_sendBuffer;
     QQueue<ESerialFrame_t*> m_frameQueue;
-    ESerialFrame_t* mp_frameStruct;
-    ESerialCommand_t m_sentCommand;
+    QMutex m_frameQueueMutex;
+    QSharedPointer<CSampleQueue> m_sampleSink; // measure chunks bypass the signals when set
+    qint64 m_frameReceived_ns;      // of the frame in dispatch, for its samples
+
+    // next measure request, encoded while the running one finishes and sent
+    // right behind its end frame (sequencer), with the sink of its project
+    QAtomicInt m_measureActive;     // request sent, end frame not seen yet; read by the GUI
+    bool m_staging;                 // next measure request is to be staged
+    bool m_hasStagedMeasure;
+    bool m_stagedAnswerPending;     // the next measure answer is the staged run's
+    PendingCommand_t m_stagedMeasure;
+    QSharedPointer<CSampleQueue> m_stagedSink;
     QTimer* mp_RxTimeoutTimer;
 
-    static const quint8 m_syncByte = '?';
+    // command pipeline, answers are matched by command code in send order
+    QList<PendingCommand_t> m_pendingCommands;  // sent, waiting for the answer
+    QQueue<PendingCommand_t> m_waitingCommands; // window full, not sent yet
+    QElapsedTimer m_clock;
+    QHash<int, CommandStats_t> m_commandStats;
+    QMutex m_statsMutex;
+    CLogThrottle m_unknownCommandLog;
+
     static const int m_rxTimeoutInterval_ms = 1000;
+    static const int m_maxRetries = 2;
+    static const int m_windowSize = 4;
 };
 
 #endif // CSERIALTHREAD_H
@@ -1,4 +1,5 @@
 #include <QMessageBox>
+#include <QFileDialog>
 #include <QDebug>
 
 #include "csettingsdialog.h"
@@ -39,17 +40,46 @@ void CSettingsDialog::initComponents()
             ui->cbSerialPort->setCurrentText(currentPort);
     }
 
+    ui->cbSerialBackend->addItem("Qt serial port",
+                                 (int)CSerialThread::ESerialBackend_t::eQtSerialPort);
+#ifdef Q_OS_LINUX
+    ui->cbSerialBackend->addItem("Linux epoll (batched reads)",
+                                 (int)CSerialThread::ESerialBackend_t::ePosixEpoll);
+#endif
+    ui->cbSerialBackend->addItem("Replay capture",
+                                 (int)CSerialThread::ESerialBackend_t::eReplay);
+
+    int backend = ui->cbSerialBackend->findData(
+                CSettingsManager::instance()->paramValue(XML_FIELD_BACKEND).toInt());
+    if (backend >= 0)
+        ui->cbSerialBackend->setCurrentIndex(backend);
+
+    ui->cbCrc16->setChecked(CSettingsManager::instance()->paramValue(XML_FIELD_CRC).toInt() ==
+                            (int)CSerialThread::ECrcMode_t::eCrc16Ccitt);
+
+    ui->leCaptureFile->setText(CSettingsManager::instance()->paramValue(XML_FIELD_CAPTURE));
+    ui->leReplayFile->setText(CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY));
+    ui->cbReplayFast->setChecked(CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY_FAST).toInt());
+
     mp_serialThread = NULL;
 }
 
 void CSettingsDialog::on_pbSerialCheck_clicked()
 {
     mp_serialThread = new CSerialThread(ui->cbSerialPort->currentText());
+    mp_serialThread->updateSerialBackend(
+                (CSerialThread::ESerialBackend_t)ui->cbSerialBackend->currentData().toInt());
+    mp_serialThread->updateReplay(ui->leReplayFile->text(), ui->cbReplayFast->isChecked());
+    mp_serialThread->updateCrcMode(ui->cbCrc16->isChecked() ?
+                                       CSerialThread::ECrcMode_t::eCrc16Ccitt :
+                                       CSerialThread::ECrcMode_t::eLegacySum);
     mp_serialThread->moveToThread(mp_serialThread);
     mp_serialThread->start();
 
     ui->pbSerialCheck->setEnabled(false);
     ui->cbSerialPort->setEnabled(false);
+    ui->cbSerialBackend->setEnabled(false);
+    ui->cbCrc16->setEnabled(false);
 
     connect(mp_serialThread, SIGNAL(openPort(const int&)),
             this, SLOT(at_mp_SerialThread_openPort(const int&)), Qt::UniqueConnection);
@@ -80,6 +110,8 @@ void CSettingsDialog::at_received_getFirmwareID(const MeasureUtility::union32_t&
 
     ui->pbSerialCheck->setEnabled(true);
     ui->cbSerialPort->setEnabled(true);
+    ui->cbSerialBackend->setEnabled(true);
+    ui->cbCrc16->setEnabled(true);
 
     emit closePort();
 }
@@ -95,6 +127,8 @@ void CSettingsDialog::at_mp_SerialThread_rxTimeout(const int& command)
 
     ui->pbSerialCheck->setEnabled(true);
     ui->cbSerialPort->setEnabled(true);
+    ui->cbSerialBackend->setEnabled(true);
+    ui->cbCrc16->setEnabled(true);
 
     emit closePort();
 }
@@ -111,6 +145,8 @@ void CSettingsDialog::at_mp_SerialThread_openPort(const int& val)
 
         ui->pbSerialCheck->setEnabled(true);
         ui->cbSerialPort->setEnabled(true);
+        ui->cbSerialBackend->setEnabled(true);
+        ui->cbCrc16->setEnabled(true);
 
         emit closePort();
     }
@@ -125,9 +161,55 @@ void CSettingsDialog::on_bbButtons_accepted()
     serialPort.m_value = ui->cbSerialPort->currentText();
     paramList.append(serialPort);
 
+    SettingParam_t serialBackend;
+    serialBackend.m_name = XML_FIELD_BACKEND;
+    serialBackend.m_value = QString("%1").arg(ui->cbSerialBackend->currentData().toInt());
+    paramList.append(serialBackend);
+
+    SettingParam_t crcMode;
+    crcMode.m_name = XML_FIELD_CRC;
+    crcMode.m_value = QString("%1").arg(ui->cbCrc16->isChecked() ?
+                                            (int)CSerialThread::ECrcMode_t::eCrc16Ccitt :
+                                            (int)CSerialThread::ECrcMode_t::eLegacySum);
+    paramList.append(crcMode);
+
+    SettingParam_t captureFile;
+    captureFile.m_name = XML_FIELD_CAPTURE;
+    captureFile.m_value = ui->leCaptureFile->text();
+    paramList.append(captureFile);
+
+    SettingParam_t replayFile;
+    replayFile.m_name = XML_FIELD_REPLAY;
+    replayFile.m_value = ui->leReplayFile->text();
+    paramList.append(replayFile);
+
+    SettingParam_t replayFast;
+    replayFast.m_name = XML_FIELD_REPLAY_FAST;
+    replayFast.m_value = QString("%1").arg((int)ui->cbReplayFast->isChecked());
+    paramList.append(replayFast);
+
     CSettingsManager::instance()->writeSettings(paramList);
 }
 
+void CSettingsDialog::on_pbCaptureFile_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Capture File"),
+                                                    ui->leCaptureFile->text(),
+                                                    tr("Capture Files (*.imc)"),
+                                                    NULL, QFileDialog::DontConfirmOverwrite);
+    if (!fileName.isEmpty())
+        ui->leCaptureFile->setText(fileName);
+}
+
+void CSettingsDialog::on_pbReplayFile_clicked()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Replay File"),
+                                                    ui->leReplayFile->text(),
+                                                    tr("Capture Files (*.imc)"));
+    if (!fileName.isEmpty())
+        ui->leReplayFile->setText(fileName);
+}
+
 
 
 
@@ -34,6 +34,8 @@ private slots:
     void at_received_getFirmwareID(const MeasureUtility::union32_t&);
 
     void on_bbButtons_accepted();
+    void on_pbCaptureFile_clicked();
+    void on_pbReplayFile_clicked();
 
 private:
     Ui::CSettingsDialog *ui;
@@ -12,6 +12,11 @@
 #include "MeasureUtility.h"
 
 #define XML_FIELD_PORT      "serial_port"
+#define XML_FIELD_BACKEND   "serial_backend"
+#define XML_FIELD_CRC       "crc_mode"
+#define XML_FIELD_CAPTURE   "capture_file"
+#define XML_FIELD_REPLAY    "replay_file"
+#define XML_FIELD_REPLAY_FAST "replay_fast"
 
 using namespace MeasureUtility;
 
@@ -0,0 +1,306 @@
+#include "csignalfilter.h"
+#include "clinalg.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+CSignalFilter::CSignalFilter()
+{
+    m_type = EFilterType_t::eNone;
+    m_window = m_minWindow;
+    m_order = 2;
+    reset();
+}
+
+int CSignalFilter::configure(const EFilterType_t type, const int window, const int order)
+{
+    if ((window < m_minWindow) || (window > m_maxWindow))
+    {
+        qWarning() << "Filter window" << window << "out of range";
+        return -1;
+    }
+
+    if ((type == EFilterType_t::eSavitzkyGolay) &&
+        ((order < 0) || (order > m_maxOrder) || (order >= window)))
+    {
+        qWarning() << "Savitzky-Golay order" << order << "does not fit window" << window;
+        return -2;
+    }
+
+    m_type = type;
+    m_window = window;
+    m_order = order;
+
+    if (m_type == EFilterType_t::eSavitzkyGolay)
+    {
+        // the centered fit needs an odd window
+        int centered = m_window | 1;
+        m_centerCoefficients.resize(centered);
+        m_lastCoefficients.resize(m_window);
+
+        if (savitzkyGolayCoefficients(centered, m_order, centered / 2, m_centerCoefficients.data()) ||
+            savitzkyGolayCoefficients(m_window, m_order, m_window - 1, m_lastCoefficients.data()))
+        {
+            m_type = EFilterType_t::eNone;
+            return -3;
+        }
+    }
+
+    reset();
+    return 0;
+}
+
+void CSignalFilter::reset()
+{
+    m_history.fill(0, 2 * m_window);
+    m_sorted.clear();
+    m_sorted.reserve(m_window);
+    m_position = 0;
+    m_count = 0;
+    m_exponential = 0;
+}
+
+double CSignalFilter::push(const double& sample)
+{
+    if (m_type == EFilterType_t::eNone)
+        return sample;
+
+    if (m_type == EFilterType_t::eExponential)
+    {
+        double alpha = 2.0 / (m_window + 1);
+        m_exponential = m_count ? m_exponential + alpha * (sample - m_exponential) : sample;
+        m_count++;
+        return m_exponential;
+    }
+
+    double oldest = m_history[m_position];
+    m_history[m_position] = sample;
+    m_history[m_position + m_window] = sample;
+    m_position = (m_position + 1) % m_window;
+
+    if (m_type == EFilterType_t::eMedian)
+    {
+        if (m_count >= m_window)
+        {
+            QVector<double>::iterator it =
+                    std::lower_bound(m_sorted.begin(), m_sorted.end(), oldest);
+            m_sorted.erase(it);
+        }
+
+        m_sorted.insert(std::upper_bound(m_sorted.begin(), m_sorted.end(), sample), sample);
+        m_count = qMin(m_count + 1, m_window);
+
+        int size = m_sorted.size();
+        if (size & 1)
+            return m_sorted[size / 2];
+        return 0.5 * (m_sorted[size / 2 - 1] + m_sorted[size / 2]);
+    }
+
+    // Savitzky-Golay, raw samples until the first window is full
+    if (m_count < m_window)
+    {
+        m_count++;
+        if (m_count < m_window)
+            return sample;
+    }
+
+    return CLinAlg::dot(m_history.constData() + m_position,
+                        m_lastCoefficients.constData(), m_window);
+}
+
+void CSignalFilter::apply(const QVector<double>& in, QVector<double>& out) const
+{
+    switch (m_type)
+    {
+    case EFilterType_t::eSavitzkyGolay:
+        applySavitzkyGolay(in, out);
+        break;
+
+    case EFilterType_t::eMedian:
+        applyMedian(in, out);
+        break;
+
+    case EFilterType_t::eExponential:
+        applyExponential(in, out);
+        break;
+
+    default:
+        out = in;
+        break;
+    }
+}
+
+void CSignalFilter::applySavitzkyGolay(const QVector<double>& in, QVector<double>& out) const
+{
+    const int n = in.size();
+    const int taps = m_centerCoefficients.size();
+    const int half = taps / 2;
+
+    if (n < taps)
+    {
+        out = in;
+        return;
+    }
+
+    out.resize(n);
+    convolve(in.constData(), n, m_centerCoefficients.constData(), taps, out.data() + half);
+
+    // edges: the fit over the first and last window, evaluated off center
+    QVector<double> c(taps);
+    for (int i = 0; i < half; i++)
+    {
+        savitzkyGolayCoefficients(taps, m_order, i, c.data());
+        out[i] = CLinAlg::dot(in.constData(), c.constData(), taps);
+
+        savitzkyGolayCoefficients(taps, m_order, taps - 1 - i, c.data());
+        out[n - 1 - i] = CLinAlg::dot(in.constData() + n - taps, c.constData(), taps);
+    }
+}
+
+void CSignalFilter::applyMedian(const QVector<double>& in, QVector<double>& out) const
+{
+    const int n = in.size();
+    const int half = m_window / 2;
+    QVector<double> window(m_window + 1);
+
+    out.resize(n);
+
+    // centered window, shortened at the edges
+    for (int i = 0; i < n; i++)
+    {
+        int begin = qMax(0, i - half);
+        int end = qMin(n, i + half + 1);
+        int size = end - begin;
+
+        std::memcpy(window.data(), in.constData() + begin, size * sizeof(double));
+        std::nth_element(window.begin(), window.begin() + size / 2, window.begin() + size);
+        out[i] = window[size / 2];
+    }
+}
+
+void CSignalFilter::applyExponential(const QVector<double>& in, QVector<double>& out) const
+{
+    const double alpha = 2.0 / (m_window + 1);
+    out.resize(in.size());
+
+    double value = in.isEmpty() ? 0 : in[0];
+    for (int i = 0; i < in.size(); i++)
+    {
+        value += alpha * (in[i] - value);
+        out[i] = value;
+    }
+}
+
+int CSignalFilter::savitzkyGolayCoefficients(const int& window, const int& order,
+                                             const int& position, double* c)
+{
+    const int terms = order + 1;
+    if ((terms > window) || (position < 0) || (position >= window))
+        return -1;
+
+    // normal matrix of the fit in t = j - position, scaled by the half width
+    // so the powers stay in range
+    const double scale = qMax(1.0, window / 2.0);
+    QVector<double> normal(terms * terms, 0.0), powers(terms);
+
+    for (int j = 0; j < window; j++)
+    {
+        double t = (j - position) / scale;
+        powers[0] = 1;
+        for (int p = 1; p < terms; p++)
+            powers[p] = powers[p - 1] * t;
+
+        for (int r = 0; r < terms; r++)
+        {
+            for (int k = 0; k <= r; k++)
+                normal[r * terms + k] += powers[r] * powers[k];
+        }
+    }
+
+    for (int r = 0; r < terms; r++)
+    {
+        for (int k = r + 1; k < terms; k++)
+            normal[r * terms + k] = normal[k * terms + r];
+    }
+
+    if (!CLinAlg::cholesky(normal.data(), terms))
+        return -2;
+
+    // value of the polynomial at t = 0 is its constant term: c_j = e0^T N^-1 phi(t_j)
+    QVector<double> e0(terms, 0.0);
+    e0[0] = 1;
+    CLinAlg::choleskySolve(normal.constData(), terms, e0.data());
+
+    for (int j = 0; j < window; j++)
+    {
+        double t = (j - position) / scale;
+        double power = 1;
+        double sum = 0;
+
+        for (int p = 0; p < terms; p++)
+        {
+            sum += e0[p] * power;
+            power *= t;
+        }
+
+        c[j] = sum;
+    }
+
+    return 0;
+}
+
+void CSignalFilter::convolve(const double* x, const int& n, const double* c,
+                             const int& taps, double* y)
+{
+    const int outputs = n - taps + 1;
+    int i = 0;
+
+#if defined(__SSE2__)
+    // four outputs per pass, two registers of two
+    for (; i + 3 < outputs; i += 4)
+    {
+        __m128d acc0 = _mm_setzero_pd();
+        __m128d acc1 = _mm_setzero_pd();
+
+        for (int k = 0; k < taps; k++)
+        {
+            __m128d coefficient = _mm_set1_pd(c[k]);
+            acc0 = _mm_add_pd(acc0, _mm_mul_pd(coefficient, _mm_loadu_pd(x + i + k)));
+            acc1 = _mm_add_pd(acc1, _mm_mul_pd(coefficient, _mm_loadu_pd(x + i + k + 2)));
+        }
+
+        _mm_storeu_pd(y + i, acc0);
+        _mm_storeu_pd(y + i + 2, acc1);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 3 < outputs; i += 4)
+    {
+        float64x2_t acc0 = vdupq_n_f64(0);
+        float64x2_t acc1 = vdupq_n_f64(0);
+
+        for (int k = 0; k < taps; k++)
+        {
+            acc0 = vfmaq_n_f64(acc0, vld1q_f64(x + i + k), c[k]);
+            acc1 = vfmaq_n_f64(acc1, vld1q_f64(x + i + k + 2), c[k]);
+        }
+
+        vst1q_f64(y + i, acc0);
+        vst1q_f64(y + i + 2, acc1);
+    }
+#endif
+
+    for (; i < outputs; i++)
+    {
+        double sum = 0;
+        for (int k = 0; k < taps; k++)
+            sum += c[k] * x[i + k];
+        y[i] = sum;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef CSIGNALFILTER_H
+#define CSIGNALFILTER_H
+
+#include <QVector>
+
+enum class EFilterType_t
+{
+    eNone           = 0,
+    eSavitzkyGolay  = 1,
+    eMedian         = 2,
+    eExponential    = 3,
+};
+
+// Smoothing of measured traces, either sample by sample while a measure runs
+// (push) or as one pass over stored data (apply).
+//
+// Savitzky-Golay: least squares polynomial of the given order over the window.
+// The batch pass evaluates it at the window center (asymmetric windows at the
+// edges), the streaming one at the newest sample, so it does not lag. The
+// convolution kernel is vectorized with SSE2 or NEON when the target has it.
+// Median: moving median, a sorted copy of the window is kept while streaming.
+// Exponential: y += alpha * (x - y), alpha = 2 / (window + 1).
+class CSignalFilter
+{
+public:
+    CSignalFilter();
+
+    int configure(const EFilterType_t type, const int window, const int order = 2);
+    void reset();
+
+    EFilterType_t type() const { return m_type; }
+    int window() const { return m_window; }
+    int order() const { return m_order; }
+
+    // streaming, returns the filtered value of the newest sample
+    double push(const double& sample);
+
+    // batch, out gets the size of in
+    void apply(const QVector<double>& in, QVector<double>& out) const;
+
+    // c[j] weights x[j] of a window, the fit is evaluated at index position
+    static int savitzkyGolayCoefficients(const int& window, const int& order,
+                                         const int& position, double* c);
+
+    // y[i] = sum_k c[k] * x[i + k], for i = 0 .. n - taps
+    static void convolve(const double* x, const int& n, const double* c,
+                         const int& taps, double* y);
+
+    static const int m_minWindow = 3;
+    static const int m_maxWindow = 101;
+    static const int m_maxOrder = 6;
+
+private:
+    void applySavitzkyGolay(const QVector<double>& in, QVector<double>& out) const;
+    void applyMedian(const QVector<double>& in, QVector<double>& out) const;
+    void applyExponential(const QVector<double>& in, QVector<double>& out) const;
+
+    EFilterType_t m_type;
+    int m_window;
+    int m_order;
+
+    QVector<double> m_centerCoefficients;   // Savitzky-Golay, batch
+    QVector<double> m_lastCoefficients;     // Savitzky-Golay, streaming
+
+    // streaming state; the history is written twice, at pos and pos + window,
+    // so the last window samples are always contiguous
+    QVector<double> m_history;
+    QVector<double> m_sorted;
+    int m_position;
+    int m_count;
+    double m_exponential;
+};
+
+#endif // CSIGNALFILTER_H
@@ -0,0 +1,424 @@
+#include "cswvproject.h"
+#include "cmeasurelimits.h"
+
+CSwvProject::CSwvProject(CSerialThread* serialThread, QWidget* parent) :
+    CGenericProject(serialThread, parent)
+{
+    Q_ASSERT(serialThread);
+
+    initPlot();
+    initFields();
+    initFilter();
+
+    mp_serialThread = serialThread;
+    updateTree();
+}
+
+CSwvProject::~CSwvProject()
+{
+
+}
+
+void CSwvProject::initPlot()
+{
+    // give the axes some labels:
+    customPlot->xAxis->setLabel("Ewe [mV]");
+    customPlot->yAxis->setLabel("I [uA]");
+
+    // difference current first, the base class handles graph(0)
+    customPlot->addGraph();
+    customPlot->graph(0)->setScatterStyle(QCPScatterStyle(QCPScatterStyle::ssCircle));
+    customPlot->graph(0)->setName("SWV difference");
+    customPlot->graph(0)->setPen(QPen(Qt::black));
+
+    mp_forwardGraph = customPlot->addGraph();
+    mp_forwardGraph->setName("SWV forward");
+    mp_forwardGraph->setPen(QPen(Qt::blue));
+
+    mp_reverseGraph = customPlot->addGraph();
+    mp_reverseGraph->setName("SWV reverse");
+    mp_reverseGraph->setPen(QPen(Qt::darkGreen));
+
+    m_upperXRange = 1500; // mV
+    m_lowerXRange = -1500;
+    m_upperYRange = 1000; // 1 mA
+    m_lowerYRange = -1000;
+
+    m_tickStepX = 1;
+    m_tickStepY = 1;
+
+    customPlot->xAxis->setTickStep(m_tickStepX);
+    customPlot->yAxis->setTickStep(m_tickStepY);
+    customPlot->xAxis->setRange(m_lowerXRange, m_upperXRange);
+    customPlot->yAxis->setRange(m_lowerYRange, m_upperYRange);
+
+    customPlot->replot();
+}
+
+void CSwvProject::initFields()
+{
+    // start potential
+    m_labelStartPot.setText("StartPot[mV]");
+    ui->glControls->addWidget(&m_labelStartPot, 0, 0);
+    m_leStartPot.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_leStartPot, 1, 0);
+
+    // end potential
+    m_labelEndPot.setText("EndPot[mV]");
+    ui->glControls->addWidget(&m_labelEndPot, 0, 1);
+    m_leEndPot.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_leEndPot, 1, 1);
+
+    // staircase step
+    m_labelStep.setText("Step[mV]");
+    ui->glControls->addWidget(&m_labelStep, 2, 0);
+    m_leStep.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_leStep, 3, 0);
+
+    // square wave amplitude
+    m_labelAmplitude.setText("Amp[mV]");
+    ui->glControls->addWidget(&m_labelAmplitude, 2, 1);
+    m_leAmplitude.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_leAmplitude, 3, 1);
+
+    // square wave frequency
+    m_labelFrequency.setText("Freq[Hz]");
+    ui->glControls->addWidget(&m_labelFrequency, 4, 0);
+    m_leFrequency.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_leFrequency, 5, 0);
+
+    // quiet time
+    m_labelQuietTime.setText("QT[s]");
+    ui->glControls->addWidget(&m_labelQuietTime, 4, 1);
+    m_leQuietTime.setMaximumWidth(m_maxItemWidth);
+    ui->glControls->addWidget(&m_leQuietTime, 5, 1);
+
+    QIntValidator* mv16Validator = new QIntValidator(-1500, 1500, this);
+    QIntValidator* mvPos16Validator = new QIntValidator(1, 500, this);
+    QIntValidator* freq16Validator = new QIntValidator(1, 5000, this);
+    QIntValidator* time16Validator = new QIntValidator(0, 10000, this);
+
+    m_leStartPot.setValidator(mv16Validator);
+    m_leEndPot.setValidator(mv16Validator);
+    m_leStep.setValidator(mvPos16Validator);
+    m_leAmplitude.setValidator(mvPos16Validator);
+    m_leFrequency.setValidator(freq16Validator);
+    m_leQuietTime.setValidator(time16Validator);
+}
+
+void CSwvProject::updateTree()
+{
+    QStringList list;
+    list << QObject::tr("Voltage[mV]") << QObject::tr("Fwd[uA]")
+         << QObject::tr("Rev[uA]") << QObject::tr("Diff[uA]");
+
+    ui->twPoints->setColumnCount(list.size());
+    ui->twPoints->setHeaderLabels(list);
+    ui->twPoints->header()->resizeSection(0, 60);
+    ui->twPoints->header()->resizeSection(1, 60);
+    ui->twPoints->header()->resizeSection(2, 60);
+    ui->twPoints->header()->resizeSection(3, 60);
+}
+
+int CSwvProject::takeMeasure()
+{
+    bool ok;
+
+    qint16 startPot = (qint16)m_leStartPot.text().toInt(&ok, 10);
+    qint16 endPot = (qint16)m_leEndPot.text().toInt(&ok, 10);
+    quint16 step = (quint16)m_leStep.text().toInt(&ok, 10);
+    quint16 amplitude = (quint16)m_leAmplitude.text().toInt(&ok, 10);
+    quint16 frequency = (quint16)m_leFrequency.text().toInt(&ok, 10);
+    quint16 quietTime = (quint16)m_leQuietTime.text().toInt(&ok, 10);
+
+    QString badParameters = CMeasureLimits::checkSwv(startPot, endPot, step, amplitude,
+                                                     frequency);
+
+    if(badParameters.length())
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Critical);
+        msgBox.setText("Empty fields detected!");
+        msgBox.setInformativeText(badParameters);
+        msgBox.exec();
+        return -1;
+    }
+
+    clearData();
+    clearCurrents();
+    qDebug() << "Sending SWV measure request";
+    emit send_takeMeasSwv(startPot, endPot, step, amplitude, frequency, quietTime);
+    return 0;
+}
+
+void CSwvProject::changeConnections(const bool con)
+{
+    if(con)
+    {
+        connect(this, SIGNAL(send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                                              const quint16&, const quint16&, const quint16&)),
+        mp_serialThread, SLOT(on_send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                                                  const quint16&, const quint16&, const quint16&)),
+                Qt::UniqueConnection);
+
+        connect(mp_serialThread, SIGNAL(received_takeMeasSwv(const bool&)),
+                this, SLOT(on_received_takeMeasSwv(const bool&)), Qt::UniqueConnection);
+
+        connect(mp_serialThread, SIGNAL(received_giveMeasChunkSwv(const union32_t&, const union32_t&,
+                                                                  const union32_t&)),
+                this, SLOT(on_received_giveMeasChunkSwv(const union32_t&, const union32_t&,
+                                                        const union32_t&)), Qt::UniqueConnection);
+
+        connect(mp_serialThread, SIGNAL(received_endMeasSwv()),
+                this, SLOT(on_received_endMeasSwv()), Qt::UniqueConnection);
+    }
+    else
+    {
+        disconnect(this, SIGNAL(send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                                                 const quint16&, const quint16&, const quint16&)),
+        mp_serialThread, SLOT(on_send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                                                  const quint16&, const quint16&, const quint16&)));
+
+        disconnect(mp_serialThread, SIGNAL(received_takeMeasSwv(const bool&)),
+                this, SLOT(on_received_takeMeasSwv(const bool&)));
+
+        disconnect(mp_serialThread, SIGNAL(received_giveMeasChunkSwv(const union32_t&, const union32_t&,
+                                                                     const union32_t&)),
+                this, SLOT(on_received_giveMeasChunkSwv(const union32_t&, const union32_t&,
+                                                        const union32_t&)));
+
+        disconnect(mp_serialThread, SIGNAL(received_endMeasSwv()),
+                this, SLOT(on_received_endMeasSwv()));
+    }
+}
+
+void CSwvProject::on_received_takeMeasSwv(const bool& ack)
+{
+    if (ack)
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Critical);
+        msgBox.setText("Measure init error!");
+        msgBox.setInformativeText("SWV measure cannot be started");
+        msgBox.exec();
+    }
+    else
+        emit measureStarted();
+}
+
+void CSwvProject::on_received_giveMeasChunkSwv(const union32_t& forward,
+                                               const union32_t& reverse,
+                                               const union32_t& voltage)
+{
+    // only without a sample sink, normally the chunks come through drainSamples
+    MeasSample_t sample;
+    sample.m_index = 0;
+    sample.m_data[0] = forward.idFl;
+    sample.m_data[1] = reverse.idFl;
+    sample.m_data[2] = voltage.idFl;
+
+    ingestSample(sample);
+    updatePlot();
+}
+
+void CSwvProject::ingestSample(const MeasSample_t& sample)
+{
+    float forward = sample.m_data[0];
+    float reverse = sample.m_data[1];
+    float voltage = sample.m_data[2];
+    float difference = forward - reverse;
+
+    m_x.append(voltage);
+    m_y.append(difference);
+    m_forward.append(forward);
+    m_reverse.append(reverse);
+
+    addSwvPoint(forward, reverse, difference, voltage);
+    customPlot->graph(0)->addData(voltage, difference);
+    mp_forwardGraph->addData(voltage, forward);
+    mp_reverseGraph->addData(voltage, reverse);
+    filterSample(voltage, difference);
+}
+
+int CSwvProject::importSamples(const CCsvReader::Table_t& table)
+{
+    // Voltage[mV],Forward[uA],Reverse[uA],Difference[uA]
+    if (table.m_columns.size() < 4)
+        return -1;
+
+    m_x = table.m_columns[0];
+    m_forward = table.m_columns[1];
+    m_reverse = table.m_columns[2];
+    m_y = table.m_columns[3];
+
+    customPlot->graph(0)->setData(m_x, m_y);
+    mp_forwardGraph->setData(m_x, m_forward);
+    mp_reverseGraph->setData(m_x, m_reverse);
+
+    QList<QTreeWidgetItem*> items;
+    for (int i = 0; i < qMin(m_x.size(), m_maxListedPoints); i++)
+        items.append(swvItem(m_forward[i], m_reverse[i], m_y[i], m_x[i]));
+    ui->twPoints->addTopLevelItems(items);
+
+    return 0;
+}
+
+void CSwvProject::on_received_endMeasSwv()
+{
+    drainSamples();
+    applyFilter();
+    insertLabels();
+    emit measureFinished();
+}
+
+void CSwvProject::clearCurrents()
+{
+    m_forward.clear();
+    m_reverse.clear();
+    mp_forwardGraph->clearData();
+    mp_reverseGraph->clearData();
+}
+
+int CSwvProject::saveToCsv(QIODevice* device)
+{
+    Q_ASSERT(device);
+
+    if ((m_x.size() != m_y.size()) || (m_x.size() != m_forward.size()) ||
+        (m_x.size() != m_reverse.size()))
+    {
+        qCritical() << "Cannot save to CSV: Different vector sizes!";
+        return -1;
+    }
+
+    QTextStream outstream(device);
+    outstream << "Voltage[mV],Forward[uA],Reverse[uA],Difference[uA]\n";
+
+    for (int i = 0; i < m_x.size(); i++)
+    {
+        outstream << QString::number(m_x[i]) << ","
+                  << QString::number(m_forward[i]) << ","
+                  << QString::number(m_reverse[i]) << ","
+                  << QString::number(m_y[i]) << "\n";
+    }
+
+    return 0;
+}
+
+int CSwvProject::saveProjectAs(QFile& file)
+{
+    qDebug() << "Saving SWV project.";
+
+    QList<SettingParam_t> paramList;
+    SettingParam_t param;
+
+    param.m_name = "measType";
+    param.m_value = QString("%1").arg((int)measureType());
+    paramList.append(param);
+
+    param.m_name = "startPot";
+    param.m_value = m_leStartPot.text();
+    paramList.append(param);
+
+    param.m_name = "endPot";
+    param.m_value = m_leEndPot.text();
+    paramList.append(param);
+
+    param.m_name = "step";
+    param.m_value = m_leStep.text();
+    paramList.append(param);
+
+    param.m_name = "amplitude";
+    param.m_value = m_leAmplitude.text();
+    paramList.append(param);
+
+    param.m_name = "frequency";
+    param.m_value = m_leFrequency.text();
+    paramList.append(param);
+
+    param.m_name = "quietTime";
+    param.m_value = m_leQuietTime.text();
+    paramList.append(param);
+
+    CProjectManager projMan(file, paramList, true);
+    return 0;
+}
+
+int CSwvProject::openProject(QFile& file)
+{
+    qDebug() << "Reading SWV project.";
+
+    QList<SettingParam_t> paramList;
+    CProjectManager projMan(file, paramList, false);
+
+    if (paramList.size() < 6)
+    {
+        qCritical() << "SWV project" << file.fileName() << "is missing fields";
+        return -1;
+    }
+
+    // update fields
+    m_leStartPot.setText(paramList.takeFirst().m_value);
+    m_leEndPot.setText(paramList.takeFirst().m_value);
+    m_leStep.setText(paramList.takeFirst().m_value);
+    m_leAmplitude.setText(paramList.takeFirst().m_value);
+    m_leFrequency.setText(paramList.takeFirst().m_value);
+    m_leQuietTime.setText(paramList.takeFirst().m_value);
+
+    return 0;
+}
+
+int CSwvProject::insertLabels()
+{
+    if (m_x.size() != m_y.size())
+    {
+        qCritical() << "Cannot insert labels: Different vector x, y sizes!";
+        return -1;
+    }
+
+    QFont font("Courier", 12);
+    for (int i = 0; i < m_x.size(); i++)
+    {
+        QCPItemText *textLabel = new QCPItemText(customPlot);
+        customPlot->addItem(textLabel);
+        textLabel->setPositionAlignment(Qt::AlignBottom|Qt::AlignHCenter);
+        textLabel->position->setType(QCPItemPosition::ptPlotCoords);
+        textLabel->position->setCoords(m_x[i], m_y[i]); // place position at center/top of axis rect
+
+        textLabel->setFont(font);
+        textLabel->setTextAlignment(Qt::AlignLeft);
+        textLabel->setText(QString("U=%1mV\nIf=%2uA\nIr=%3uA\ndI=%4uA")
+                           .arg(QString::number(m_x[i], 'e', 2))
+                           .arg(QString::number(m_forward[i], 'e', 2))
+                           .arg(QString::number(m_reverse[i], 'e', 2))
+                           .arg(QString::number(m_y[i], 'e', 2)));
+
+        textLabel->setPen(QPen(Qt::black));
+        textLabel->setBrush(QBrush(Qt::yellow));
+
+        textLabel->setVisible(m_labelsVisible);
+        m_pointLabels.append(textLabel);
+    }
+
+    customPlot->replot();
+    return 0;
+}
+
+void CSwvProject::addSwvPoint(const float& forward, const float& reverse,
+                              const float& difference, const float& voltage)
+{
+    ui->twPoints->addTopLevelItem(swvItem(forward, reverse, difference, voltage));
+    ui->twPoints->scrollToBottom();
+}
+
+QTreeWidgetItem* CSwvProject::swvItem(const float& forward, const float& reverse,
+                                      const float& difference, const float& voltage)
+{
+    QTreeWidgetItem* item = new QTreeWidgetItem();
+
+    item->setText(0, QString::number(voltage, 'e', 2));
+    item->setText(1, QString::number(forward, 'e', 2));
+    item->setText(2, QString::number(reverse, 'e', 2));
+    item->setText(3, QString::number(difference, 'e', 2));
+
+    return item;
+}
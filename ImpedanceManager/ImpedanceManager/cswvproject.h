@@ -0,0 +1,73 @@
+#ifndef CSWVPROJECT_H
+#define CSWVPROJECT_H
+
+#include "cgenericproject.h"
+
+class CSwvProject : public CGenericProject
+{
+    Q_OBJECT
+
+public:
+    CSwvProject(CSerialThread* serialThread, QWidget *parent = 0);
+    ~CSwvProject();
+
+    virtual EMeasures_t measureType(){ return EMeasures_t::eSWV; }
+    virtual int takeMeasure();
+    virtual void changeConnections(const bool);
+    virtual int saveToCsv(QIODevice* device);
+    virtual int saveProjectAs(QFile& file);
+    virtual int openProject(QFile& file);
+
+signals:
+    void send_takeMeasSwv(const qint16&, const qint16&, const quint16&,
+                          const quint16&, const quint16&, const quint16&);
+
+private slots:
+    void on_received_takeMeasSwv(const bool&);
+    void on_received_giveMeasChunkSwv(const union32_t& forward, const union32_t& reverse,
+                                      const union32_t& voltage);
+    void on_received_endMeasSwv();
+
+protected:
+    virtual void ingestSample(const MeasSample_t& sample);
+    virtual int importSamples(const CCsvReader::Table_t& table);
+
+private:
+    virtual void initPlot();
+    virtual void initFields();
+    virtual void updateTree();
+
+    virtual int insertLabels();
+
+    static QTreeWidgetItem* swvItem(const float& forward, const float& reverse,
+                                    const float& difference, const float& voltage);
+    void addSwvPoint(const float& forward, const float& reverse,
+                     const float& difference, const float& voltage);
+    void clearCurrents();
+
+    QLabel m_labelStartPot;
+    QLineEdit m_leStartPot;
+
+    QLabel m_labelEndPot;
+    QLineEdit m_leEndPot;
+
+    QLabel m_labelStep;
+    QLineEdit m_leStep;
+
+    QLabel m_labelAmplitude;
+    QLineEdit m_leAmplitude;
+
+    QLabel m_labelFrequency;
+    QLineEdit m_leFrequency;
+
+    QLabel m_labelQuietTime;
+    QLineEdit m_leQuietTime;
+
+    // m_x potential, m_y difference current, the two sampled currents aside
+    QVector<double> m_forward;
+    QVector<double> m_reverse;
+    QCPGraph* mp_forwardGraph;
+    QCPGraph* mp_reverseGraph;
+};
+
+#endif // CSWVPROJECT_H
@@ -0,0 +1,146 @@
+#include "ctelemetry.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+CTelemetry* CTelemetry::mp_telemetry = 0;
+
+CTelemetry::CTelemetry()
+{
+    m_clock.start();
+    reset();
+}
+
+CTelemetry* CTelemetry::instance()
+{
+    if (!mp_telemetry)
+        mp_telemetry = new CTelemetry();
+
+    return mp_telemetry;
+}
+
+void CTelemetry::record(const EStage_t& stage, const qint64& start_ns)
+{
+    m_stages[(int)stage].record(now() - start_ns);
+}
+
+void CTelemetry::count(const ECounter_t& counter, const quint64& n)
+{
+    m_counters[(int)counter].fetchAndAddRelaxed(n);
+}
+
+const CHdrHistogram& CTelemetry::histogram(const EStage_t& stage) const
+{
+    return m_stages[(int)stage];
+}
+
+quint64 CTelemetry::counter(const ECounter_t& counter) const
+{
+    return m_counters[(int)counter].load();
+}
+
+qint64 CTelemetry::uptime_ns() const
+{
+    return now() - m_reset_ns.load();
+}
+
+void CTelemetry::reset()
+{
+    for (int i = 0; i < (int)EStage_t::eStageCount; i++)
+        m_stages[i].reset();
+
+    for (int i = 0; i < (int)ECounter_t::eCounterCount; i++)
+        m_counters[i].store(0);
+
+    m_reset_ns.store(now());
+}
+
+QString CTelemetry::stageName(const EStage_t& stage)
+{
+    switch (stage)
+    {
+        case EStage_t::eRead:       return "read";
+        case EStage_t::eDecode:     return "decode";
+        case EStage_t::eDispatch:   return "dispatch";
+        case EStage_t::eAppend:     return "append";
+        case EStage_t::eReplot:     return "replot";
+        case EStage_t::eEndToEnd:   return "end_to_end";
+        default:                    return "";
+    }
+}
+
+QString CTelemetry::counterName(const ECounter_t& counter)
+{
+    switch (counter)
+    {
+        case ECounter_t::eBytes:        return "bytes";
+        case ECounter_t::eFrames:       return "frames";
+        case ECounter_t::eCrcErrors:    return "crc_errors";
+        case ECounter_t::eSamples:      return "samples";
+        case ECounter_t::eReplots:      return "replots";
+        default:                        return "";
+    }
+}
+
+int CTelemetry::writeJson(const QString& fileName) const
+{
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    double uptime_s = uptime_ns() / 1e9;
+    QJsonObject root;
+    QJsonObject stages;
+    QJsonObject counters;
+
+    for (int i = 0; i < (int)EStage_t::eStageCount; i++)
+    {
+        const CHdrHistogram& hist = m_stages[i];
+        QJsonObject stage;
+        QJsonObject percentiles;
+        QJsonArray buckets;
+
+        stage["count"] = (double)hist.count();
+        stage["min_ns"] = (double)hist.min();
+        stage["max_ns"] = (double)hist.max();
+        stage["mean_ns"] = hist.mean();
+
+        for (const double& q : quantiles)
+            percentiles[QString("p%1").arg(q * 100)] = (double)hist.percentile(q);
+        stage["percentiles_ns"] = percentiles;
+
+        // only the filled buckets, as [lower bound ns, count]
+        for (int b = 0; b < CHdrHistogram::m_bucketCount; b++)
+        {
+            if (hist.bucket(b))
+                buckets.append(QJsonArray() << (double)CHdrHistogram::bucketValue(b)
+                                            << (double)hist.bucket(b));
+        }
+        stage["buckets"] = buckets;
+
+        stages[stageName((EStage_t)i)] = stage;
+    }
+
+    for (int i = 0; i < (int)ECounter_t::eCounterCount; i++)
+    {
+        QJsonObject value;
+        value["total"] = (double)m_counters[i].load();
+        value["per_second"] = (uptime_s > 0) ? m_counters[i].load() / uptime_s : 0;
+        counters[counterName((ECounter_t)i)] = value;
+    }
+
+    root["uptime_s"] = uptime_s;
+    root["stages"] = stages;
+    root["counters"] = counters;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Cannot write telemetry to" << fileName << file.errorString();
+        return -1;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+    file.close();
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef CTELEMETRY_H
+#define CTELEMETRY_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+
+#include "chdrhistogram.h"
+
+// Timing of the acquisition pipeline, from the bytes read off the port to the
+// replot that shows them. Every stage keeps a latency histogram in ns, the
+// counters give the throughput. Written from the serial, reader and GUI
+// threads without locks, read by the diagnostics dialog and dumped as JSON
+// when the program ends.
+class CTelemetry
+{
+public:
+    enum class EStage_t
+    {
+          eRead                     = 0 // one read of the port
+        , eDecode                   = 1 // framing and CRC of one read
+        , eDispatch                 = 2 // one frame in the serial thread
+        , eAppend                   = 3 // one drained batch into the plot data
+        , eReplot                   = 4
+        , eEndToEnd                 = 5 // frame complete to its sample on screen
+        , eStageCount
+    };
+
+    enum class ECounter_t
+    {
+          eBytes                    = 0
+        , eFrames                   = 1
+        , eCrcErrors                = 2
+        , eSamples                  = 3
+        , eReplots                  = 4
+        , eCounterCount
+    };
+
+    static CTelemetry* instance();
+
+    // monotonic, shared by all threads
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    // stage took from start_ns until now
+    void record(const EStage_t& stage, const qint64& start_ns);
+    void count(const ECounter_t& counter, const quint64& n = 1);
+
+    const CHdrHistogram& histogram(const EStage_t& stage) const;
+    quint64 counter(const ECounter_t& counter) const;
+    qint64 uptime_ns() const;
+    void reset();
+
+    static QString stageName(const EStage_t& stage);
+    static QString counterName(const ECounter_t& counter);
+
+    int writeJson(const QString& fileName) const;
+
+private:
+    CTelemetry();
+    static CTelemetry* mp_telemetry;
+
+    QElapsedTimer m_clock;
+    QAtomicInteger<qint64> m_reset_ns;  // start of the current statistics
+    CHdrHistogram m_stages[(int)EStage_t::eStageCount];
+    QAtomicInteger<quint64> m_counters[(int)ECounter_t::eCounterCount];
+};
+
+#endif // CTELEMETRY_H
@@ -1,10 +1,160 @@
 #include "mainwindow.h"
+#include "cheadlessrunner.h"
+#include "ctelemetry.h"
+#include "cbatchanalyzer.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
 #include <QString>
 #include <QFile>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QTextStream>
+
+// pipeline statistics of the whole session, next to the executable
+static void dumpTelemetry()
+{
+    CTelemetry::instance()->writeJson(QCoreApplication::applicationDirPath() + "/telemetry.json");
+}
+
+// ImpedanceManager --headless project.imp [-o out.ims] [--port p] [--timeout s]
+//                  [--max-crc-rate r]
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs the measure of a project without GUI.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("project", "Project file (.imp) to run.");
+    parser.addOption(QCommandLineOption("headless", "Run without GUI."));
+    parser.addOption(QCommandLineOption(QStringList() << "o" << "output",
+                                        "Sample file, <project>.ims by default.", "file"));
+    parser.addOption(QCommandLineOption("port", "Serial port instead of the configured one.",
+                                        "port"));
+    parser.addOption(QCommandLineOption("timeout", "Give up after this many seconds.",
+                                        "seconds", "0"));
+    parser.addOption(QCommandLineOption("max-crc-rate",
+                                        "Highest accepted share of frames failing the check.",
+                                        "rate", "0.01"));
+    parser.process(a);
+
+    if (parser.positionalArguments().isEmpty())
+    {
+        qCritical() << "No project file given";
+        return (int)CHeadlessRunner::EExitCode_t::eError;
+    }
+
+    QString projectFile = parser.positionalArguments().first();
+    if (!QFile::exists(projectFile))
+    {
+        qCritical() << "File " + projectFile + " doesnt exist";
+        return (int)CHeadlessRunner::EExitCode_t::eError;
+    }
+
+    QString outputFile = parser.value("output");
+    if (outputFile.isEmpty())
+    {
+        QFileInfo fi(projectFile);
+        outputFile = fi.absolutePath() + "/" + fi.completeBaseName() + ".ims";
+    }
+
+    CHeadlessRunner runner(projectFile, outputFile);
+    runner.setPort(parser.value("port"));
+    runner.setTimeout(parser.value("timeout").toInt());
+    runner.setMaxCrcRate(parser.value("max-crc-rate").toDouble());
+
+    QObject::connect(&runner, &CHeadlessRunner::finished, &a, &QCoreApplication::exit,
+                     Qt::QueuedConnection);
+
+    int ret = runner.start();
+    if (ret)
+        return ret;
+
+    ret = a.exec();
+    dumpTelemetry();
+    return ret;
+}
+
+// ImpedanceManager --batch directory [-o results.csv] [--recursive] [--circuit c]
+static int runBatch(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Analyzes every exported measurement of a directory.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("directory", "Directory with the CSV files.");
+    parser.addOption(QCommandLineOption("batch", "Run the batch analysis without GUI."));
+    parser.addOption(QCommandLineOption(QStringList() << "o" << "output",
+                                        "Results table, <directory>/batch_results.csv by default.",
+                                        "file"));
+    parser.addOption(QCommandLineOption(QStringList() << "r" << "recursive",
+                                        "Include the subdirectories."));
+    parser.addOption(QCommandLineOption("circuit", "Equivalent circuit of the EIS fits.",
+                                        "circuit", CBatchAnalyzer::m_defaultCircuit));
+    parser.process(a);
+
+    if (parser.positionalArguments().isEmpty())
+    {
+        qCritical() << "No directory given";
+        return 1;
+    }
+
+    QString directory = parser.positionalArguments().first();
+    if (!QDir(directory).exists())
+    {
+        qCritical() << "Directory " + directory + " doesnt exist";
+        return 1;
+    }
+
+    QString outputFile = parser.value("output");
+    if (outputFile.isEmpty())
+        outputFile = QDir(directory).filePath("batch_results.csv");
+
+    QStringList files = CBatchAnalyzer::findFiles(directory, parser.isSet("recursive"));
+    files.removeAll(QFileInfo(outputFile).absoluteFilePath()); // a previous run's table
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<CBatchAnalyzer::Result_t> results =
+            CBatchAnalyzer::analyze(files, parser.value("circuit"));
+
+    int failed = 0;
+    for (const CBatchAnalyzer::Result_t& result : results)
+    {
+        if (!result.m_status.isEmpty())
+            failed++;
+    }
+
+    if (CBatchAnalyzer::writeTable(outputFile, results))
+        return 1;
+
+    // the result of a command line run, debug output is off in release builds
+    QTextStream(stdout) << "Batch: " << files.size() << " files in " << timer.elapsed()
+                        << " ms on " << QThreadPool::globalInstance()->maxThreadCount()
+                        << " threads, " << failed << " with a status, table " << outputFile
+                        << endl;
+
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    // the clock starts before any thread takes timestamps
+    CTelemetry::instance();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (QString(argv[i]) == "--headless")
+            return runHeadless(argc, argv);
+        if (QString(argv[i]) == "--batch")
+            return runBatch(argc, argv);
+    }
+
     QApplication a(argc, argv);
     QString fileToOpen = NULL;
 
@@ -31,5 +181,7 @@ int main(int argc, char *argv[])
     MainWindow w(fileToOpen, 0);
     w.show();
 
-    return a.exec();
+    int ret = a.exec();
+    dumpTelemetry();
+    return ret;
 }
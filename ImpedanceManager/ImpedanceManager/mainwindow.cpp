@@ -25,6 +25,20 @@ MainWindow::MainWindow(const QString& fileToOpen, QWidget *parent) :
 
     connect(mp_serialThread, SIGNAL(rxTimeout(const int&)),
             this, SLOT(at_mp_SerialThread_rxTimeout(const int&)), Qt::UniqueConnection);
+    connect(mp_serialThread, SIGNAL(portLost()),
+            this, SLOT(at_mp_SerialThread_portLost()), Qt::UniqueConnection);
+
+    connect(this, SIGNAL(setSampleSink(const QSharedPointer<CSampleQueue>&)),
+            mp_serialThread, SLOT(on_setSampleSink(const QSharedPointer<CSampleQueue>&)),
+            Qt::UniqueConnection);
+
+    connect(this, SIGNAL(stageMeasure(const QSharedPointer<CSampleQueue>&)),
+            mp_serialThread, SLOT(on_stageMeasure(const QSharedPointer<CSampleQueue>&)),
+            Qt::UniqueConnection);
+    connect(this, SIGNAL(clearStagedMeasure()),
+            mp_serialThread, SLOT(on_clearStagedMeasure()), Qt::UniqueConnection);
+    connect(mp_serialThread, SIGNAL(received_takeMeasStaged(const bool&)),
+            this, SLOT(at_received_takeMeasStaged(const bool&)), Qt::UniqueConnection);
 
     this->setWindowState(Qt::WindowMaximized);
 
@@ -59,10 +73,12 @@ void MainWindow::initComponents()
     qRegisterMetaType< MeasureUtility::union32_t >("MeasureUtility::union32_t");
     qRegisterMetaType< union32_t >("union32_t");
     qRegisterMetaType< MeasureUtility::EStepType_t >("MeasureUtility::EStepType_t");
+    qRegisterMetaType< QSharedPointer<CSampleQueue> >("QSharedPointer<CSampleQueue>");
+    qRegisterMetaType< QVector<double> >("QVector<double>");
 
     m_appVersion.ver8[2] = 1;         // Big new functionalities
-    m_appVersion.ver8[1] = 5;         // new functionalities
-    m_appVersion.ver8[0] = 1;         // changes to existing functionalities
+    m_appVersion.ver8[1] = 6;         // new functionalities
+    m_appVersion.ver8[0] = 0;         // changes to existing functionalities
     setWindowTitle(APPNAME + getAppVersion());
 
     QString settingsFile = QApplication::applicationDirPath() + "/settings.xms";
@@ -70,10 +86,22 @@ void MainWindow::initComponents()
     setMachineState(EMachineState_t::eDisconnected);
 
     mp_serialThread = new CSerialThread(CSettingsManager::instance()->paramValue(XML_FIELD_PORT));
+    mp_serialThread->updateSerialBackend((CSerialThread::ESerialBackend_t)
+            CSettingsManager::instance()->paramValue(XML_FIELD_BACKEND).toInt());
+    mp_serialThread->updateCrcMode((CSerialThread::ECrcMode_t)
+            CSettingsManager::instance()->paramValue(XML_FIELD_CRC).toInt());
+    mp_serialThread->updateCaptureFile(CSettingsManager::instance()->paramValue(XML_FIELD_CAPTURE));
+    mp_serialThread->updateReplay(CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY),
+            CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY_FAST).toInt());
     mp_serialThread->moveToThread(mp_serialThread);
 
-    checkCurrentTab(-1);
     mp_dummyProject = NULL;
+    mp_sessionProject = NULL;
+    mp_stagedProject = NULL;
+    mp_diagnosticsDialog = NULL;
+    mp_compareDialog = NULL;
+    mp_batchDialog = NULL;
+    checkCurrentTab(-1);
 }
 
 CGenericProject* MainWindow::currentMeasObject(const int& index)
@@ -112,6 +140,7 @@ void MainWindow::setMachineState(EMachineState_t state)
             ui->action_Connect->setIcon(iconDisconnected);
             ui->action_Connect->setToolTip(QString("Connect to %1").arg(port));
             ui->action_Start_measure->setEnabled(false);
+            ui->action_Run_sequence->setEnabled(false);
             ui->action_Pause_measure->setEnabled(false);
             ui->action_Cancel_measure->setEnabled(false);
             ui->statusBar->showMessage(QString("Disconnected from %1").arg(port), 5000);
@@ -124,6 +153,7 @@ void MainWindow::setMachineState(EMachineState_t state)
             ui->action_Connect->setIcon(iconConnected);
             ui->action_Connect->setToolTip(QString("Disconnect from %1").arg(port));
             ui->action_Start_measure->setEnabled(true);
+            ui->action_Run_sequence->setEnabled(true);
             ui->action_Pause_measure->setEnabled(false);
             ui->action_Cancel_measure->setEnabled(false);
             break;
@@ -135,6 +165,7 @@ void MainWindow::setMachineState(EMachineState_t state)
             ui->action_Connect->setIcon(iconDisconnected);
             ui->action_Connect->setToolTip(QString("Connecting to %1...").arg(port));
             ui->action_Start_measure->setEnabled(false);
+            ui->action_Run_sequence->setEnabled(false);
             ui->action_Pause_measure->setEnabled(false);
             ui->action_Cancel_measure->setEnabled(false);
             ui->statusBar->showMessage(QString("Connecting to %1...").arg(port), 5000);
@@ -147,6 +178,7 @@ void MainWindow::setMachineState(EMachineState_t state)
             ui->action_Connect->setIcon(iconConnected);
             ui->action_Connect->setToolTip(QString("Disconnect from %1").arg(port));
             ui->action_Start_measure->setEnabled(false);
+            ui->action_Run_sequence->setEnabled(false);
             ui->action_Pause_measure->setEnabled(true);
             ui->action_Cancel_measure->setEnabled(true);
             break;
@@ -175,6 +207,13 @@ void MainWindow::on_action_Settings_triggered()
 
     QString port = CSettingsManager::instance()->paramValue(XML_FIELD_PORT);
     mp_serialThread->updateSerialPort(port);
+    mp_serialThread->updateSerialBackend((CSerialThread::ESerialBackend_t)
+            CSettingsManager::instance()->paramValue(XML_FIELD_BACKEND).toInt());
+    mp_serialThread->updateCrcMode((CSerialThread::ECrcMode_t)
+            CSettingsManager::instance()->paramValue(XML_FIELD_CRC).toInt());
+    mp_serialThread->updateCaptureFile(CSettingsManager::instance()->paramValue(XML_FIELD_CAPTURE));
+    mp_serialThread->updateReplay(CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY),
+            CSettingsManager::instance()->paramValue(XML_FIELD_REPLAY_FAST).toInt());
     ui->action_Connect->setToolTip(QString("Connect to %1").arg(port));
 }
 
@@ -218,6 +257,13 @@ void MainWindow::on_action_New_triggered()
                 break;
             }
 
+            case EMeasures_t::eSWV:
+            {
+                measIntstance = new CSwvProject(mp_serialThread);
+                ui->tbMain->addTab(measIntstance, "Untitled* (SWV)");
+                break;
+            }
+
             default:
             {
                 qWarning() << "Choosen unknown measure method, forgot to add?";
@@ -239,6 +285,25 @@ void MainWindow::on_tbMain_tabCloseRequested(int index)
 {
     qDebug() << "Close request " << index;
 
+    // the rest of the run and its end frame would go to whatever tab is
+    // current, nothing would ever finish the measure
+    if ((ui->tbMain->widget(index) == mp_sessionProject) &&
+        ((EMachineState_t::eMeasuring == machineState()) || mp_serialThread->isMeasureActive()))
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Warning);
+        msgBox.setText("Measure in progress!");
+        msgBox.setInformativeText("The tab can be closed once the measure has finished.");
+        msgBox.exec();
+        return;
+    }
+
+    if (ui->tbMain->widget(index) == mp_sessionProject)
+        setSessionProject(NULL);
+
+    if (ui->tbMain->widget(index) == mp_stagedProject)
+        stopSequence();
+
     disconnect(currentMeasObject(index), SIGNAL(measureStarted()),
             this, SLOT(at_measureStarted()));
     disconnect(currentMeasObject(index), SIGNAL(measureFinished()),
@@ -271,9 +336,10 @@ void MainWindow::on_action_Connect_triggered()
     }
     else
     {
+        stopSequence();
         emit closeSerialThread();
         setMachineState(EMachineState_t::eDisconnected);
-
+        setSessionProject(NULL);
     }
 }
 
@@ -288,19 +354,81 @@ void MainWindow::at_measureStarted()
 {
     qDebug() << "measure started!";
     setMachineState(EMachineState_t::eMeasuring);
-    // ustawic aktywnego taba do pomiarow albo zablokowac funkcje zmieniajaca connecty
+
+    // next run of a sequence is prepared while this one is measuring
+    stageSequenceRun();
 }
 
 void MainWindow::at_measureFinished()
 {
     qDebug() << "measure finished!";
     setMachineState(EMachineState_t::eConnected);
-    // Odblokowac zmienianie connectow od tabow
+
+    if (mp_stagedProject)
+    {
+        // its request went out behind the end frame, the stream is its own
+        // already; the serial thread switched the sample sink with it
+        CGenericProject* project = mp_stagedProject;
+        mp_stagedProject = NULL;
+        m_sequencer.advance();
+        setSessionProject(project);
+
+        ui->statusBar->showMessage(QString("Sequence run %1 of %2")
+                                   .arg(m_sequencer.currentIndex() + 1)
+                                   .arg(m_sequencer.runCount()), 5000);
+        return;
+    }
+
+    if (m_sequencer.isRunning())
+    {
+        m_sequencer.stop();
+        ui->statusBar->showMessage("Sequence finished", 5000);
+    }
+
+    // session is over, data routing follows the visible tab again
+    setSessionProject(NULL);
+}
+
+void MainWindow::at_received_takeMeasStaged(const bool& ack)
+{
+    // comes after the end of the previous run, at_measureFinished made the
+    // staged project the session one; its own answer slot never sees this
+    if (ack)
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Critical);
+        msgBox.setText("Sequence stopped!");
+        msgBox.setInformativeText(QString("Run %1 of %2 cannot be started")
+                                  .arg(m_sequencer.currentIndex() + 1)
+                                  .arg(m_sequencer.runCount()));
+        msgBox.exec();
+
+        stopSequence();
+        setMachineState(EMachineState_t::eConnected);
+        setSessionProject(NULL);
+        return;
+    }
+
+    at_measureStarted();
 }
 
 void MainWindow::at_mp_SerialThread_rxTimeout(const int& command)
 {
-    setMachineState(EMachineState_t::eDisconnected);
+    // the serial thread gave up on this command only, the port stays open
+    // unless the device did not even answer the firmware query
+    stopSequence();
+
+    if (EMachineState_t::eConnecting == machineState())
+    {
+        emit closeSerialThread();
+        setMachineState(EMachineState_t::eDisconnected);
+        setSessionProject(NULL);
+    }
+    else if (EMachineState_t::eConnected == machineState())
+    {
+        // measure request not answered, nothing is running
+        setSessionProject(NULL);
+    }
 
     QMessageBox msgBox;
     msgBox.setIcon(QMessageBox::Critical);
@@ -311,6 +439,21 @@ void MainWindow::at_mp_SerialThread_rxTimeout(const int& command)
     msgBox.exec();
 }
 
+void MainWindow::at_mp_SerialThread_portLost()
+{
+    // the serial thread closed the port already
+    stopSequence();
+    setMachineState(EMachineState_t::eDisconnected);
+    setSessionProject(NULL);
+
+    QMessageBox msgBox;
+    msgBox.setIcon(QMessageBox::Critical);
+    msgBox.setText(QString("Port %1 lost")
+                   .arg(CSettingsManager::instance()->paramValue(XML_FIELD_PORT)));
+    msgBox.setInformativeText(QString("Serial port hung up, the connection is closed."));
+    msgBox.exec();
+}
+
 void MainWindow::at_mp_SerialThread_openPort(const int& val)
 {
     if (val)
@@ -334,13 +477,107 @@ void MainWindow::on_action_Start_measure_triggered()
 {
     if (machineState() == EMachineState_t::eConnected)
     {
-        if((int)currentMeasObject(ui->tbMain->currentIndex())->measureType())
+        CGenericProject* project = currentMeasObject(ui->tbMain->currentIndex());
+
+        if((int)project->measureType())
         {
-            currentMeasObject(ui->tbMain->currentIndex())->takeMeasure();
+            stopSequence();
+
+            // bind the serial stream to this project before the request goes out
+            setSessionProject(project);
+            project->takeMeasure();
         }
     }
 }
 
+void MainWindow::on_action_Run_sequence_triggered()
+{
+    if (machineState() != EMachineState_t::eConnected)
+        return;
+
+    CSequenceDialog sequenceDial(this);
+    if (!sequenceDial.exec())
+        return;
+
+    m_sequencer.start(sequenceDial.steps());
+    if (!m_sequencer.isRunning())
+        return;
+
+    CGenericProject* project = openSequenceRun(m_sequencer.current());
+    if (!project)
+    {
+        m_sequencer.stop();
+        return;
+    }
+
+    setSessionProject(project);
+    if (project->takeMeasure())
+    {
+        m_sequencer.stop();
+        setSessionProject(NULL);
+    }
+}
+
+CGenericProject* MainWindow::openSequenceRun(const CSequencer::Run_t& run)
+{
+    CGenericProject* project = openProject(run.m_file);
+
+    if (!project)
+    {
+        QMessageBox msgBox;
+        msgBox.setIcon(QMessageBox::Critical);
+        msgBox.setText("Sequence stopped!");
+        msgBox.setInformativeText(QString("Cannot open project %1").arg(run.m_file));
+        msgBox.exec();
+        return NULL;
+    }
+
+    ui->tbMain->setTabText(ui->tbMain->indexOf(project), CSequencer::runTitle(run));
+    return project;
+}
+
+void MainWindow::stageSequenceRun()
+{
+    if (!m_sequencer.hasNext() || mp_stagedProject)
+        return;
+
+    CGenericProject* project = openSequenceRun(m_sequencer.next());
+    if (!project)
+    {
+        // the running measure is the last one
+        m_sequencer.stop();
+        return;
+    }
+
+    // the request is encoded now and held by the serial thread, only its
+    // send signal is connected; its answer comes as received_takeMeasStaged,
+    // the chunks through its queue and the end once it is the session one
+    emit stageMeasure(project->sampleQueue());
+    project->connectRequests(true);
+    int ret = project->takeMeasure();
+    project->connectRequests(false);
+
+    if (ret)
+    {
+        emit clearStagedMeasure();
+        m_sequencer.stop();
+        return;
+    }
+
+    mp_stagedProject = project;
+}
+
+void MainWindow::stopSequence()
+{
+    if (mp_stagedProject)
+    {
+        emit clearStagedMeasure();
+        mp_stagedProject = NULL;
+    }
+
+    m_sequencer.stop();
+}
+
 void MainWindow::on_action_Zoom_out_triggered()
 {
     if((int)currentMeasObject(ui->tbMain->currentIndex())->measureType())
@@ -531,6 +768,63 @@ int MainWindow::saveProject(const QString& fileName)
     return -3;
 }
 
+void MainWindow::on_action_Import_CSV_triggered()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Import CSV File"),
+                                                    QDir::currentPath(),
+                                                    tr("CSV Files (*.csv)"));
+    if (fileName.isEmpty())
+        return;
+
+    CCsvReader::Table_t table;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    int result = CCsvReader::read(fileName, table);
+    EMeasures_t measure = CCsvReader::measureOf(table.m_header);
+    QApplication::restoreOverrideCursor();
+
+    if (result || (EMeasures_t::eDummy == measure))
+    {
+        QMessageBox::warning(this, tr("Impedance Manager"),
+                             tr("%1 is not a measurement exported to CSV.").arg(fileName));
+        return;
+    }
+
+    // no working file, saving must not overwrite the CSV with a project
+    QFileInfo fi = fileName;
+    CGenericProject* measInstance = createProject(measure, fi.baseName());
+    if (!measInstance)
+        return;
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    result = measInstance->importCsv(table);
+    QApplication::restoreOverrideCursor();
+
+    ui->tbMain->setCurrentWidget(measInstance);
+    if (result)
+        qWarning() << "Import of" << fileName << "failed";
+}
+
+void MainWindow::on_action_Compare_triggered()
+{
+    // works on exported files, no project or connection needed
+    if (!mp_compareDialog)
+        mp_compareDialog = new CCompareDialog(this);
+
+    mp_compareDialog->show();
+    mp_compareDialog->raise();
+    mp_compareDialog->activateWindow();
+}
+
+void MainWindow::on_action_Batch_analysis_triggered()
+{
+    if (!mp_batchDialog)
+        mp_batchDialog = new CBatchDialog(this);
+
+    mp_batchDialog->show();
+    mp_batchDialog->raise();
+    mp_batchDialog->activateWindow();
+}
+
 void MainWindow::on_action_Points_labels_triggered()
 {
     if(!(int)currentMeasObject(ui->tbMain->currentIndex())->measureType())
@@ -542,6 +836,17 @@ void MainWindow::on_action_Points_labels_triggered()
     currentMeasObject(ui->tbMain->currentIndex())->toggleLabels();
 }
 
+void MainWindow::on_action_Diagnostics_triggered()
+{
+    // non modal, stays open next to the measure
+    if (!mp_diagnosticsDialog)
+        mp_diagnosticsDialog = new CDiagnosticsDialog(this);
+
+    mp_diagnosticsDialog->show();
+    mp_diagnosticsDialog->raise();
+    mp_diagnosticsDialog->activateWindow();
+}
+
 void MainWindow::on_action_About_triggered()
 {
     QString filePatch = QApplication::applicationDirPath() + "/changelog.txt";
@@ -568,12 +873,7 @@ void MainWindow::checkCurrentTab(int index)
     // check if any tab is opened, otherwise no tabs left to select
     if (index >= 0)
     {
-        // disconnect all
-        for (int i = 0; i < ui->tbMain->count(); i++)
-            currentMeasObject(i)->changeConnections(false);
-
-        // and connect the current one
-        currentMeasObject(index)->changeConnections(true);
+        routeConnections();
 
         // for action buttons
         enableVar = true;
@@ -587,6 +887,49 @@ void MainWindow::checkCurrentTab(int index)
     ui->action_Save_as->setEnabled(enableVar);
 }
 
+void MainWindow::routeConnections()
+{
+    // the running measurement keeps the serial stream regardless of the
+    // visible tab, otherwise the current tab gets it
+    CGenericProject* target = mp_sessionProject;
+    if (!target)
+        target = currentMeasObject(ui->tbMain->currentIndex());
+
+    // disconnect all but the target
+    for (int i = 0; i < ui->tbMain->count(); i++)
+    {
+        CGenericProject* project = currentMeasObject(i);
+
+        if ((project != target) && (int)project->measureType())
+            project->changeConnections(false);
+    }
+
+    // and connect the target one
+    if ((int)target->measureType())
+        target->changeConnections(true);
+}
+
+void MainWindow::setSessionProject(CGenericProject* project)
+{
+    if (mp_sessionProject == project)
+        return;
+
+    if (mp_sessionProject)
+        mp_sessionProject->setSampleStreaming(false);
+
+    mp_sessionProject = project;
+    routeConnections();
+
+    // measure chunks of the session go through its lock-free queue
+    if (mp_sessionProject)
+    {
+        mp_sessionProject->setSampleStreaming(true);
+        emit setSampleSink(mp_sessionProject->sampleQueue());
+    }
+    else
+        emit setSampleSink(QSharedPointer<CSampleQueue>());
+}
+
 void MainWindow::on_action_Save_triggered()
 {
     qDebug() << "Save pressed.";
@@ -642,7 +985,7 @@ void MainWindow::on_action_Save_as_triggered()
     }
 }
 
-void MainWindow::openProject(const QString& fileName)
+CGenericProject* MainWindow::openProject(const QString& fileName)
 {
     // get measure type from the file
     QFile file(fileName);
@@ -650,19 +993,19 @@ void MainWindow::openProject(const QString& fileName)
     if(!file.exists())
     {
         qWarning() << "File " + fileName + " doesnt exist";
-        return;
+        return NULL;
     }
 
     if (fileName.isEmpty())
     {
         qWarning() << "File " + fileName + " is empty";
-        return;
+        return NULL;
     }
 
     if (!file.open(QFile::ReadOnly | QFile::Text))
     {
         qWarning() << "Cannot open " + fileName;
-        return;
+        return NULL;
     }
 
     QXmlStreamReader xr(&file);
@@ -674,48 +1017,14 @@ void MainWindow::openProject(const QString& fileName)
             {
                 if (xr.name().toString() == "measType")
                 {
-                    EMeasures_t* newMeasure = new EMeasures_t;
-                    CGenericProject* measInstance = NULL;
-                    *newMeasure = (EMeasures_t)xr.readElementText().toInt();
-
-                    switch (*newMeasure)
-                    {
-                        case EMeasures_t::eEIS:
-                        {
-                            measInstance = new CEisProject(mp_serialThread);
-                            break;
-                        }
-
-                        case EMeasures_t::eCV:
-                        {
-                            measInstance = new CCvProject(mp_serialThread);
-                            break;
-                        }
-
-                        case EMeasures_t::eCA:
-                        {
-                            measInstance = new CCaProject(mp_serialThread);
-                            break;
-                        }
-
-                        case EMeasures_t::eDPV:
-                        {
-                            measInstance = new CDpvProject(mp_serialThread);
-                            break;
-                        }
-
-                        default:
-                        {
-                            qWarning() << "Choosen unknown measure method, forgot to add?";
-                        }
-                    }
-
-                    delete newMeasure;
+                    EMeasures_t measure = (EMeasures_t)xr.readElementText().toInt();
                     file.close();
 
-                    // update tab
                     QFileInfo fi = fileName;
-                    ui->tbMain->addTab(measInstance, fi.baseName());
+                    CGenericProject* measInstance = createProject(measure, fi.baseName());
+                    if (!measInstance)
+                        return NULL;
+
                     measInstance->setWorkingFile(fileName);
 
                     // read the fields
@@ -723,14 +1032,68 @@ void MainWindow::openProject(const QString& fileName)
 
                     // testing:
                     //measInstance->takeMeasure();
-                    return;
+                    return measInstance;
                 }
             }
         }
     }
 
     file.close();
-    return;
+    return NULL;
+}
+
+CGenericProject* MainWindow::createProject(const EMeasures_t& measure, const QString& tabName)
+{
+    CGenericProject* measInstance = NULL;
+
+    switch (measure)
+    {
+        case EMeasures_t::eEIS:
+        {
+            measInstance = new CEisProject(mp_serialThread);
+            break;
+        }
+
+        case EMeasures_t::eCV:
+        {
+            measInstance = new CCvProject(mp_serialThread);
+            break;
+        }
+
+        case EMeasures_t::eCA:
+        {
+            measInstance = new CCaProject(mp_serialThread);
+            break;
+        }
+
+        case EMeasures_t::eDPV:
+        {
+            measInstance = new CDpvProject(mp_serialThread);
+            break;
+        }
+
+        case EMeasures_t::eSWV:
+        {
+            measInstance = new CSwvProject(mp_serialThread);
+            break;
+        }
+
+        default:
+        {
+            qWarning() << "Choosen unknown measure method, forgot to add?";
+            return NULL;
+        }
+    }
+
+    // update tab
+    ui->tbMain->addTab(measInstance, tabName);
+
+    connect(measInstance, SIGNAL(measureStarted()),
+            this, SLOT(at_measureStarted()));
+    connect(measInstance, SIGNAL(measureFinished()),
+            this, SLOT(at_measureFinished()));
+
+    return measInstance;
 }
 
 void MainWindow::on_action_Open_triggered()
@@ -13,12 +13,18 @@
 #include "ccvproject.h"
 #include "ccaproject.h"
 #include "cdpvproject.h"
+#include "cswvproject.h"
 
 #include "csettingsdialog.h"
 #include "cnewprojectdialog.h"
 #include "csettingsmanager.h"
 #include "cserialthread.h"
 #include "caboutdialog.h"
+#include "csequencer.h"
+#include "csequencedialog.h"
+#include "cdiagnosticsdialog.h"
+#include "ccomparedialog.h"
+#include "cbatchdialog.h"
 
 #define APPNAME  "Impedance Manager "
 
@@ -40,13 +46,18 @@ public:
 signals:
     void closeSerialThread();
     void send_getFirmwareID();
+    void setSampleSink(const QSharedPointer<CSampleQueue>&);
+    void stageMeasure(const QSharedPointer<CSampleQueue>&);
+    void clearStagedMeasure();
 
 private slots:
     void at_mp_SerialThread_openPort(const int&);
     void at_mp_SerialThread_rxTimeout(const int&);
+    void at_mp_SerialThread_portLost();
     void at_received_getFirmwareID(const MeasureUtility::union32_t&);
     void at_measureStarted();
     void at_measureFinished();
+    void at_received_takeMeasStaged(const bool& ack);
 
     void on_action_Settings_triggered();
     void on_action_New_triggered();
@@ -57,6 +68,8 @@ private slots:
 
     void on_action_Start_measure_triggered();
 
+    void on_action_Run_sequence_triggered();
+
     void on_action_Zoom_out_triggered();
 
     void on_action_Zoom_in_triggered();
@@ -65,8 +78,16 @@ private slots:
 
     void on_action_Export_CSV_triggered();
 
+    void on_action_Import_CSV_triggered();
+
+    void on_action_Compare_triggered();
+
+    void on_action_Batch_analysis_triggered();
+
     void on_action_Points_labels_triggered();
 
+    void on_action_Diagnostics_triggered();
+
     void on_action_About_triggered();
 
     void on_action_Save_triggered();
@@ -80,13 +101,19 @@ private:
     const QString getNameForSave();
     const QString getNameForOpen();
     int saveProject(const QString& fileName);
-    void openProject(const QString& fileName);
+    CGenericProject* openProject(const QString& fileName);
+    CGenericProject* createProject(const EMeasures_t& measure, const QString& tabName);
     QString getAppVersion();
     void initComponents();
     CGenericProject* currentMeasObject(const int& index);
     void setMachineState(EMachineState_t state);
     EMachineState_t& machineState();
     void checkCurrentTab(int index);
+    void routeConnections();
+    void setSessionProject(CGenericProject* project);
+    CGenericProject* openSequenceRun(const CSequencer::Run_t& run);
+    void stageSequenceRun();
+    void stopSequence();
 
     Ui::MainWindow *ui;
 
@@ -100,6 +127,12 @@ private:
 
     CSerialThread* mp_serialThread;
     CGenericProject* mp_dummyProject;
+    CGenericProject* mp_sessionProject; // project owning the running measurement
+    CGenericProject* mp_stagedProject;  // next sequence run, request staged
+    CSequencer m_sequencer;
+    CDiagnosticsDialog* mp_diagnosticsDialog;
+    CCompareDialog* mp_compareDialog;
+    CBatchDialog* mp_batchDialog;
 };
 
 #endif // MAINWINDOW_H